@@ -0,0 +1,130 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Station and time bucket aggregation over columnar batches
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    class Batch;
+
+    /**
+     * @class Aggregate
+     * @brief Groups the reports of a Batch by station and time bucket and
+     *        computes the minimum, maximum, mean and count of numeric fields.
+     *
+     * The batch is split into contiguous ranges that are aggregated by
+     * separate threads into thread-local tables, which are merged once all
+     * threads have finished. Archived reports are aggregated by appending
+     * their Records to a Batch.
+     *
+     * The class is non-instantiable and contains only static methods.
+     */
+    class Aggregate
+    {
+    public:
+      /**
+       * @enum bucket
+       * @brief Time bucket sizes (UTC).
+       */
+      enum class bucket
+      {
+        HOUR,
+        DAY,
+        MONTH
+      };
+
+      /**
+       * @enum field
+       * @brief The aggregated fields and their units.
+       */
+      enum class field
+      {
+        TEMPERATURE,        // degrees Celsius
+        DEW_POINT,          // degrees Celsius
+        WIND_SPEED,         // knots
+        SEA_LEVEL_PRESSURE, // hPa
+        ALTIMETER           // hPa
+      };
+
+      static constexpr size_t NUM_FIELDS =
+        static_cast<size_t>(field::ALTIMETER) + 1;
+
+      /**
+       * @struct Stats
+       * @brief Statistics of one field within a group.
+       */
+      struct Stats
+      {
+        uint64_t count = 0;  // number of reports with the field
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+        double sum = 0.0;
+
+        /**
+         * @brief Retrieves the mean of the field.
+         *
+         * @return The mean, NaN if count is 0.
+         */
+        double Mean() const
+        {
+          return count ? sum / count
+                       : std::numeric_limits<double>::quiet_NaN();
+        }
+      };
+
+      /**
+       * @struct Group
+       * @brief The statistics of the reports of a station in a time bucket.
+       */
+      struct Group
+      {
+        uint32_t icao;       // see Record::PackICAO
+        int64_t start;       // start of the bucket, seconds since the epoch
+        uint64_t reports;    // number of reports in the group
+        Stats stats[NUM_FIELDS];
+
+        const Stats& operator[](field f) const
+        {
+          return stats[static_cast<size_t>(f)];
+        }
+      };
+
+      Aggregate() = delete;
+
+      /**
+       * @brief Aggregates a batch.
+       *
+       * Reports without a station or an observation time are skipped. The
+       * share of a thread that cannot be started runs on the calling thread.
+       * An exception thrown while aggregating is rethrown once every thread
+       * has finished.
+       *
+       * @param batch The batch.
+       * @param b The time bucket size.
+       * @param groups Receives the groups, ordered by station and time.
+       * @param threads The number of threads; 0 for one per hardware thread.
+       */
+      static void GroupBy(const Batch& batch, bucket b,
+                          std::vector<Group>& groups, unsigned int threads = 0);
+
+      /**
+       * @brief Retrieves the start of the bucket containing a time.
+       *
+       * @param t The time, seconds since the epoch.
+       * @param b The time bucket size.
+       * @return The start of the bucket, seconds since the epoch.
+       */
+      static int64_t BucketStart(int64_t t, bucket b);
+    };
+  }
+}
@@ -0,0 +1,350 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Incremental evaluation of alert rules
+//
+
+#pragma once
+
+#include "Filter.h"
+#include "Phenom.h"
+#include "Record.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class AlertEngine
+     * @brief Evaluates alert rules against a stream of reports and reports
+     *        when each rule starts or stops matching at a station.
+     *
+     * A rule applies to a list of stations, or to every station, and matches
+     * a report if all of its conditions hold. Conditions compare a field in
+     * the units of Filter::field, or test for a weather phenomenon; as with
+     * Filter, a missing value never matches.
+     *
+     * Rules are indexed by station and by the Record fields their conditions
+     * read. The engine keeps the last report of every station; a new report
+     * is compared with it (see RecordDiff) and only the rules of that station
+     * that read a changed field are evaluated. The engine remembers which
+     * rules match at which station and emits an event only when that
+     * changes. Reports that do not supersede the station's last report (see
+     * LatestCache::Supersedes()) are ignored.
+     *
+     * Not thread safe; use one instance per stream.
+     *
+     * Example, low ceiling at KBOS, and heavy thunderstorm rain in a region:
+     * @code
+     *   AlertEngine engine;
+     *   engine.Add({ Record::PackICAO("KBOS") },
+     *              { AlertEngine::Condition::Compare(Filter::field::CEILING,
+     *                                                Filter::op::LT, 500) });
+     *   engine.Add(region,
+     *              { AlertEngine::Condition::Weather(Phenom::phenom::RAIN,
+     *                    Phenom::intensity::HEAVY,
+     *                    Record::Phenomenon::THUNDERSTORM) });
+     * @endcode
+     */
+    class AlertEngine
+    {
+    public:
+      /**
+       * @class Condition
+       * @brief A predicate over a single report.
+       */
+      class Condition
+      {
+      public:
+        /**
+         * @brief Creates a condition comparing a field against a constant.
+         *
+         * @param f The field.
+         * @param o The operator; the field is the left operand.
+         * @param value The constant, in the units of the field.
+         * @return The condition.
+         */
+        static Condition Compare(Filter::field f, Filter::op o, double value);
+
+        /**
+         * @brief Creates a condition matching reports with a weather
+         *        phenomenon.
+         *
+         * @param p The phenomenon.
+         * @param min_intensity The least intensity of the phenomenon group.
+         * @param attributes Record::Phenomenon::attribute bits the
+         *                   phenomenon group must have, e.g., THUNDERSTORM.
+         * @return The condition.
+         */
+        static Condition Weather(Phenom::phenom p,
+                                 Phenom::intensity min_intensity
+                                   = Phenom::intensity::LIGHT,
+                                 uint16_t attributes = 0);
+
+        /**
+         * @brief Evaluates the condition.
+         *
+         * @param record The report.
+         * @return True if the report matches.
+         */
+        bool Matches(const Record& record) const;
+
+        /**
+         * @brief Retrieves the RecordDiff change bits of the fields the
+         *        condition reads.
+         *
+         * @return The change bits.
+         */
+        uint32_t Fields() const;
+
+      private:
+        Condition() = default;
+
+        bool _weather = false;
+        Filter::field _field = Filter::field::VISIBILITY;
+        Filter::op _op = Filter::op::EQ;
+        double _t[3] = {};    // threshold in each unit of the field
+        uint8_t _phenom = 0;
+        int8_t _intensity = 0;
+        uint16_t _attributes = 0;
+      };
+
+      /**
+       * @class Predicate
+       * @brief A rule expression compiled to bytecode.
+       *
+       * An expression combines comparisons and present weather tests with
+       * and, or, not and parentheses, e.g.:
+       * @code
+       *   ceiling < 500 or (gust >= 35 and temperature < 0) or +TSRA
+       * @endcode
+       * Comparisons name a field, an operator (<, <=, >, >=, ==, !=) and a
+       * number in the units of the corresponding Filter::field: visibility,
+       * ceiling, wind, gust, temperature, dew_point, slp and category (which
+       * also accepts VFR, MVFR, IFR and LIFR). A weather test is a present
+       * weather group as it appears in a report, such as FZRA or +TSRA, and
+       * matches a reported group with at least its descriptors and
+       * phenomena; a leading + requires heavy and a leading - light
+       * intensity, as in a report, and without a sign any intensity matches.
+       * A group with letters that are not a known descriptor or phenomenon
+       * is invalid, so that misspelled rules are rejected. Names and keywords
+       * are case insensitive.
+       *
+       * The expression is parsed once. Each comparison is compiled into an
+       * instruction holding the offset, width and presence bits of the Record
+       * member it reads and its thresholds in every unit, so evaluation is a
+       * single pass over the instructions with a small stack of results.
+       */
+      class Predicate
+      {
+      public:
+        /**
+         * @brief Compiles an expression.
+         *
+         * @param expr The expression.
+         * @return The predicate, or a null pointer if the expression is not
+         *         valid.
+         */
+        static std::shared_ptr<Predicate> Create(const char *expr);
+
+        /**
+         * @brief Evaluates the predicate.
+         *
+         * @param record The report.
+         * @return True if the report matches.
+         */
+        bool Matches(const Record& record) const;
+
+        /**
+         * @brief Retrieves the RecordDiff change bits of the fields the
+         *        predicate reads.
+         *
+         * @return The change bits.
+         */
+        uint32_t Fields() const { return _fields; }
+
+        /**
+         * @brief Retrieves the number of instructions.
+         *
+         * @return The number of instructions.
+         */
+        size_t Size() const { return _code.size(); }
+
+        /**
+         * @brief Maximum nesting of an expression.
+         */
+        static constexpr unsigned int MAX_DEPTH = 32;
+
+      private:
+        enum class opcode : uint8_t
+        {
+          COMPARE, WEATHER, AND, OR, NOT
+        };
+
+        // the load of a Record member
+        struct Load
+        {
+          uint16_t offset;
+          uint8_t size;        // bytes, 0 if unused
+          bool is_signed;
+          uint32_t present;    // presence bits required
+          double scale;
+        };
+
+        struct Instruction
+        {
+          opcode code;
+          Filter::op cmp;
+          Load value;
+          Load fallback;       // read if value is absent, size 0 if none
+          int16_t units;       // offset of the units member, -1 if none
+          uint8_t flag;        // Record::flag that replaces the value
+          double flag_value;   // the value and unit it stands for
+          uint8_t flag_unit;
+          double t[3];         // threshold in each unit
+
+          uint16_t attributes; // WEATHER
+          int8_t intensity;    // least and greatest intensity
+          int8_t max_intensity;
+          uint8_t phenom[Record::MAX_PHENOM];
+        };
+
+        struct Compiler;
+
+        Predicate() = default;
+
+        std::vector<Instruction> _code;
+        uint32_t _fields = 0;
+      };
+
+      /**
+       * @struct Event
+       * @brief A rule started or stopped matching at a station.
+       */
+      struct Event
+      {
+        uint32_t rule;
+        uint32_t icao;    // Record::PackICAO
+        bool active;      // true when the rule fires, false when it clears
+      };
+
+      AlertEngine() = default;
+
+      AlertEngine(const AlertEngine&) = delete;
+      AlertEngine& operator=(const AlertEngine&) = delete;
+
+      /**
+       * @brief Adds a rule.
+       *
+       * The rule is evaluated against the last report of every station it
+       * applies to, to set its initial state; no events are emitted for that
+       * (see Active()).
+       *
+       * @param stations The packed identifiers of the stations the rule
+       *                 applies to, or empty for every station.
+       * @param conditions The conditions, all of which must hold. Must not be
+       *                   empty.
+       * @return The rule identifier.
+       */
+      uint32_t Add(const std::vector<uint32_t>& stations,
+                   const std::vector<Condition>& conditions);
+
+      /**
+       * @brief Adds a rule given by a compiled expression.
+       *
+       * As Add(const std::vector<uint32_t>&, const std::vector<Condition>&).
+       *
+       * @param stations The packed identifiers of the stations the rule
+       *                 applies to, or empty for every station.
+       * @param predicate The expression. Must not be null.
+       * @return The rule identifier.
+       */
+      uint32_t Add(const std::vector<uint32_t>& stations,
+                   std::shared_ptr<const Predicate> predicate);
+
+      /**
+       * @brief Removes a rule. No events are emitted for it.
+       *
+       * @param rule The rule identifier.
+       * @return False if there is no such rule.
+       */
+      bool Remove(uint32_t rule);
+
+      /**
+       * @brief Evaluates a report.
+       *
+       * @param record The report; its icao field selects the station.
+       * @param events The rules that fired or cleared are appended to this
+       *               vector, in no particular order.
+       */
+      void Evaluate(const Record& record, std::vector<Event>& events);
+
+      /**
+       * @brief Determines whether a rule currently matches at a station.
+       *
+       * @param rule The rule identifier.
+       * @param icao The packed station identifier.
+       * @return True if the rule matches the station's last report.
+       */
+      bool Active(uint32_t rule, uint32_t icao) const;
+
+      /**
+       * @brief Retrieves the number of rules.
+       *
+       * @return The number of rules.
+       */
+      size_t NumRules() const { return _num_rules; }
+
+      /**
+       * @brief Retrieves the number of rule evaluations made by Evaluate().
+       *
+       * @return The number of evaluations.
+       */
+      uint64_t Evaluations() const { return _evaluations; }
+
+    private:
+      struct Rule
+      {
+        std::vector<uint32_t> stations;
+        std::vector<Condition> conditions;
+        std::shared_ptr<const Predicate> predicate;
+        uint32_t fields = 0;
+        bool removed = false;
+        uint64_t stamp = 0;
+      };
+
+      static uint64_t key(uint32_t icao, unsigned int bit)
+      {
+        return (static_cast<uint64_t>(icao) << 5) | bit;
+      }
+
+      static uint64_t state(uint32_t rule, uint32_t icao)
+      {
+        return (static_cast<uint64_t>(rule) << 32) | icao;
+      }
+
+      uint32_t add(Rule rule);
+      bool matches(const Rule& rule, const Record& record) const;
+
+      std::vector<Rule> _rules;
+      size_t _num_rules = 0;
+
+      // rules by station (0 for every station) and field bit
+      std::unordered_map<uint64_t, std::vector<uint32_t>> _index;
+
+      // rules matching at a station
+      std::unordered_set<uint64_t> _active;
+
+      std::unordered_map<uint32_t, Record> _last;
+      uint64_t _epoch = 0;
+      uint64_t _evaluations = 0;
+    };
+  }
+}
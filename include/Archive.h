@@ -0,0 +1,282 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Columnar archive of decoded METAR records
+//
+
+#pragma once
+
+#include "Record.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class Archive
+     * @brief Definitions shared by ArchiveWriter and ArchiveReader.
+     *
+     * An archive stores Records in row groups. Within a row group each field
+     * is stored as a separate column chunk, so a reader fetches only the
+     * columns it needs. Cloud layers and phenomena are stored as flattened
+     * columns whose lengths are given by the NUM_LAYERS and NUM_PHENOMENA
+     * columns.
+     *
+     * Every column chunk is encoded with whichever encoding gives the
+     * smallest result: bit-packed offsets from the chunk minimum, bit-packed
+     * deltas (suited to slowly changing values such as times, temperatures
+     * and pressures), a dictionary with bit-packed indices, or run-length
+     * encoding (suited to units, cloud cover and other enumerations). Each
+     * chunk carries the minimum and maximum of its values for query pruning.
+     * Writing the records ordered by station and time gives the longest runs
+     * and the smallest deltas.
+     *
+     * Layout: the MAGIC bytes and format VERSION, the column chunks of every
+     * row group, a footer describing the row groups and chunks, and finally
+     * the footer offset and the MAGIC bytes again. Integers are
+     * little-endian.
+     *
+     * The class is non-instantiable.
+     */
+    class Archive
+    {
+    public:
+      /**
+       * @brief Version of the archive format.
+       */
+      static constexpr uint16_t VERSION = 1;
+
+      /**
+       * @brief Identifies an archive.
+       */
+      static constexpr char MAGIC[4] = { 'M', 'T', 'R', 'A' };
+
+      /**
+       * @enum column
+       * @brief The columns of an archive, one for each field of Record.
+       */
+      enum class column : uint8_t
+      {
+        ICAO, PRESENT, OBSERVATION_TIME,
+        VISIBILITY, CEILING, VERTICAL_VIS,
+        WIND_DIRECTION, WIND_SPEED, WIND_GUST,
+        MIN_WIND_DIRECTION, MAX_WIND_DIRECTION,
+        TEMPERATURE_NA, DEW_POINT_NA,
+        ALTIMETER_A, ALTIMETER_Q, SEA_LEVEL_PRESSURE,
+        TEMPERATURE, DEW_POINT,
+        DAY, HOUR, MINUTE,
+        MESSAGE_TYPE, WIND_UNITS, VISIBILITY_UNITS, FLIGHT_CATEGORY, FLAGS,
+        NUM_LAYERS, NUM_PHENOMENA,
+        // one value per layer or phenomenon group
+        LAYER_ALTITUDE, LAYER_COVER, LAYER_TYPE, LAYER_TEMPO,
+        PHENOMENON_ATTRIBUTES, PHENOMENON_INTENSITY,
+        // Record::MAX_PHENOM values per phenomenon group
+        PHENOMENON_CODES
+      };
+
+      static constexpr size_t NUM_COLUMNS =
+        static_cast<size_t>(column::PHENOMENON_CODES) + 1;
+
+      /**
+       * @enum encoding
+       * @brief Encodings of a column chunk.
+       */
+      enum class encoding : uint8_t
+      {
+        BIT_PACKED,  // offsets from the minimum, bit-packed
+        DELTA,       // deltas, as offsets from the minimum delta, bit-packed
+        DICTIONARY,  // dictionary of distinct values, bit-packed indices
+        RLE          // runs of equal values
+      };
+
+      /**
+       * @struct Statistics
+       * @brief Statistics of a column chunk.
+       *
+       * Values of fields whose presence bit is clear are excluded.
+       */
+      struct Statistics
+      {
+        int64_t min;
+        int64_t max;
+        uint64_t count;  // number of values present
+      };
+
+      /**
+       * @struct Chunk
+       * @brief Location, encoding and statistics of a column chunk.
+       */
+      struct Chunk
+      {
+        uint64_t offset;
+        uint64_t size;
+        encoding enc;
+        Statistics stats;
+      };
+
+      Archive() = delete;
+    };
+
+    /**
+     * @class ArchiveWriter
+     * @brief Writes Records to an archive.
+     */
+    class ArchiveWriter
+    {
+    public:
+      /**
+       * @brief Starts an archive.
+       *
+       * @param os The stream, opened in binary mode. Must outlive the writer.
+       * @param row_group_size The number of records per row group.
+       */
+      explicit ArchiveWriter(std::ostream& os, size_t row_group_size = 65536);
+
+      /**
+       * @brief Completes the archive if Close() was not called.
+       */
+      ~ArchiveWriter();
+
+      ArchiveWriter(const ArchiveWriter&) = delete;
+      ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+      /**
+       * @brief Adds a record to the archive.
+       *
+       * @param record The record.
+       * @return False if the stream failed or the archive is closed.
+       */
+      bool Append(const Record& record);
+
+      /**
+       * @brief Writes the last row group and the footer.
+       *
+       * @return True if the archive was written completely.
+       */
+      bool Close();
+
+    private:
+      bool flush();
+
+      std::ostream& _os;
+      const size_t _row_group_size;
+      uint64_t _offset;
+      bool _closed;
+
+      std::vector<Record> _rows;
+      std::vector<uint64_t> _group_rows;
+      std::vector<Archive::Chunk> _chunks;
+    };
+
+    /**
+     * @class ArchiveReader
+     * @brief Reads Records and individual columns from an archive.
+     *
+     * Only the footer is read when the archive is opened. Column chunks are
+     * read on demand, so reading some of the columns only reads their bytes.
+     */
+    class ArchiveReader
+    {
+    public:
+      /**
+       * @brief Opens an archive.
+       *
+       * @param is The stream, opened in binary mode and seekable. Must outlive
+       *           the reader.
+       * @return The reader, or a null pointer if the stream does not hold an
+       *         archive of this version.
+       */
+      static std::shared_ptr<ArchiveReader> Create(std::istream& is);
+
+      ArchiveReader(const ArchiveReader&) = delete;
+      ArchiveReader& operator=(const ArchiveReader&) = delete;
+
+      /**
+       * @brief Retrieves the number of row groups.
+       *
+       * @return The number of row groups.
+       */
+      size_t NumRowGroups() const { return _group_rows.size(); }
+
+      /**
+       * @brief Retrieves the number of records in a row group.
+       *
+       * @param group The row group index.
+       * @return The number of records.
+       */
+      uint64_t NumRows(size_t group) const { return _group_rows[group]; }
+
+      /**
+       * @brief Retrieves the total number of records.
+       *
+       * @return The number of records.
+       */
+      uint64_t NumRows() const;
+
+      /**
+       * @brief Retrieves the statistics of a column chunk.
+       *
+       * @param group The row group index.
+       * @param c The column.
+       * @return The statistics.
+       */
+      const Archive::Statistics& Statistics(size_t group,
+                                            Archive::column c) const;
+
+      /**
+       * @brief Retrieves the encoding chosen for a column chunk.
+       *
+       * @param group The row group index.
+       * @param c The column.
+       * @return The encoding.
+       */
+      Archive::encoding Encoding(size_t group, Archive::column c) const;
+
+      /**
+       * @brief Reads a column chunk.
+       *
+       * Values of absent fields are 0.
+       *
+       * @param group The row group index.
+       * @param c The column.
+       * @param values Receives the values. Cleared first.
+       * @return False if the chunk could not be read or is corrupt.
+       */
+      bool ReadColumn(size_t group, Archive::column c,
+                      std::vector<int64_t>& values);
+
+      /**
+       * @brief Reads the records of a row group.
+       *
+       * @param group The row group index.
+       * @param records The records are appended to this vector.
+       * @return False if the row group could not be read or is corrupt.
+       */
+      bool ReadRecords(size_t group, std::vector<Record>& records);
+
+      /**
+       * @brief Retrieves the number of column chunk bytes read so far.
+       *
+       * @return The number of bytes.
+       */
+      uint64_t BytesRead() const { return _bytes_read; }
+
+    private:
+      explicit ArchiveReader(std::istream& is) : _is(is) {}
+
+      const Archive::Chunk& chunk(size_t group, Archive::column c) const;
+
+      std::istream& _is;
+      uint64_t _bytes_read = 0;
+      std::vector<uint64_t> _group_rows;
+      std::vector<Archive::Chunk> _chunks;
+    };
+  }
+}
@@ -0,0 +1,194 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Columnar batch of decoded METAR reports
+//
+
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    class Metar;
+    struct Record;
+
+    /**
+     * @class Batch
+     * @brief A column-oriented (structure of arrays) collection of decoded
+     *        METAR reports.
+     *
+     * Each decoded field is kept in its own contiguous column so that kernels
+     * can process many reports in a single branch-free pass. Numeric columns
+     * hold the exact fixed-point values provided by the Metar scaled accessors.
+     * Missing values are represented by the NONE sentinels, which act as the
+     * validity mask of every column.
+     */
+    class Batch
+    {
+    public:
+      /**
+       * @brief Sentinel marking a missing value in an integer column.
+       */
+      static constexpr int32_t NONE = INT32_MIN;
+
+      /**
+       * @brief Sentinel marking a missing value in the observation time column.
+       */
+      static constexpr int64_t NONE64 = INT64_MIN;
+
+      /**
+       * @brief Sentinel marking a missing value in an enumeration column.
+       */
+      static constexpr uint8_t NONE8 = UINT8_MAX;
+
+      /**
+       * @brief Visibility stored for CAVOK reports, in meters.
+       */
+      static constexpr int32_t CAVOK_VISIBILITY = 10000;
+
+      /**
+       * @brief Offset of the freezing phenomena bits in the weather column.
+       */
+      static constexpr unsigned int FREEZING_WEATHER = 32;
+
+      Batch() = default;
+
+      /**
+       * @brief Appends a decoded report to the batch.
+       *
+       * @param metar The decoded report.
+       */
+      void Append(const Metar& metar);
+
+      /**
+       * @brief Appends a decoded record to the batch, e.g., one read from a
+       *        record file or an archive.
+       *
+       * @param record The record.
+       */
+      void Append(const Record& record);
+
+      /**
+       * @brief Reserves storage for the given number of reports.
+       *
+       * @param n The number of reports.
+       */
+      void Reserve(size_t n);
+
+      /**
+       * @brief Removes all reports from the batch.
+       */
+      void Clear();
+
+      /**
+       * @brief Retrieves the number of reports in the batch.
+       *
+       * @return The number of reports.
+       */
+      size_t Size() const { return _wind_dir.size(); }
+
+      /// Station, see Record::PackICAO; 0 if not reported.
+      std::span<const uint32_t> Station() const { return _icao; }
+
+      /// Observation time, seconds since the epoch (see Metar::ObservationTime).
+      std::span<const int64_t> ObservationTime() const { return _obs_time; }
+
+      /// Wind direction in degrees.
+      std::span<const int32_t> WindDirection() const { return _wind_dir; }
+
+      /// Wind speed in WindSpeedUnits.
+      std::span<const int32_t> WindSpeed() const { return _wind_spd; }
+
+      /// Wind gust in WindSpeedUnits.
+      std::span<const int32_t> WindGust() const { return _gust; }
+
+      /// Lower bound of the variable wind direction range in degrees.
+      std::span<const int32_t> MinWindDirection() const { return _min_wind_dir; }
+
+      /// Upper bound of the variable wind direction range in degrees.
+      std::span<const int32_t> MaxWindDirection() const { return _max_wind_dir; }
+
+      /// Metar::speed_units of the wind columns.
+      std::span<const uint8_t> WindSpeedUnits() const { return _wind_units; }
+
+      /// Visibility, see Metar::VisibilityScaled.
+      std::span<const int32_t> Visibility() const { return _vis; }
+
+      /// Metar::distance_units of the visibility column.
+      std::span<const uint8_t> VisibilityUnits() const { return _vis_units; }
+
+      /// Ceiling in feet above ground level.
+      std::span<const int32_t> Ceiling() const { return _ceiling; }
+
+      /// Metar::flight_category computed by the decoder.
+      std::span<const uint8_t> FlightCategory() const { return _category; }
+
+      /// Temperature in tenths of a degree Celsius.
+      std::span<const int32_t> Temperature() const { return _temp; }
+
+      /// Dew point in tenths of a degree Celsius.
+      std::span<const int32_t> DewPoint() const { return _dew; }
+
+      /// A-prefix altimeter setting in hundredths of inHg.
+      std::span<const int32_t> AltimeterA() const { return _altimeterA; }
+
+      /// Q-prefix altimeter setting in hPa.
+      std::span<const int32_t> AltimeterQ() const { return _altimeterQ; }
+
+      /// Sea-level pressure in tenths of hPa.
+      std::span<const int32_t> SeaLevelPressure() const { return _slp; }
+
+      /// Present weather: bit p is set if Phenom::phenom p is reported, and
+      /// also bit FREEZING_WEATHER + p if it is reported with the freezing
+      /// descriptor.
+      std::span<const uint64_t> PresentWeather() const { return _weather; }
+
+      /**
+       * @brief Computes the flight category of every report from ceiling and
+       *        visibility columns.
+       *
+       * This is the column counterpart of Metar::FlightCategory(). The loop
+       * body is branch free so the compiler can vectorize it; missing values
+       * are handled with the NONE sentinels.
+       *
+       * @param ceiling The ceiling column in feet.
+       * @param vis The visibility column (see Metar::VisibilityScaled).
+       * @param vis_units The visibility units column.
+       * @param out Receives the Metar::flight_category of each report, or
+       *            NONE8 if neither ceiling nor visibility is known. Must be
+       *            at least as large as the input columns.
+       */
+      static void FlightCategories(std::span<const int32_t> ceiling,
+                                   std::span<const int32_t> vis,
+                                   std::span<const uint8_t> vis_units,
+                                   std::span<uint8_t> out);
+
+    private:
+      std::vector<uint32_t> _icao;
+      std::vector<int64_t> _obs_time;
+      std::vector<int32_t> _wind_dir;
+      std::vector<int32_t> _wind_spd;
+      std::vector<int32_t> _gust;
+      std::vector<int32_t> _min_wind_dir;
+      std::vector<int32_t> _max_wind_dir;
+      std::vector<uint8_t> _wind_units;
+      std::vector<int32_t> _vis;
+      std::vector<uint8_t> _vis_units;
+      std::vector<int32_t> _ceiling;
+      std::vector<uint8_t> _category;
+      std::vector<int32_t> _temp;
+      std::vector<int32_t> _dew;
+      std::vector<int32_t> _altimeterA;
+      std::vector<int32_t> _altimeterQ;
+      std::vector<int32_t> _slp;
+      std::vector<uint64_t> _weather;
+    };
+  }
+}
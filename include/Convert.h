@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <span>
+
 namespace Storage_B 
 {
   namespace Weather
@@ -208,6 +211,52 @@ namespace Storage_B
 	  		return v * miles2Km;
 	    }
 
+		/**
+		 * @brief Normalizes a column of wind speeds to knots.
+		 *
+		 * The unit column selects the conversion of each element, so reports in
+		 * mixed units are converted in a single branch-free SIMD pass.
+		 *
+		 * @param speed The wind speeds, missing values are INT32_MIN.
+		 * @param units The Metar::speed_units of each speed, missing units are
+		 *              UINT8_MAX.
+		 * @param out Receives the speeds in knots, NaN where the speed or its
+		 *            units are missing. Must be at least as large as speed.
+		 */
+		static void SpeedsToKnots(std::span<const int32_t> speed,
+		                          std::span<const uint8_t> units,
+		                          std::span<double> out);
+
+		/**
+		 * @brief Normalizes a column of visibilities to meters.
+		 *
+		 * @param vis The fixed-point visibilities (see Metar::VisibilityScaled),
+		 *            missing values are INT32_MIN.
+		 * @param units The Metar::distance_units of each visibility, missing
+		 *              units are UINT8_MAX.
+		 * @param out Receives the visibilities in meters, NaN where missing.
+		 *            Must be at least as large as vis.
+		 */
+		static void VisibilitiesToMeters(std::span<const int32_t> vis,
+		                                 std::span<const uint8_t> units,
+		                                 std::span<double> out);
+
+		/**
+		 * @brief Normalizes columns of A and Q altimeter settings to millibars.
+		 *
+		 * The Q setting is used when present, otherwise the A setting is
+		 * converted from hundredths of inches of mercury.
+		 *
+		 * @param altA A-prefix settings in hundredths of inHg, missing values
+		 *             are INT32_MIN.
+		 * @param altQ Q-prefix settings in hPa, missing values are INT32_MIN.
+		 * @param out Receives the altimeter settings in millibars, NaN where
+		 *            both are missing. Must be at least as large as altA.
+		 */
+		static void AltimetersToMb(std::span<const int32_t> altA,
+		                           std::span<const int32_t> altQ,
+		                           std::span<double> out);
+
 	  	Convert() = delete;
         Convert(const Convert&) = delete;
 	  	Convert(Convert&&) = delete;
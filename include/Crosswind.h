@@ -0,0 +1,63 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Runway wind components
+//
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    class Batch;
+
+    /**
+     * @class Crosswind
+     * @brief Computes worst-case crosswind and headwind components for sets of
+     *        runways over a batch of decoded reports.
+     *
+     * The wind speed used is the gust when reported, otherwise the sustained
+     * speed, normalized to knots. When the report gives a variable direction
+     * range (e.g., 060V120) every direction in the range is considered and the
+     * most unfavorable component is returned. Variable winds without a
+     * direction (VRB) are assumed to come from any direction, giving a
+     * crosswind equal to the speed and a tailwind equal to the speed.
+     *
+     * The class is non-instantiable and contains only static methods.
+     */
+    class Crosswind
+    {
+    public:
+      /**
+       * @brief Computes the worst-case wind components of every runway for
+       *        every report of a batch.
+       *
+       * Reports are processed several at a time with vectorized trigonometry
+       * and without per-report branching.
+       *
+       * @param headings The runway headings in degrees, in the same reference
+       *                 (true or magnetic) as the reported wind direction.
+       * @param batch The decoded reports.
+       * @param crosswind Receives the crosswind magnitude in knots, row-major by
+       *                  runway: element [r * batch.Size() + i] is runway r and
+       *                  report i. NaN where the wind is missing. Must hold
+       *                  headings.size() * batch.Size() elements.
+       * @param headwind Receives the headwind component in knots, negative for
+       *                 a tailwind, with the same layout as crosswind.
+       */
+      static void Components(std::span<const int32_t> headings,
+                             const Batch& batch,
+                             std::span<double> crosswind,
+                             std::span<double> headwind);
+
+      Crosswind() = delete;
+      Crosswind(const Crosswind&) = delete;
+      Crosswind& operator=(const Crosswind&) = delete;
+      ~Crosswind() = default;
+    };
+  }
+}
@@ -0,0 +1,153 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Cache of decoded reports keyed by their text
+//
+
+#pragma once
+
+#include "Record.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class DecodeCache
+     * @brief A bounded, concurrent cache of decoded reports.
+     *
+     * Feeds often deliver the same report text many times. The cache keys
+     * decoded records by a hash of the report text and keeps the text itself,
+     * so a hash collision is detected and treated as a miss. A hit returns the
+     * cached record without parsing the report again.
+     *
+     * Reports are spread over shards by their hash and each shard has its own
+     * lock. When a shard is full the least recently used report is
+     * approximated with the CLOCK algorithm: every hit marks its entry and
+     * eviction passes over marked entries once, clearing the mark.
+     *
+     * Records are cached without an observation time. The observation time
+     * depends on the reference time of each Decode() call and is resolved from
+     * the cached day, hour and minute, exactly as Metar does.
+     */
+    class DecodeCache
+    {
+    public:
+      /**
+       * @struct Counters
+       * @brief Cache statistics.
+       */
+      struct Counters
+      {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+
+        /**
+         * @brief Retrieves the fraction of lookups that were hits.
+         *
+         * @return The hit rate, 0 if there were no lookups.
+         */
+        double HitRate() const
+        {
+          uint64_t n = hits + misses;
+          return n > 0 ? static_cast<double>(hits) / n : 0.0;
+        }
+      };
+
+      /**
+       * @brief Constructs an empty cache.
+       *
+       * @param capacity The maximum number of reports held. Split evenly over
+       *                 the shards.
+       * @param shards The number of shards.
+       */
+      explicit DecodeCache(size_t capacity, size_t shards = 16);
+
+      ~DecodeCache() = default;
+
+      DecodeCache(const DecodeCache&) = delete;
+      DecodeCache& operator=(const DecodeCache&) = delete;
+
+      /**
+       * @brief Decodes a report, or retrieves it from the cache.
+       *
+       * Safe to call from any number of threads.
+       *
+       * @param report The report text.
+       * @return The record, see Record::Create() and Metar::Create().
+       */
+      Record Decode(const char *report);
+
+      /**
+       * @brief Decodes a report resolving its observation time, or retrieves
+       *        it from the cache.
+       *
+       * Safe to call from any number of threads.
+       *
+       * @param report The report text.
+       * @param reference The reference time, see Metar::Create().
+       * @return The record.
+       */
+      Record Decode(const char *report, std::time_t reference);
+
+      /**
+       * @brief Retrieves the number of reports in the cache.
+       *
+       * @return The number of reports.
+       */
+      size_t Size() const;
+
+      /**
+       * @brief Retrieves the cache statistics.
+       *
+       * @return The counters accumulated since construction or Clear().
+       */
+      Counters Statistics() const;
+
+      /**
+       * @brief Removes all reports and resets the statistics.
+       */
+      void Clear();
+
+    private:
+      struct Slot
+      {
+        uint64_t hash = 0;
+        std::string text;
+        Record record{};
+        bool used = false;
+        bool referenced = false;
+      };
+
+      struct Shard
+      {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, size_t> index;
+        std::vector<Slot> slots;
+        size_t hand = 0;
+      };
+
+      Record decode(std::string_view report, const std::time_t *reference);
+      size_t victim(Shard& shard);
+
+      std::unique_ptr<Shard[]> _shards;
+      const size_t _num_shards;
+
+      std::atomic<uint64_t> _hits{0};
+      std::atomic<uint64_t> _misses{0};
+      std::atomic<uint64_t> _evictions{0};
+    };
+  }
+}
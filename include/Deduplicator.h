@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Streaming duplicate and correction tracking
+//
+
+#pragma once
+
+#include "Record.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class Deduplicator
+     * @brief Suppresses repeated deliveries of the same observation.
+     *
+     * Each observation is identified by its station and observation time and
+     * remembered together with a fingerprint of its content. A report is
+     * passed on if its observation is new, or if it is a correction (COR)
+     * whose content differs from the last report passed on for that
+     * observation. Identical reports, and reports that differ without being
+     * marked as corrections, are held back.
+     *
+     * Memory is bounded by a time window: observations more than window
+     * seconds older than the newest observation seen are forgotten, and
+     * reports of such observations are held back as stale.
+     *
+     * Records need an observation time (see Metar::Create() with a reference
+     * time). Records without a station or an observation time cannot be
+     * identified and are always passed on.
+     *
+     * Not thread safe; use one instance per stream.
+     */
+    class Deduplicator
+    {
+    public:
+      /**
+       * @enum result
+       * @brief Classification of an offered report.
+       */
+      enum class result
+      {
+        NEW,         // first report of the observation, pass on
+        CORRECTION,  // correction with new content, pass on
+        DUPLICATE,   // same content as a report already passed on
+        CONFLICT,    // different content but not marked as a correction
+        STALE        // older than the window
+      };
+
+      static constexpr size_t NUM_RESULTS =
+        static_cast<size_t>(result::STALE) + 1;
+
+      /**
+       * @brief Constructs an empty deduplicator.
+       *
+       * @param window The number of seconds an observation is remembered,
+       *               measured back from the newest observation time seen.
+       */
+      explicit Deduplicator(int64_t window = 3 * 3600);
+
+      ~Deduplicator() = default;
+
+      Deduplicator(const Deduplicator&) = delete;
+      Deduplicator& operator=(const Deduplicator&) = delete;
+
+      /**
+       * @brief Determines whether a result means the report is passed on.
+       *
+       * @param r The result.
+       * @return True for NEW and CORRECTION.
+       */
+      static bool Emit(result r)
+      {
+        return r == result::NEW || r == result::CORRECTION;
+      }
+
+      /**
+       * @brief Offers a report.
+       *
+       * @param record The report.
+       * @return The classification; see Emit().
+       */
+      result Offer(const Record& record);
+
+      /**
+       * @brief Retrieves the number of observations remembered.
+       *
+       * @return The number of observations.
+       */
+      size_t Size() const { return _seen.size(); }
+
+      /**
+       * @brief Retrieves the number of reports classified as a result.
+       *
+       * @param r The result.
+       * @return The number of reports.
+       */
+      uint64_t Count(result r) const
+      {
+        return _counts[static_cast<size_t>(r)];
+      }
+
+      /**
+       * @brief Forgets all observations and resets the counts.
+       */
+      void Clear();
+
+    private:
+      struct Key
+      {
+        uint32_t icao;
+        int64_t time;
+
+        bool operator==(const Key&) const = default;
+        bool operator>(const Key& k) const
+        {
+          return time != k.time ? time > k.time : icao > k.icao;
+        }
+      };
+
+      struct KeyHash
+      {
+        size_t operator()(const Key& k) const;
+      };
+
+      result count(result r);
+      void expire();
+
+      const int64_t _window;
+      int64_t _newest;
+
+      // content fingerprint of the last report passed on per observation
+      std::unordered_map<Key, uint64_t, KeyHash> _seen;
+
+      // remembered observations, oldest first
+      std::priority_queue<Key, std::vector<Key>, std::greater<Key>> _expiry;
+
+      uint64_t _counts[NUM_RESULTS];
+    };
+  }
+}
@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Delta-encoded stream of station updates
+//
+
+#pragma once
+
+#include "Record.h"
+#include "RecordDiff.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class DeltaCodec
+     * @brief Definitions shared by DeltaEncoder and DeltaDecoder.
+     *
+     * A stream is a sequence of messages, one per station update. A message
+     * holds the message kind, the packed station identifier, the change bits
+     * (see RecordDiff), the presence bits of the changed fields and then the
+     * values of the changed fields that are present. Every value is sent as
+     * the zigzag varint of its difference from the station's previous value,
+     * so slowly changing fields such as times and pressures take one or two
+     * bytes. Cloud layers and phenomenon groups are sent whole when any of
+     * them changed.
+     *
+     * A KEYFRAME message is relative to an empty record and carries the
+     * complete report; a DELTA message is relative to the station's previous
+     * update. The encoder sends a keyframe for a station after a fixed number
+     * of deltas, so a subscriber joining a stream in progress can resume every
+     * station within that many updates.
+     *
+     * The class is non-instantiable.
+     */
+    class DeltaCodec
+    {
+    public:
+      /**
+       * @enum kind
+       * @brief Message kinds.
+       */
+      enum kind : uint8_t
+      {
+        KEYFRAME = 1,
+        DELTA = 2
+      };
+
+      DeltaCodec() = delete;
+    };
+
+    /**
+     * @class DeltaEncoder
+     * @brief Turns a stream of reports into delta-encoded messages.
+     *
+     * Reports that do not supersede the station's last report, or do not
+     * change it, produce no message (see ChangeTracker).
+     *
+     * Not thread safe; use one instance per stream.
+     */
+    class DeltaEncoder
+    {
+    public:
+      /**
+       * @brief Constructs an encoder.
+       *
+       * @param keyframe_interval The number of deltas sent for a station
+       *                          between two keyframes.
+       */
+      explicit DeltaEncoder(unsigned int keyframe_interval = 30);
+
+      ~DeltaEncoder() = default;
+
+      DeltaEncoder(const DeltaEncoder&) = delete;
+      DeltaEncoder& operator=(const DeltaEncoder&) = delete;
+
+      /**
+       * @brief Encodes a report.
+       *
+       * @param record The report; its icao field selects the station.
+       * @param out The message, if any, is appended to this vector.
+       * @return True if a message was appended.
+       */
+      bool Encode(const Record& record, std::vector<uint8_t>& out);
+
+      /**
+       * @brief Encodes a keyframe of every station, e.g., for a new
+       *        subscriber. Does not affect the keyframe schedule.
+       *
+       * @param out The messages are appended to this vector.
+       */
+      void Keyframes(std::vector<uint8_t>& out) const;
+
+    private:
+      const unsigned int _interval;
+      ChangeTracker _tracker;
+      std::unordered_map<uint32_t, unsigned int> _deltas;
+    };
+
+    /**
+     * @class DeltaDecoder
+     * @brief Rebuilds the reports of a stream written by DeltaEncoder.
+     *
+     * Not thread safe; use one instance per stream.
+     */
+    class DeltaDecoder
+    {
+    public:
+      /**
+       * @enum result
+       * @brief Outcome of decoding a message.
+       */
+      enum class result
+      {
+        RECORD,      // a report was rebuilt
+        WAITING,     // a delta of a station whose keyframe was not seen yet
+        INCOMPLETE,  // the input ends within the message
+        CORRUPT      // the message is malformed
+      };
+
+      DeltaDecoder() = default;
+
+      DeltaDecoder(const DeltaDecoder&) = delete;
+      DeltaDecoder& operator=(const DeltaDecoder&) = delete;
+
+      /**
+       * @brief Decodes the next message.
+       *
+       * @param in The input, starting at a message.
+       * @param consumed Receives the size of the message for RECORD and
+       *                 WAITING, 0 otherwise.
+       * @param record Receives the report for RECORD.
+       * @return The outcome.
+       */
+      result Decode(std::span<const uint8_t> in, size_t& consumed,
+                    Record& record);
+
+      /**
+       * @brief Retrieves the number of stations known.
+       *
+       * @return The number of stations.
+       */
+      size_t Size() const { return _last.size(); }
+
+    private:
+      std::unordered_map<uint32_t, Record> _last;
+    };
+  }
+}
@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Predicate filters over columnar batches
+//
+
+#pragma once
+
+#include "Phenom.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    class Batch;
+
+    /**
+     * @class Filter
+     * @brief A combination of field predicates evaluated over a Batch.
+     *
+     * Filters are built from comparisons of a field against a constant and
+     * from present weather tests, combined with & (and) and | (or). A filter
+     * is evaluated column by column: each predicate runs a vectorized compare
+     * kernel over a whole column and produces a selection bitmap, and the
+     * bitmaps are combined a word at a time.
+     *
+     * Comparisons are normalized to the units of the field, whatever units
+     * each report used. A comparison with a missing value is false.
+     *
+     * Example, reports with low visibility or ceiling, or freezing rain:
+     * @code
+     *   auto f = Filter::Compare(Filter::field::VISIBILITY, Filter::op::LT, 3)
+     *          | Filter::Compare(Filter::field::CEILING, Filter::op::LT, 1000)
+     *          | Filter::Contains(Phenom::phenom::RAIN, true);
+     * @endcode
+     */
+    class Filter
+    {
+    public:
+      /**
+       * @enum field
+       * @brief The fields that can be compared, and their units.
+       */
+      enum class field
+      {
+        VISIBILITY,         // statute miles
+        CEILING,            // feet
+        WIND_SPEED,         // knots
+        WIND_GUST,          // knots
+        TEMPERATURE,        // degrees Celsius
+        DEW_POINT,          // degrees Celsius
+        SEA_LEVEL_PRESSURE, // hPa
+        FLIGHT_CATEGORY     // Metar::flight_category
+      };
+
+      /**
+       * @enum op
+       * @brief Comparison operators.
+       */
+      enum class op
+      {
+        LT, LE, GT, GE, EQ, NE
+      };
+
+      /**
+       * @brief Creates a filter comparing a field against a constant.
+       *
+       * @param f The field.
+       * @param o The operator; the field is the left operand.
+       * @param value The constant, in the units of the field.
+       * @return The filter.
+       */
+      static Filter Compare(field f, op o, double value);
+
+      /**
+       * @brief Creates a filter matching reports with a weather phenomenon.
+       *
+       * @param p The phenomenon.
+       * @param freezing If true, the phenomenon must be reported with the
+       *                 freezing descriptor (e.g., FZRA).
+       * @return The filter.
+       */
+      static Filter Contains(Phenom::phenom p, bool freezing = false);
+
+      /**
+       * @brief Creates a filter matching reports matched by both filters.
+       */
+      friend Filter operator&(const Filter& a, const Filter& b);
+
+      /**
+       * @brief Creates a filter matching reports matched by either filter.
+       */
+      friend Filter operator|(const Filter& a, const Filter& b);
+
+      /**
+       * @brief Evaluates the filter over a batch.
+       *
+       * @param batch The batch.
+       * @param selection Receives the selection bitmap: bit i % 64 of word
+       *                  i / 64 is set if report i matches. Unused bits of
+       *                  the last word are clear.
+       */
+      void Evaluate(const Batch& batch, std::vector<uint64_t>& selection) const;
+
+      /**
+       * @brief Counts the reports selected by a bitmap.
+       *
+       * @param selection The selection bitmap.
+       * @return The number of reports.
+       */
+      static size_t Count(std::span<const uint64_t> selection);
+
+      /**
+       * @brief Lists the reports selected by a bitmap.
+       *
+       * @param selection The selection bitmap.
+       * @param indices The indices of the reports are appended to this
+       *                vector, in increasing order.
+       */
+      static void Indices(std::span<const uint64_t> selection,
+                          std::vector<size_t>& indices);
+
+    private:
+      enum class kind : uint8_t
+      {
+        COMPARE, CONTAINS, AND, OR
+      };
+
+      // a filter is held in postfix order, so that evaluation needs only a
+      // stack of bitmaps
+      struct Node
+      {
+        kind k;
+        field f;
+        op o;
+        double value;
+        uint64_t mask;
+      };
+
+      Filter() = default;
+
+      static Filter combine(const Filter& a, const Filter& b, kind k);
+
+      std::vector<Node> _nodes;
+    };
+  }
+}
@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Concurrent latest observation per station
+//
+
+#pragma once
+
+#include "Record.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class LatestCache
+     * @brief A concurrent cache of the latest decoded record of every station.
+     *
+     * Stations are spread over shards by a hash of their packed ICAO
+     * identifier. Writers lock only the shard of the station they update, so
+     * writers on different shards never contend. Readers take no locks: each
+     * slot is guarded by a sequence lock and a read only repeats if the same
+     * station is being written at that moment.
+     *
+     * An update replaces the cached record only if it supersedes it (see
+     * Supersedes()), so late or duplicate deliveries never roll a station back.
+     *
+     * Every stored update advances a version number and is noted in a bounded
+     * change log, so that pollers can fetch only the stations that changed
+     * since the version they last saw (see Changes()). Versions are claimed
+     * atomically and each log entry is tagged with its version, so logging
+     * takes no lock either.
+     */
+    class LatestCache
+    {
+    public:
+      /**
+       * @brief Constructs an empty cache.
+       *
+       * @param max_stations The expected maximum number of stations. Each shard
+       *                     holds up to twice its share of this number.
+       * @param shards The number of shards.
+       * @param log_capacity The number of updates kept in the change log.
+       */
+      explicit LatestCache(size_t max_stations, size_t shards = 64,
+                           size_t log_capacity = 4096);
+
+      ~LatestCache() = default;
+
+      LatestCache(const LatestCache&) = delete;
+      LatestCache& operator=(const LatestCache&) = delete;
+
+      /**
+       * @brief Determines whether a record supersedes another record of the
+       *        same station.
+       *
+       * A newer observation time wins. A correction (COR) replaces a report
+       * with the same observation time. Observation times are compared as
+       * absolute times when both records have one, otherwise by day, hour and
+       * minute; a day more than 15 days earlier is taken to be in the next
+       * month (e.g., 010051Z supersedes 312351Z).
+       *
+       * @param candidate The new record.
+       * @param current The record currently held.
+       * @return True if candidate should replace current.
+       */
+      static bool Supersedes(const Record& candidate, const Record& current);
+
+      /**
+       * @brief Offers a record to the cache.
+       *
+       * Safe to call from any number of threads.
+       *
+       * @param record The record; its icao field selects the station.
+       * @return True if the record was stored, false if it did not supersede
+       *         the cached record, has no station, or its shard is full.
+       */
+      bool Update(const Record& record);
+
+      /**
+       * @brief Retrieves the latest record of a station.
+       *
+       * Safe to call from any number of threads concurrently with Update().
+       *
+       * @param icao The packed station identifier.
+       * @return The record, or an empty optional if the station is unknown.
+       */
+      std::optional<Record> Get(uint32_t icao) const;
+
+      /**
+       * @brief Retrieves the number of stations in the cache.
+       *
+       * @return The number of stations.
+       */
+      size_t Size() const;
+
+      /**
+       * @brief Retrieves the current version of the cache.
+       *
+       * The version starts at 0 and is incremented by every stored update.
+       *
+       * @return The version.
+       */
+      uint64_t Version() const;
+
+      /**
+       * @brief Retrieves the stations updated after a given version.
+       *
+       * Runs in time proportional to the number of updates since that
+       * version. If the change log no longer reaches back that far, every
+       * cached station is returned instead. A record may already reflect an
+       * update made after the returned version; that station is then returned
+       * again by the next call.
+       *
+       * @param since A version returned by an earlier call, or 0.
+       * @param out Receives the latest record of each changed station, once
+       *            per station. Cleared first.
+       * @return The version to pass to the next call.
+       */
+      uint64_t Changes(uint64_t since, std::vector<Record>& out) const;
+
+    private:
+      static constexpr size_t WORDS = sizeof(Record) / sizeof(uint64_t);
+
+      struct alignas(64) Slot
+      {
+        std::atomic<uint32_t> icao{0};
+        std::atomic<uint64_t> seq{0};
+        std::atomic<uint64_t> words[WORDS]{};
+      };
+
+      struct Shard
+      {
+        std::mutex mutex;
+        std::unique_ptr<Slot[]> slots;
+        size_t mask = 0;
+        size_t max_size = 0;
+        std::atomic<size_t> size{0};
+      };
+
+      Shard& shard_of(uint64_t h) const;
+      void log(uint32_t icao);
+
+      std::unique_ptr<Shard[]> _shards;
+      const size_t _num_shards;
+
+      // ring of the stations of the last _log.size() updates; the update
+      // that produced version v is at (v - 1) % _log.size(), its station in
+      // the low half and the low half of v in the high half
+      std::vector<std::atomic<uint64_t>> _log;
+      std::atomic<uint64_t> _version{0};
+    };
+  }
+}
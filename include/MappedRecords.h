@@ -0,0 +1,190 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Memory-mapped record file
+//
+
+#pragma once
+
+#include "Record.h"
+#include "RecordCodec.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class MappedRecords
+     * @brief Read-only view of a record file (see RecordCodec) mapped into
+     *        memory.
+     *
+     * Opening a file only maps it and checks its header, so it takes the
+     * same time whatever the size of the file. Records and columns are read
+     * directly from the mapping when accessed. The mapping is shared, so
+     * processes reading the same file share its pages in the page cache.
+     */
+    class MappedRecords
+    {
+    public:
+      /**
+       * @class Column
+       * @brief A view of one field of every record in the file.
+       *
+       * The values are read in place, ENCODED_SIZE bytes apart.
+       */
+      template<typename T>
+      class Column
+      {
+      public:
+        Column(const uint8_t *base, size_t size) : _base(base), _size(size) {}
+
+        /**
+         * @brief Retrieves the number of values.
+         *
+         * @return The number of values.
+         */
+        size_t size() const { return _size; }
+
+        /**
+         * @brief Retrieves a value.
+         *
+         * @param i The record index.
+         * @return The value.
+         */
+        T operator[](size_t i) const
+        {
+          const uint8_t *p = _base + i * RecordCodec::ENCODED_SIZE;
+          if constexpr (std::endian::native == std::endian::little)
+          {
+            T v;
+            memcpy(&v, p, sizeof(T));
+            return v;
+          }
+          else
+          {
+            using U = std::make_unsigned_t<T>;
+            U u = 0;
+            for (size_t b = 0 ; b < sizeof(T) ; b++)
+            {
+              u |= static_cast<U>(static_cast<U>(p[b]) << (8 * b));
+            }
+            return static_cast<T>(u);
+          }
+        }
+
+      private:
+        const uint8_t *_base;
+        size_t _size;
+      };
+
+      /**
+       * @brief Maps a record file.
+       *
+       * @param path The path of the file.
+       * @return The mapped file, or a null pointer if the file could not be
+       *         mapped or is not a complete record file of this version.
+       */
+      static std::shared_ptr<MappedRecords> Create(const char *path);
+
+      ~MappedRecords();
+
+      MappedRecords(const MappedRecords&) = delete;
+      MappedRecords& operator=(const MappedRecords&) = delete;
+
+      /**
+       * @brief Retrieves the number of records.
+       *
+       * @return The number of records.
+       */
+      size_t Size() const { return _size; }
+
+      /**
+       * @brief Retrieves the encoded bytes of a record.
+       *
+       * @param i The record index.
+       * @return RecordCodec::ENCODED_SIZE bytes within the mapping.
+       */
+      const uint8_t *Data(size_t i) const
+      {
+        return _records + i * RecordCodec::ENCODED_SIZE;
+      }
+
+      /**
+       * @brief Decodes a record.
+       *
+       * @param i The record index.
+       * @param record Receives the record.
+       * @return False if the record is corrupt.
+       */
+      bool Get(size_t i, Record& record) const
+      {
+        return RecordCodec::Decode(Data(i), record);
+      }
+
+      /**
+       * @brief Retrieves a view of a field of every record.
+       *
+       * @param off The offset of the field (see RecordCodec::offset).
+       * @return The column; T must be the type of the field in Record.
+       */
+      template<typename T>
+      Column<T> Field(RecordCodec::offset off) const
+      {
+        return Column<T>(_records + off, _size);
+      }
+
+      Column<uint32_t> ICAO() const
+        { return Field<uint32_t>(RecordCodec::ICAO_OFFSET); }
+      Column<uint32_t> Present() const
+        { return Field<uint32_t>(RecordCodec::PRESENT_OFFSET); }
+      Column<int64_t> ObservationTime() const
+        { return Field<int64_t>(RecordCodec::OBS_TIME_OFFSET); }
+      Column<int32_t> Visibility() const
+        { return Field<int32_t>(RecordCodec::VISIBILITY_OFFSET); }
+      Column<int32_t> Ceiling() const
+        { return Field<int32_t>(RecordCodec::CEILING_OFFSET); }
+      Column<int16_t> WindDirection() const
+        { return Field<int16_t>(RecordCodec::WIND_DIR_OFFSET); }
+      Column<int16_t> WindSpeed() const
+        { return Field<int16_t>(RecordCodec::WIND_SPEED_OFFSET); }
+      Column<int16_t> WindGust() const
+        { return Field<int16_t>(RecordCodec::WIND_GUST_OFFSET); }
+      Column<int16_t> TemperatureNA() const
+        { return Field<int16_t>(RecordCodec::TEMPERATURE_NA_OFFSET); }
+      Column<int16_t> DewPointNA() const
+        { return Field<int16_t>(RecordCodec::DEW_POINT_NA_OFFSET); }
+      Column<int16_t> AltimeterA() const
+        { return Field<int16_t>(RecordCodec::ALTIMETER_A_OFFSET); }
+      Column<int16_t> AltimeterQ() const
+        { return Field<int16_t>(RecordCodec::ALTIMETER_Q_OFFSET); }
+      Column<int16_t> SeaLevelPressure() const
+        { return Field<int16_t>(RecordCodec::SEA_LEVEL_PRESS_OFFSET); }
+      Column<int8_t> Temperature() const
+        { return Field<int8_t>(RecordCodec::TEMPERATURE_OFFSET); }
+      Column<int8_t> DewPoint() const
+        { return Field<int8_t>(RecordCodec::DEW_POINT_OFFSET); }
+      Column<uint8_t> FlightCategory() const
+        { return Field<uint8_t>(RecordCodec::FLIGHT_CATEGORY_OFFSET); }
+      Column<uint8_t> Flags() const
+        { return Field<uint8_t>(RecordCodec::FLAGS_OFFSET); }
+
+    private:
+      MappedRecords(void *map, size_t length, size_t size)
+        : _map(map), _length(length), _size(size)
+        , _records(static_cast<const uint8_t *>(map)
+                   + RecordCodec::FILE_HEADER_SIZE) {}
+
+      void *_map;
+      size_t _length;
+      size_t _size;
+      const uint8_t *_records;
+    };
+  }
+}
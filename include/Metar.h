@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <ctime>
 #include <memory>
 #include <optional>
 
@@ -54,6 +56,39 @@ namespace Storage_B
        *         or nullptr if the input string is invalid or cannot be processed.
        */
       static std::shared_ptr<Metar> Create(char *metar_str);
+
+      /**
+       * @brief Factory method to create a Metar instance and resolve its
+       *        observation time to an absolute timestamp.
+       *
+       * The report only carries the day of the month, hour and minute. The
+       * month and year are taken from the supplied reference time (e.g., the
+       * date header of a cycle file or the ingest clock), choosing the
+       * previous, current or next month so the resolved time lies closest to
+       * the reference. This handles month and year rollover. The result is
+       * available from ObservationTime().
+       *
+       * @param metar_str A null-terminated character string containing
+       * the raw METAR weather report to be parsed.
+       * @param reference The reference time, in seconds since the epoch (UTC).
+       * @return A shared pointer to the created Metar instance.
+       */
+      static std::shared_ptr<Metar> Create(const char *metar_str,
+                                           std::time_t reference);
+
+      /**
+       * @brief Factory method to create a Metar instance and resolve its
+       *        observation time to an absolute timestamp.
+       *
+       * Same as Create(const char *, std::time_t) but the supplied buffer
+       * is tokenized in place.
+       *
+       * @param metar_str The raw METAR string to be parsed and decoded.
+       * @param reference The reference time, in seconds since the epoch (UTC).
+       * @return A shared pointer to the created Metar instance.
+       */
+      static std::shared_ptr<Metar> Create(char *metar_str,
+                                           std::time_t reference);
       
       enum class message_type
       {
@@ -74,6 +109,29 @@ namespace Storage_B
         SM  // statute miles
       };
 
+      /**
+       * @enum flight_category
+       * @brief Flight rules category derived from ceiling and visibility.
+       *
+       * - VFR:  ceiling above 3000 ft and visibility above 5 SM
+       * - MVFR: ceiling 1000 to 3000 ft and/or visibility 3 to 5 SM
+       * - IFR:  ceiling 500 to below 1000 ft and/or visibility 1 to below 3 SM
+       * - LIFR: ceiling below 500 ft and/or visibility below 1 SM
+       */
+      enum class flight_category
+      {
+        VFR,
+        MVFR,
+        IFR,
+        LIFR
+      };
+
+      /**
+       * @brief Number of fixed-point steps per statute mile used by
+       *        VisibilityScaled() when the visibility units are SM.
+       */
+      static constexpr int VISIBILITY_SM_SCALE = 16;
+
       Metar() = default;
 
       /**
@@ -112,6 +170,14 @@ namespace Storage_B
        */
       virtual std::optional<std::string> ICAO() const = 0;
 
+      /**
+       * @brief Checks if the report is a correction (COR) of a previously
+       *        issued report.
+       *
+       * @return True if the report carries the COR modifier, false otherwise.
+       */
+      virtual bool isCorrection() const = 0;
+
       /**
        * @brief Retrieves the day of the month from the decoded data.
        *
@@ -145,6 +211,17 @@ namespace Storage_B
        */
       virtual std::optional<int> Minute() const = 0;
 
+      /**
+       * @brief Retrieves the absolute observation time.
+       *
+       * The value is only available when the report was created with a
+       * reference time and contains a valid observation time group.
+       *
+       * @return An optional containing the observation time in seconds since
+       *         the epoch (UTC), or an empty optional if it was not resolved.
+       */
+      virtual std::optional<int64_t> ObservationTime() const = 0;
+
       /**
        * @brief Retrieves the wind direction from the weather report.
        *
@@ -231,6 +308,19 @@ namespace Storage_B
        */
       virtual std::optional<double> Visibility() const = 0;
 
+      /**
+       * @brief Retrieves the visibility as an exact fixed-point integer.
+       *
+       * Visibility is stored internally in this form; Visibility() is a
+       * conversion on top of it. When VisibilityUnits() is M the value is
+       * in meters, when it is SM the value is in sixteenths of a statute
+       * mile (see VISIBILITY_SM_SCALE).
+       *
+       * @return An optional containing the scaled visibility, or an empty
+       *         optional if the visibility information is not provided.
+       */
+      virtual std::optional<int> VisibilityScaled() const = 0;
+
       /**
        * @brief Retrieves the visibility units from the METAR report.
        *
@@ -273,6 +363,31 @@ namespace Storage_B
        */
       virtual std::optional<int> VerticalVisibility() const = 0;
 
+      /**
+       * @brief Retrieves the ceiling computed while decoding the report.
+       *
+       * The ceiling is the height of the lowest broken (BKN) or overcast (OVC)
+       * layer, or the vertical visibility, whichever is lower. Layers reported
+       * in a TEMPO group are not taken into account.
+       *
+       * @return An optional containing the ceiling in feet above ground level,
+       *         or an empty optional if no ceiling was reported.
+       */
+      virtual std::optional<int> Ceiling() const = 0;
+
+      /**
+       * @brief Retrieves the flight category computed while decoding the report.
+       *
+       * The category combines Ceiling() with the prevailing visibility, the
+       * more restrictive of the two determining the result. CAVOK reports are
+       * VFR. A report with neither a visibility nor a ceiling-defining sky
+       * condition group has no category.
+       *
+       * @return An optional containing the flight category, or an empty optional
+       *         if it cannot be determined.
+       */
+      virtual std::optional<flight_category> FlightCategory() const = 0;
+
       /**
        * @brief Retrieves the temperature value from the implemented METAR report.
        *
@@ -306,6 +421,17 @@ namespace Storage_B
        */
       virtual std::optional<double> AltimeterA() const = 0;
 
+      /**
+       * @brief Retrieves the A-prefix altimeter setting in hundredths of inHg.
+       *
+       * This is the exact integer encoded in the report (e.g., 2992 for
+       * A2992); AltimeterA() is derived from it.
+       *
+       * @return An optional containing the altimeter setting in hundredths
+       *         of inches of mercury, or std::nullopt if unavailable.
+       */
+      virtual std::optional<int> AltimeterAHundredths() const = 0;
+
       /**
        * @brief Retrieves the altimeter setting in QNH (hectopascals).
        *
@@ -329,6 +455,17 @@ namespace Storage_B
        */
       virtual std::optional<double> SeaLevelPressure() const = 0;
 
+      /**
+       * @brief Retrieves the sea-level pressure in tenths of hectopascals.
+       *
+       * This is the exact fixed-point value SeaLevelPressure() is derived from
+       * (e.g., 10177 for 1017.7 hPa).
+       *
+       * @return An optional containing the sea-level pressure in tenths of
+       *         hPa, or an empty optional if the information is unavailable.
+       */
+      virtual std::optional<int> SeaLevelPressureTenths() const = 0;
+
       /**
        * @brief Retrieves the temperature in North America format, if available.
        *
@@ -340,6 +477,15 @@ namespace Storage_B
        */
       virtual std::optional<double> TemperatureNA() const = 0;
 
+      /**
+       * @brief Retrieves the North America format temperature in tenths of
+       *        a degree Celsius.
+       *
+       * @return An optional containing the temperature in tenths of a degree
+       *         (e.g., -17 for -1.7), or empty if unavailable.
+       */
+      virtual std::optional<int> TemperatureNATenths() const = 0;
+
       /**
        * @brief Retrieves the dew point temperature in degrees, if available.
        *
@@ -352,6 +498,87 @@ namespace Storage_B
        */
       virtual std::optional<double> DewPointNA() const = 0;
 
+      /**
+       * @brief Retrieves the North America format dew point in tenths of
+       *        a degree Celsius.
+       *
+       * @return An optional containing the dew point in tenths of a degree,
+       *         or an empty optional if the value is not available.
+       */
+      virtual std::optional<int> DewPointNATenths() const = 0;
+
+      /**
+       * @brief Retrieves the relative humidity.
+       *
+       * Derived quantities are computed together on first access to any of
+       * them and stored in the report, so repeated calls are free. Access is
+       * thread safe. The T group tenths are used when present, otherwise the
+       * whole degree temperature and dew point.
+       *
+       * @return An optional containing the relative humidity as a percentage,
+       *         or an empty optional if temperature or dew point is missing.
+       */
+      virtual std::optional<double> RelativeHumidity() const = 0;
+
+      /**
+       * @brief Retrieves the wind chill temperature (see Utils::WindChill).
+       *
+       * @return An optional containing the wind chill in degrees Celsius, or an
+       *         empty optional if the temperature or wind speed is missing.
+       */
+      virtual std::optional<double> WindChill() const = 0;
+
+      /**
+       * @brief Retrieves the heat index (see Utils::HeatIndex).
+       *
+       * @return An optional containing the heat index in degrees Celsius, or an
+       *         empty optional if the temperature or dew point is missing.
+       */
+      virtual std::optional<double> HeatIndex() const = 0;
+
+      /**
+       * @brief Retrieves the wind speed converted to knots.
+       *
+       * @return An optional containing the wind speed in knots, or an empty
+       *         optional if the speed or its units are missing.
+       */
+      virtual std::optional<double> WindSpeedKnots() const = 0;
+
+      /**
+       * @brief Retrieves the wind gust converted to knots.
+       *
+       * @return An optional containing the wind gust in knots, or an empty
+       *         optional if the gust or its units are missing.
+       */
+      virtual std::optional<double> WindGustKnots() const = 0;
+
+      /**
+       * @brief Retrieves the pressure altitude at the station.
+       *
+       * The report does not carry the station elevation, so it is supplied by
+       * the caller. The altimeter correction is cached; the elevation is added
+       * on each call.
+       *
+       * @param elevation The station elevation in feet.
+       * @return An optional containing the pressure altitude in feet, or an
+       *         empty optional if no altimeter setting was reported.
+       */
+      virtual std::optional<double> PressureAltitude(double elevation) const = 0;
+
+      /**
+       * @brief Retrieves the density altitude at the station.
+       *
+       * Computed from PressureAltitude() as PA + 120 * (OAT - ISA), with the
+       * ISA temperature at the pressure altitude being 15 - 2 * PA / 1000
+       * degrees Celsius.
+       *
+       * @param elevation The station elevation in feet.
+       * @return An optional containing the density altitude in feet, or an
+       *         empty optional if the altimeter setting or temperature is
+       *         missing.
+       */
+      virtual std::optional<double> DensityAltitude(double elevation) const = 0;
+
       /**
        * @brief Retrieves the number of cloud layers reported.
        *
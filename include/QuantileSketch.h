@@ -0,0 +1,255 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Mergeable quantile sketches of station reports
+//
+
+#pragma once
+
+#include "Filter.h"
+#include "Record.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class QuantileSketch
+     * @brief Approximate quantiles of a stream of values in bounded memory
+     *        (a KLL sketch).
+     *
+     * Values are kept in a hierarchy of compactors. A value in compactor h
+     * stands for 2^h values of the stream; when a compactor is full it is
+     * sorted and every other value, starting at a random one of the first
+     * two, is promoted to the next compactor. Compactor capacities shrink
+     * geometrically from the top, so a sketch retains O(k) values however
+     * many it has seen, and the rank error of a quantile is about 1.7 / k
+     * with high probability (about 1% for the default k).
+     *
+     * Sketches of the same k can be merged, e.g., the sketches of separate
+     * threads, files or months, and the result is as accurate as a sketch of
+     * the combined stream. The minimum and maximum are exact.
+     *
+     * Not thread safe.
+     */
+    class QuantileSketch
+    {
+    public:
+      /**
+       * @brief Default accuracy parameter.
+       */
+      static constexpr uint16_t DEFAULT_K = 200;
+
+      /**
+       * @brief Constructs an empty sketch.
+       *
+       * @param k The accuracy parameter; the capacity of the largest
+       *          compactor. At least 8.
+       */
+      explicit QuantileSketch(uint16_t k = DEFAULT_K);
+
+      /**
+       * @brief Adds a value. NaN values are ignored.
+       *
+       * @param v The value.
+       */
+      void Add(double v);
+
+      /**
+       * @brief Adds the values seen by another sketch.
+       *
+       * @param other The sketch; must have the same k.
+       * @return False if the k of the sketches differ.
+       */
+      bool Merge(const QuantileSketch& other);
+
+      /**
+       * @brief Retrieves an approximate quantile.
+       *
+       * @param q The quantile, from 0 (the minimum) to 1 (the maximum).
+       * @return The value, NaN if the sketch is empty.
+       */
+      double Quantile(double q) const;
+
+      /**
+       * @brief Retrieves approximate quantiles, sorting the retained values
+       *        once.
+       *
+       * @param q The quantiles, from 0 to 1.
+       * @param out Receives the values, in the order of q; NaN if the sketch
+       *            is empty. Must be as large as q.
+       */
+      void Quantiles(std::span<const double> q, std::span<double> out) const;
+
+      /**
+       * @brief Retrieves the approximate fraction of the values that are not
+       *        greater than a value.
+       *
+       * @param v The value.
+       * @return The fraction, NaN if the sketch is empty.
+       */
+      double Rank(double v) const;
+
+      /**
+       * @brief Retrieves the number of values seen.
+       *
+       * @return The number of values.
+       */
+      uint64_t Count() const { return _count; }
+
+      /// Smallest value seen; NaN if the sketch is empty.
+      double Min() const;
+
+      /// Largest value seen; NaN if the sketch is empty.
+      double Max() const;
+
+      /**
+       * @brief Retrieves the number of values retained.
+       *
+       * @return The number of values.
+       */
+      size_t Retained() const { return _size; }
+
+      /**
+       * @brief Retrieves the accuracy parameter.
+       *
+       * @return k.
+       */
+      uint16_t K() const { return _k; }
+
+      /**
+       * @brief Serializes the sketch.
+       *
+       * @param out The sketch is appended to this vector.
+       */
+      void Serialize(std::vector<uint8_t>& out) const;
+
+      /**
+       * @brief Creates a sketch from its serialized form.
+       *
+       * @param in The input, starting at a sketch written by Serialize().
+       * @param consumed Receives the size of the serialized sketch.
+       * @return The sketch, or a null pointer if the input is truncated or
+       *         malformed.
+       */
+      static std::shared_ptr<QuantileSketch>
+        Create(std::span<const uint8_t> in, size_t& consumed);
+
+    private:
+      void levels(size_t n);
+      void compress();
+
+      uint16_t _k;
+      uint64_t _count = 0;
+      double _min;
+      double _max;
+      size_t _size = 0;       // values retained
+      size_t _max_size;       // sum of the compactor capacities
+      uint64_t _random;
+      std::vector<std::vector<double>> _compactors;
+      std::vector<size_t> _capacity;
+    };
+
+    /**
+     * @class StationSketches
+     * @brief Quantile sketches of numeric fields of every station's reports,
+     *        for climatology without retaining or sorting the raw values.
+     *
+     * Values are sketched in the units of Filter::field; CAVOK counts as
+     * its visibility as in Batch. Reports without a station are skipped.
+     * Duplicate reports are not detected (see Deduplicator).
+     *
+     * Sketches of different threads, files or time ranges are combined with
+     * Merge(), and may be saved and restored with Serialize() and Create().
+     *
+     * Not thread safe; use one instance per thread and merge them.
+     *
+     * Example, 99th percentile gust of a station over every month archived:
+     * @code
+     *   StationSketches all({ Filter::field::WIND_GUST });
+     *   for (const auto& month : months) all.Merge(*month);
+     *   const QuantileSketch *s = all.Get(icao, Filter::field::WIND_GUST);
+     *   double p99 = s != nullptr ? s->Quantile(0.99) : NAN;
+     * @endcode
+     */
+    class StationSketches
+    {
+    public:
+      /**
+       * @brief Constructs empty sketches.
+       *
+       * @param fields The sketched fields.
+       * @param k The accuracy parameter of the sketches.
+       */
+      explicit StationSketches(
+        const std::vector<Filter::field>& fields
+          = { Filter::field::WIND_SPEED, Filter::field::WIND_GUST,
+              Filter::field::VISIBILITY },
+        uint16_t k = QuantileSketch::DEFAULT_K);
+
+      /**
+       * @brief Adds the fields of a report to the sketches of its station.
+       *
+       * @param record The report.
+       * @return False if the report has no station.
+       */
+      bool Add(const Record& record);
+
+      /**
+       * @brief Adds the sketches of another instance.
+       *
+       * @param other The sketches; must have the same fields and k.
+       * @return False if the fields or k differ.
+       */
+      bool Merge(const StationSketches& other);
+
+      /**
+       * @brief Retrieves the sketch of a field of a station.
+       *
+       * @param icao The packed station identifier.
+       * @param f The field.
+       * @return The sketch, or a null pointer if the station is unknown or
+       *         the field is not sketched.
+       */
+      const QuantileSketch *Get(uint32_t icao, Filter::field f) const;
+
+      /**
+       * @brief Retrieves the number of stations.
+       *
+       * @return The number of stations.
+       */
+      size_t Size() const { return _stations.size(); }
+
+      /**
+       * @brief Serializes the sketches.
+       *
+       * @param out The sketches are appended to this vector.
+       */
+      void Serialize(std::vector<uint8_t>& out) const;
+
+      /**
+       * @brief Creates sketches from their serialized form.
+       *
+       * @param in The input written by Serialize().
+       * @return The sketches, or a null pointer if the input is truncated or
+       *         malformed.
+       */
+      static std::shared_ptr<StationSketches>
+        Create(std::span<const uint8_t> in);
+
+    private:
+      std::vector<QuantileSketch>& station(uint32_t icao);
+
+      std::vector<Filter::field> _fields;
+      uint16_t _k;
+      std::unordered_map<uint32_t, std::vector<QuantileSketch>> _stations;
+    };
+  }
+}
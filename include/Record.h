@@ -0,0 +1,206 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Flat decoded METAR record
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    class Metar;
+    class Phenom;
+
+    /**
+     * @struct Record
+     * @brief A fixed-size, trivially copyable copy of a decoded METAR report.
+     *
+     * Record holds the same information as the Metar accessors, with the
+     * station identifier packed into an integer, numeric values in their exact
+     * fixed-point form, and cloud layers and weather phenomena stored inline.
+     * Optional fields are tracked by presence bits. Being a plain value it can
+     * be copied into ring buffers, caches and files without allocation.
+     */
+    struct alignas(8) Record
+    {
+      /**
+       * @brief Maximum number of cloud layers and phenomenon groups stored
+       *        inline. Additional ones are dropped.
+       */
+      static constexpr unsigned int MAX_LAYERS = 6;
+      static constexpr unsigned int MAX_PHENOMENA = 4;
+      static constexpr unsigned int MAX_PHENOM = 3;
+
+      /**
+       * @brief Marker for an absent enumeration value.
+       */
+      static constexpr uint8_t NONE8 = UINT8_MAX;
+
+      /**
+       * @enum field
+       * @brief Presence bits of the optional fields.
+       */
+      enum field : uint32_t
+      {
+        MESSAGE_TYPE     = 1u << 0,
+        ICAO             = 1u << 1,
+        TIME             = 1u << 2,   // day, hour and minute
+        OBSERVATION_TIME = 1u << 3,
+        WIND_DIRECTION   = 1u << 4,
+        WIND_SPEED       = 1u << 5,
+        WIND_GUST        = 1u << 6,
+        WIND_RANGE       = 1u << 7,   // min and max wind direction
+        WIND_UNITS       = 1u << 8,
+        VISIBILITY       = 1u << 9,   // visibility and its units
+        VERTICAL_VIS     = 1u << 10,
+        CEILING          = 1u << 11,
+        FLIGHT_CATEGORY  = 1u << 12,
+        TEMPERATURE      = 1u << 13,
+        DEW_POINT        = 1u << 14,
+        ALTIMETER_A      = 1u << 15,
+        ALTIMETER_Q      = 1u << 16,
+        SEA_LEVEL_PRESS  = 1u << 17,
+        TEMPERATURE_NA   = 1u << 18,
+        DEW_POINT_NA     = 1u << 19
+      };
+
+      /**
+       * @enum flag
+       * @brief Boolean attributes of the report.
+       */
+      enum flag : uint8_t
+      {
+        VARIABLE_WIND    = 1u << 0,
+        CAVOK            = 1u << 1,
+        VISIBILITY_LT    = 1u << 2,
+        CORRECTION       = 1u << 3
+      };
+
+      /**
+       * @struct Layer
+       * @brief An inline cloud layer (see Clouds).
+       */
+      struct Layer
+      {
+        int16_t altitude;  // hundreds of feet, -1 if not reported
+        uint8_t cover;     // Clouds::cover
+        uint8_t type;      // Clouds::type, NONE8 if not reported
+        uint8_t tempo;
+
+        bool operator==(const Layer&) const = default;
+      };
+
+      /**
+       * @struct Phenomenon
+       * @brief An inline weather phenomenon group (see Phenom).
+       */
+      struct Phenomenon
+      {
+        enum attribute : uint16_t
+        {
+          BLOWING       = 1u << 0,
+          FREEZING      = 1u << 1,
+          DRIFTING      = 1u << 2,
+          VICINITY      = 1u << 3,
+          PARTIAL       = 1u << 4,
+          SHALLOW       = 1u << 5,
+          PATCHES       = 1u << 6,
+          THUNDERSTORM  = 1u << 7,
+          TEMPORARY     = 1u << 8
+        };
+
+        /**
+         * @brief Creates a phenomenon group from a decoded one.
+         *
+         * @param p The decoded phenomenon group.
+         * @return The phenomenon group; phenomena beyond MAX_PHENOM are
+         *         dropped.
+         */
+        static Phenomenon Create(const Phenom& p);
+
+        uint16_t attributes;
+        int8_t intensity;                // Phenom::intensity
+        uint8_t phenom[MAX_PHENOM];      // Phenom::phenom, NONE if unused
+
+        bool operator==(const Phenomenon&) const = default;
+      };
+
+      /**
+       * @brief Creates a record from a decoded report.
+       *
+       * @param metar The decoded report.
+       * @return The record.
+       */
+      static Record Create(const Metar& metar);
+
+      /**
+       * @brief Packs a four letter ICAO location identifier into an integer.
+       *
+       * @param icao The identifier; only the first four characters are used.
+       * @return The packed identifier, 0 for an empty string.
+       */
+      static uint32_t PackICAO(const char *icao);
+
+      /**
+       * @brief Unpacks an identifier packed by PackICAO().
+       *
+       * @param icao The packed identifier.
+       * @return The ICAO location identifier.
+       */
+      static std::string UnpackICAO(uint32_t icao);
+
+      /**
+       * @brief Determines whether an optional field is present.
+       *
+       * @param f The field.
+       * @return True if the field is present.
+       */
+      bool Has(field f) const { return (present & f) != 0; }
+
+      bool operator==(const Record&) const = default;
+
+      uint32_t icao;           // PackICAO()
+      uint32_t present;        // field bits
+      int64_t obs_time;        // seconds since the epoch
+
+      int32_t visibility;      // Metar::VisibilityScaled
+      int32_t ceiling;         // feet
+      int32_t vertical_vis;    // feet
+
+      int16_t wind_dir;
+      int16_t wind_speed;
+      int16_t wind_gust;
+      int16_t min_wind_dir;
+      int16_t max_wind_dir;
+
+      int16_t temperature_na;  // tenths of a degree Celsius
+      int16_t dew_point_na;    // tenths of a degree Celsius
+      int16_t altimeter_a;     // hundredths of inHg
+      int16_t altimeter_q;     // hPa
+      int16_t sea_level_press; // tenths of hPa
+
+      int8_t temperature;      // degrees Celsius
+      int8_t dew_point;        // degrees Celsius
+
+      uint8_t day;
+      uint8_t hour;
+      uint8_t minute;
+      uint8_t message_type;    // Metar::message_type
+      uint8_t wind_units;      // Metar::speed_units
+      uint8_t vis_units;       // Metar::distance_units
+      uint8_t flight_category; // Metar::flight_category
+      uint8_t flags;           // flag bits
+
+      uint8_t num_layers;
+      uint8_t num_phenomena;
+
+      Layer layers[MAX_LAYERS];
+      Phenomenon phenomena[MAX_PHENOMENA];
+    };
+  }
+}
@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Binary encoding of decoded METAR records
+//
+
+#pragma once
+
+#include "Record.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <span>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class RecordCodec
+     * @brief Encodes and decodes Records in a versioned, fixed-size,
+     *        little-endian binary format.
+     *
+     * Every record is encoded in ENCODED_SIZE bytes: the presence bits, the
+     * packed ICAO identifier, the scaled integer fields and the inline cloud
+     * layers and phenomena, each at a fixed offset. The encoding does not
+     * depend on the host byte order or on the in-memory layout of Record.
+     *
+     * A record file is a FILE_HEADER_SIZE byte header (the MAGIC bytes, the
+     * format VERSION, ENCODED_SIZE and the number of records, little-endian)
+     * followed by the encoded records.
+     *
+     * The class is non-instantiable and contains only static methods.
+     */
+    class RecordCodec
+    {
+    public:
+      /**
+       * @brief Version of the encoding, stored in the file header.
+       */
+      static constexpr uint16_t VERSION = 1;
+
+      /**
+       * @brief Size of an encoded record in bytes.
+       */
+      static constexpr size_t ENCODED_SIZE = 120;
+
+      /**
+       * @brief Size of the record file header in bytes.
+       */
+      static constexpr size_t FILE_HEADER_SIZE = 16;
+
+      /**
+       * @brief Identifies a record file.
+       */
+      static constexpr char MAGIC[4] = { 'M', 'T', 'R', 'B' };
+
+      /**
+       * @enum offset
+       * @brief Byte offsets of the scalar fields within an encoded record.
+       */
+      enum offset : size_t
+      {
+        ICAO_OFFSET             = 0,
+        PRESENT_OFFSET          = 4,
+        OBS_TIME_OFFSET         = 8,
+        VISIBILITY_OFFSET       = 16,
+        CEILING_OFFSET          = 20,
+        VERTICAL_VIS_OFFSET     = 24,
+        WIND_DIR_OFFSET         = 28,
+        WIND_SPEED_OFFSET       = 30,
+        WIND_GUST_OFFSET        = 32,
+        MIN_WIND_DIR_OFFSET     = 34,
+        MAX_WIND_DIR_OFFSET     = 36,
+        TEMPERATURE_NA_OFFSET   = 38,
+        DEW_POINT_NA_OFFSET     = 40,
+        ALTIMETER_A_OFFSET      = 42,
+        ALTIMETER_Q_OFFSET      = 44,
+        SEA_LEVEL_PRESS_OFFSET  = 46,
+        TEMPERATURE_OFFSET      = 48,
+        DEW_POINT_OFFSET        = 49,
+        DAY_OFFSET              = 50,
+        HOUR_OFFSET             = 51,
+        MINUTE_OFFSET           = 52,
+        MESSAGE_TYPE_OFFSET     = 53,
+        WIND_UNITS_OFFSET       = 54,
+        VIS_UNITS_OFFSET        = 55,
+        FLIGHT_CATEGORY_OFFSET  = 56,
+        FLAGS_OFFSET            = 57,
+        NUM_LAYERS_OFFSET       = 58,
+        NUM_PHENOMENA_OFFSET    = 59,
+        LAYERS_OFFSET           = 60,
+        PHENOMENA_OFFSET        = 90
+      };
+
+      RecordCodec() = delete;
+
+      /**
+       * @brief Encodes a record.
+       *
+       * @param record The record.
+       * @param out Receives ENCODED_SIZE bytes.
+       */
+      static void Encode(const Record& record, uint8_t *out);
+
+      /**
+       * @brief Decodes a record.
+       *
+       * @param in ENCODED_SIZE bytes produced by Encode().
+       * @param record Receives the record.
+       * @return False if the bytes do not hold a valid record.
+       */
+      static bool Decode(const uint8_t *in, Record& record);
+
+      /**
+       * @brief Writes a record file.
+       *
+       * @param os The stream, opened in binary mode.
+       * @param records The records.
+       * @return True if the file was written.
+       */
+      static bool Write(std::ostream& os, std::span<const Record> records);
+
+      /**
+       * @brief Reads a record file.
+       *
+       * The records are read in large blocks and decoded in place, so loading
+       * runs at close to the speed of the underlying stream.
+       *
+       * @param is The stream, opened in binary mode.
+       * @param records The records read are appended to this vector.
+       * @return False if the stream does not hold a complete record file of
+       *         this version; records read before the error are kept.
+       */
+      static bool Read(std::istream& is, std::vector<Record>& records);
+
+      /**
+       * @brief Encodes a record file header.
+       *
+       * @param count The number of records in the file.
+       * @param out Receives FILE_HEADER_SIZE bytes.
+       */
+      static void EncodeHeader(uint64_t count, uint8_t *out);
+
+      /**
+       * @brief Decodes a record file header.
+       *
+       * @param in FILE_HEADER_SIZE bytes.
+       * @param count Receives the number of records in the file.
+       * @return False if the header is not of a record file of this version.
+       */
+      static bool DecodeHeader(const uint8_t *in, uint64_t& count);
+    };
+  }
+}
@@ -0,0 +1,145 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Field-level differences between decoded records
+//
+
+#pragma once
+
+#include "Record.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class RecordDiff
+     * @brief Computes and applies field-level differences between two records
+     *        of the same station.
+     *
+     * Changes are reported as a bitmask. The optional fields use their
+     * Record::field presence bits; a field has changed if it appeared,
+     * disappeared or changed value. The flags, the cloud layers and the
+     * phenomenon groups, which have no presence bits, use the additional
+     * FLAGS, LAYERS and PHENOMENA bits.
+     *
+     * The class is non-instantiable.
+     */
+    class RecordDiff
+    {
+    public:
+      /**
+       * @enum group
+       * @brief Change bits of the parts of a record without a presence bit.
+       */
+      enum group : uint32_t
+      {
+        FLAGS            = 1u << 24,
+        LAYERS           = 1u << 25,  // cloud layers and their number
+        PHENOMENA        = 1u << 26   // phenomenon groups and their number
+      };
+
+      /**
+       * @brief Every change bit.
+       */
+      static constexpr uint32_t ALL = ((1u << 20) - 1) | FLAGS | LAYERS
+                                                       | PHENOMENA;
+
+      /**
+       * @struct Delta
+       * @brief The changes of a station from one report to the next.
+       */
+      struct Delta
+      {
+        uint32_t icao;     // Record::PackICAO
+        uint32_t changed;  // Record::field and group bits
+        Record values;     // the new report; only changed fields matter
+      };
+
+      /**
+       * @brief Compares two records.
+       *
+       * A record compared with a zero-initialized record yields the bits of
+       * everything it reports.
+       *
+       * @param previous The earlier record.
+       * @param current The later record.
+       * @return The change bits.
+       */
+      static uint32_t Diff(const Record& previous, const Record& current);
+
+      /**
+       * @brief Copies changed fields, with their presence bits, from one
+       *        record to another.
+       *
+       * Apply(previous, current, Diff(previous, current)) makes previous
+       * equal to current.
+       *
+       * @param target The record to update.
+       * @param source The record holding the new values.
+       * @param changed The change bits of the fields to copy.
+       */
+      static void Apply(Record& target, const Record& source, uint32_t changed);
+
+      RecordDiff() = delete;
+    };
+
+    /**
+     * @class ChangeTracker
+     * @brief Keeps the last record of every station and turns a stream of
+     *        reports into a stream of deltas.
+     *
+     * A report produces a delta only if it supersedes the station's last
+     * report (see LatestCache::Supersedes()) and differs from it. The first
+     * report of a station produces a delta of everything it reports.
+     *
+     * Not thread safe; use one instance per stream.
+     */
+    class ChangeTracker
+    {
+    public:
+      /**
+       * @brief Constructs an empty tracker.
+       *
+       * @param max_stations The expected number of stations.
+       */
+      explicit ChangeTracker(size_t max_stations = 0);
+
+      ~ChangeTracker() = default;
+
+      ChangeTracker(const ChangeTracker&) = delete;
+      ChangeTracker& operator=(const ChangeTracker&) = delete;
+
+      /**
+       * @brief Offers a report.
+       *
+       * @param record The report; its icao field selects the station.
+       * @param delta Receives the changes if the function returns true.
+       * @return True if the report changed its station.
+       */
+      bool Update(const Record& record, RecordDiff::Delta& delta);
+
+      /**
+       * @brief Retrieves the last record of a station.
+       *
+       * @param icao The packed station identifier.
+       * @return The record, or a null pointer if the station is unknown.
+       */
+      const Record *Get(uint32_t icao) const;
+
+      /**
+       * @brief Retrieves the number of stations tracked.
+       *
+       * @return The number of stations.
+       */
+      size_t Size() const { return _last.size(); }
+
+    private:
+      std::unordered_map<uint32_t, Record> _last;
+    };
+  }
+}
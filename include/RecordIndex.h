@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Station and time index of archived records
+//
+
+#pragma once
+
+#include "Record.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    class MappedRecords;
+
+    /**
+     * @class RecordIndex
+     * @brief Maps (station, observation time) keys to the positions of
+     *        records in a record file or archive.
+     *
+     * The keys are kept sorted in blocks of BLOCK_SIZE entries. The first key
+     * of every block is copied into a small fence array, so a lookup is a
+     * binary search of the fences followed by a binary search within one
+     * block. Records without a station or an observation time are not
+     * indexed.
+     */
+    class RecordIndex
+    {
+    public:
+      /**
+       * @brief Number of entries per block.
+       */
+      static constexpr size_t BLOCK_SIZE = 128;
+
+      /**
+       * @brief Identifies a serialized index.
+       */
+      static constexpr char MAGIC[4] = { 'M', 'T', 'R', 'I' };
+
+      /**
+       * @brief Version of the serialized index.
+       */
+      static constexpr uint16_t VERSION = 1;
+
+      /**
+       * @brief Indexes a sequence of records.
+       *
+       * @param records The records; positions are indices into this span.
+       */
+      explicit RecordIndex(std::span<const Record> records);
+
+      /**
+       * @brief Indexes a mapped record file.
+       *
+       * @param records The file; positions are record indices in the file.
+       */
+      explicit RecordIndex(const MappedRecords& records);
+
+      /**
+       * @brief Reads an index written by Write().
+       *
+       * @param is The stream, opened in binary mode.
+       * @return The index, or a null pointer if the stream does not hold an
+       *         index of this version.
+       */
+      static std::shared_ptr<RecordIndex> Create(std::istream& is);
+
+      /**
+       * @brief Writes the index.
+       *
+       * @param os The stream, opened in binary mode.
+       * @return True if the index was written.
+       */
+      bool Write(std::ostream& os) const;
+
+      /**
+       * @brief Retrieves the number of indexed records.
+       *
+       * @return The number of records.
+       */
+      size_t Size() const { return _icao.size(); }
+
+      /**
+       * @brief Finds the records of a station observed in a time range.
+       *
+       * @param icao The packed station identifier (see Record::PackICAO).
+       * @param from The start of the range, seconds since the epoch.
+       * @param to The end of the range, inclusive.
+       * @param positions The positions of the records, in time order, are
+       *                  appended to this vector.
+       */
+      void Find(uint32_t icao, int64_t from, int64_t to,
+                std::vector<uint64_t>& positions) const;
+
+      /**
+       * @brief Finds the records of all stations observed in a time range.
+       *
+       * Performs one search per station.
+       *
+       * @param from The start of the range, seconds since the epoch.
+       * @param to The end of the range, inclusive.
+       * @param positions The positions of the records, ordered by station
+       *                  and time, are appended to this vector.
+       */
+      void Find(int64_t from, int64_t to,
+                std::vector<uint64_t>& positions) const;
+
+    private:
+      struct Entry
+      {
+        uint32_t icao;
+        int64_t time;
+        uint64_t position;
+      };
+
+      RecordIndex() = default;
+
+      void build(std::vector<Entry>& entries);
+      size_t lower_bound(uint32_t icao, int64_t time) const;
+
+      // sorted entries, one array per key part
+      std::vector<uint32_t> _icao;
+      std::vector<int64_t> _time;
+      std::vector<uint64_t> _position;
+
+      // first key of every block
+      std::vector<uint32_t> _fence_icao;
+      std::vector<int64_t> _fence_time;
+    };
+  }
+}
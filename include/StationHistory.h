@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Per-station observation history
+//
+
+#pragma once
+
+#include "Record.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class StationHistory
+     * @brief Keeps the last N decoded records of each station in fixed-capacity
+     *        ring buffers.
+     *
+     * Stations are keyed by their packed ICAO identifier (see
+     * Record::PackICAO) in an open-addressing table sized at construction.
+     * A single writer thread appends records; any number of reader threads
+     * take snapshots concurrently without locks. Each station is guarded by a
+     * sequence lock: readers copy the ring and retry if the writer touched it
+     * meanwhile, so a snapshot is always consistent and the writer never
+     * waits.
+     */
+    class StationHistory
+    {
+    public:
+      /**
+       * @brief Constructs an empty history store.
+       *
+       * @param max_stations The maximum number of distinct stations.
+       * @param capacity The number of records kept per station.
+       */
+      StationHistory(size_t max_stations, size_t capacity);
+
+      ~StationHistory() = default;
+
+      StationHistory(const StationHistory&) = delete;
+      StationHistory& operator=(const StationHistory&) = delete;
+
+      /**
+       * @brief Appends a record to the history of its station, overwriting the
+       *        oldest record once the station's ring is full.
+       *
+       * Must only be called from the single writer thread.
+       *
+       * @param record The record; its icao field selects the station.
+       * @return False if the record has no station or the table is full.
+       */
+      bool Append(const Record& record);
+
+      /**
+       * @brief Copies the history of a station, oldest first.
+       *
+       * Safe to call from any thread concurrently with Append().
+       *
+       * @param icao The packed station identifier.
+       * @param out Receives the records; previous contents are replaced.
+       * @return The number of records copied.
+       */
+      size_t Snapshot(uint32_t icao, std::vector<Record>& out) const;
+
+      /**
+       * @brief Retrieves the most recently appended record of a station.
+       *
+       * Safe to call from any thread concurrently with Append().
+       *
+       * @param icao The packed station identifier.
+       * @return The record, or an empty optional if the station is unknown.
+       */
+      std::optional<Record> Latest(uint32_t icao) const;
+
+      /**
+       * @brief Retrieves the number of stations in the store.
+       *
+       * @return The number of stations.
+       */
+      size_t NumStations() const
+      {
+        return _num_stations.load(std::memory_order_relaxed);
+      }
+
+      /**
+       * @brief Retrieves the number of records kept per station.
+       *
+       * @return The ring buffer capacity.
+       */
+      size_t Capacity() const { return _capacity; }
+
+    private:
+      struct Station
+      {
+        std::atomic<uint32_t> icao{0};
+        std::atomic<uint64_t> seq{0};
+        std::atomic<uint64_t> count{0};
+        std::unique_ptr<std::atomic<uint64_t>[]> ring;
+      };
+
+      const Station *find(uint32_t icao) const;
+
+      Station *insert(uint32_t icao);
+
+      const size_t _capacity;
+      const size_t _max_stations;
+      std::vector<Station> _table;
+      std::atomic<size_t> _num_stations{0};
+    };
+  }
+}
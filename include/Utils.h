@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <span>
+
 namespace Storage_B 
 {
   namespace Weather
@@ -34,6 +36,23 @@ namespace Storage_B
        */
       static double Humidity(double t, double td);
 
+      /**
+       * @brief Calculates the relative humidity from fixed-point temperature
+       *        and dew point values.
+       *
+       * The inputs are in tenths of a degree Celsius, as provided by the Metar
+       * fixed-point accessors and the Batch columns. Whole degree pairs between
+       * -70 and 60 Celsius, which covers every temperature group of a METAR
+       * report, are answered from a precomputed table built on first use.
+       * Other values, e.g., tenths from the remarks T group, fall back to
+       * Humidity(double, double). Both paths return identical results.
+       *
+       * @param t The air temperature in tenths of a degree Celsius.
+       * @param td The dew point temperature in tenths of a degree Celsius.
+       * @return The relative humidity as a percentage.
+       */
+      static double HumidityTenths(int t, int td);
+
       /**
        * @brief Calculates the wind chill temperature based on ambient temperature and wind speed.
        *
@@ -68,6 +87,62 @@ namespace Storage_B
           double humidity,
           bool celsius_flg = true);
 
+      /**
+       * @brief Calculates the relative humidity for a batch of readings.
+       *
+       * Element-wise equivalent of Humidity(double, double). The loop is branch
+       * free and uses a polynomial approximation of exp() so the compiler can
+       * vectorize it. The result differs from the scalar function by at most
+       * 1e-6 percentage points for temperatures between -80 and 60 Celsius.
+       *
+       * @param t The air temperatures in Celsius.
+       * @param td The dew point temperatures in Celsius.
+       * @param out Receives the relative humidities as percentages. Must be at
+       *            least as large as t.
+       */
+      static void Humidity(std::span<const double> t,
+                           std::span<const double> td,
+                           std::span<double> out);
+
+      /**
+       * @brief Calculates the wind chill temperature for a batch of readings.
+       *
+       * Element-wise equivalent of WindChill(double, double). pow() is replaced
+       * by polynomial exp()/log() approximations and the applicability
+       * condition by a blend, so the loop is branch free. The result differs
+       * from the scalar function by at most 1e-6 degrees for wind speeds up
+       * to 500 km/h.
+       *
+       * @param temp The ambient temperatures in degrees Celsius.
+       * @param wind_speed The wind speeds in kilometers per hour.
+       * @param out Receives the wind chill temperatures in degrees Celsius.
+       *            Must be at least as large as temp.
+       */
+      static void WindChill(std::span<const double> temp,
+                            std::span<const double> wind_speed,
+                            std::span<double> out);
+
+      /**
+       * @brief Calculates the heat index for a batch of readings.
+       *
+       * Element-wise equivalent of HeatIndex(double, double, bool). Every
+       * branch of the scalar function is evaluated and the result is selected
+       * with blends, so the loop is branch free. The result differs from the
+       * scalar function by at most 1e-9 degrees.
+       *
+       * @param temp The ambient temperatures, in Celsius or Fahrenheit based
+       *             on `celsius_flg`.
+       * @param humidity The relative humidities as percentages (0-100).
+       * @param out Receives the heat indices in the same unit as temp. Must be
+       *            at least as large as temp.
+       * @param celsius_flg Whether the temperatures are in Celsius (true) or
+       *                    Fahrenheit (false).
+       */
+      static void HeatIndex(std::span<const double> temp,
+                            std::span<const double> humidity,
+                            std::span<double> out,
+                            bool celsius_flg = true);
+
       Utils() = delete;
       Utils(const Utils&) = delete;
       Utils& operator=(const Utils&) = delete;
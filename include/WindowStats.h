@@ -0,0 +1,216 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Sliding time window statistics of station reports
+//
+
+#pragma once
+
+#include "Record.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <unordered_map>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    /**
+     * @class SlidingWindow
+     * @brief Minimum, maximum, sum and oldest value of the samples of a
+     *        trailing time window.
+     *
+     * Samples must be added in time order. The minimum and maximum are kept
+     * in monotonic deques and the sum as a running total, so adding a sample
+     * and expiring old ones take amortized constant time and every statistic
+     * is available in constant time. Values are integers, typically the
+     * fixed-point values of a Record, so the running sum is exact.
+     */
+    class SlidingWindow
+    {
+    public:
+      /**
+       * @brief Constructs an empty window.
+       *
+       * @param length The length of the window in seconds. A sample is in the
+       *               window while its time is at least the latest time
+       *               minus length.
+       */
+      explicit SlidingWindow(int64_t length);
+
+      /**
+       * @brief Adds a sample and expires the samples that left the window.
+       *
+       * @param t The time of the sample; not earlier than the previous one.
+       * @param v The value.
+       */
+      void Add(int64_t t, int64_t v);
+
+      /**
+       * @brief Expires the samples that left the window at a given time.
+       *
+       * @param now The time; not earlier than the previous sample.
+       */
+      void Advance(int64_t now);
+
+      /**
+       * @brief Removes every sample.
+       */
+      void Clear();
+
+      /**
+       * @brief Retrieves the number of samples in the window.
+       *
+       * @return The number of samples.
+       */
+      size_t Count() const { return _samples.size(); }
+
+      /// Smallest value; the window must not be empty.
+      int64_t Min() const { return _min.front().v; }
+
+      /// Largest value; the window must not be empty.
+      int64_t Max() const { return _max.front().v; }
+
+      /// Sum of the values.
+      int64_t Sum() const { return _sum; }
+
+      /// Mean of the values; the window must not be empty.
+      double Mean() const
+      {
+        return static_cast<double>(_sum) / static_cast<double>(_samples.size());
+      }
+
+      /// Value of the oldest sample; the window must not be empty.
+      int64_t First() const { return _samples.front().v; }
+
+      /// Time of the oldest sample; the window must not be empty.
+      int64_t FirstTime() const { return _samples.front().t; }
+
+      /// Value of the latest sample; the window must not be empty.
+      int64_t Last() const { return _samples.back().v; }
+
+      /// Time of the latest sample; the window must not be empty.
+      int64_t LastTime() const { return _samples.back().t; }
+
+    private:
+      struct Sample
+      {
+        int64_t t;
+        int64_t v;
+      };
+
+      int64_t _length;
+      int64_t _sum = 0;
+      std::deque<Sample> _samples;
+      std::deque<Sample> _min;  // increasing values
+      std::deque<Sample> _max;  // decreasing values
+    };
+
+    /**
+     * @class StationWindows
+     * @brief Keeps windowed statistics of every station's reports up to date.
+     *
+     * Each report updates the windows of its station in amortized constant
+     * time:
+     *   - the 3 hour pressure tendency, from the altimeter setting (A or Q),
+     *     or the sea-level pressure if no altimeter setting is reported; the
+     *     window starts over when a station's source changes, so samples of
+     *     different sources are never compared
+     *   - the 1 hour maximum wind gust
+     *   - the 24 hour minimum, maximum and mean temperature, using the
+     *     remarks T group tenths when reported
+     *
+     * Reports need an observation time (see Metar::Create() with a reference
+     * time) and are expected in time order per station; reports not later
+     * than the station's last report are ignored.
+     *
+     * Not thread safe; use one instance per stream.
+     */
+    class StationWindows
+    {
+    public:
+      /// Length of the pressure tendency window in seconds.
+      static constexpr int64_t PRESSURE_WINDOW = 3 * 3600;
+
+      /// Least time covered by the pressure samples for a tendency, so that
+      /// reports a few minutes late or early still count as 3 hours apart.
+      static constexpr int64_t PRESSURE_MIN_SPAN = 150 * 60;
+
+      /// Length of the maximum gust window in seconds.
+      static constexpr int64_t GUST_WINDOW = 3600;
+
+      /// Length of the temperature window in seconds.
+      static constexpr int64_t TEMPERATURE_WINDOW = 24 * 3600;
+
+      /**
+       * @struct Stats
+       * @brief The windowed statistics of a station.
+       */
+      struct Stats
+      {
+        std::optional<double> pressure_tendency;  // hPa over the window
+        std::optional<double> max_gust;           // knots
+        std::optional<double> min_temperature;    // degrees Celsius
+        std::optional<double> max_temperature;    // degrees Celsius
+        std::optional<double> mean_temperature;   // degrees Celsius
+      };
+
+      StationWindows() = default;
+
+      StationWindows(const StationWindows&) = delete;
+      StationWindows& operator=(const StationWindows&) = delete;
+
+      /**
+       * @brief Adds a report to the windows of its station.
+       *
+       * @param record The report.
+       * @return False if the report has no station or observation time, or
+       *         is not later than the station's last report.
+       */
+      bool Update(const Record& record);
+
+      /**
+       * @brief Retrieves the statistics of a station as of its last report.
+       *
+       * @param icao The packed station identifier.
+       * @return The statistics, or an empty optional if the station is
+       *         unknown.
+       */
+      std::optional<Stats> Get(uint32_t icao) const;
+
+      /**
+       * @brief Retrieves the number of stations.
+       *
+       * @return The number of stations.
+       */
+      size_t Size() const { return _stations.size(); }
+
+    private:
+      // the report value a station's pressure window is fed from
+      enum class PressureSource : uint8_t
+      {
+        NONE,
+        ALTIMETER_Q,
+        ALTIMETER_A,
+        SEA_LEVEL_PRESS
+      };
+
+      static std::optional<int64_t> pressure(const Record& r,
+                                             PressureSource source);
+
+      struct Windows
+      {
+        int64_t last = 0;
+        PressureSource pressure_source = PressureSource::NONE;
+        SlidingWindow pressure{ PRESSURE_WINDOW };       // tenths of hPa
+        SlidingWindow gust{ GUST_WINDOW };               // tenths of knots
+        SlidingWindow temperature{ TEMPERATURE_WINDOW }; // tenths of degrees
+      };
+
+      std::unordered_map<uint32_t, Windows> _stations;
+    };
+  }
+}
@@ -0,0 +1,221 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Station and time bucket aggregation over columnar batches
+//
+
+#include "Aggregate.h"
+
+#include "Batch.h"
+#include "Civil.h"
+#include "Convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  typedef Aggregate::Group Group;
+  typedef Aggregate::Stats Stats;
+
+  // reports normalized per range, to keep the conversion buffers in cache
+  constexpr size_t CHUNK = 4096;
+
+  // fewer reports per thread are not worth a thread
+  constexpr size_t MIN_PER_THREAD = 16384;
+
+  struct Key
+  {
+    uint32_t icao;
+    int64_t start;
+
+    bool operator==(const Key&) const = default;
+  };
+
+  struct KeyHash
+  {
+    size_t operator()(const Key& k) const
+    {
+      uint64_t h = (static_cast<uint64_t>(k.icao) << 32)
+                 ^ static_cast<uint64_t>(k.start);
+      h *= 0x9E3779B97F4A7C15ULL;
+      return static_cast<size_t>(h ^ (h >> 32));
+    }
+  };
+
+  typedef std::unordered_map<Key, Group, KeyHash> Table;
+
+  inline void add(Stats& s, double v)
+  {
+    s.count++;
+    s.min = std::min(s.min, v);
+    s.max = std::max(s.max, v);
+    s.sum += v;
+  }
+
+  inline void merge(Stats& s, const Stats& o)
+  {
+    s.count += o.count;
+    s.min = std::min(s.min, o.min);
+    s.max = std::max(s.max, o.max);
+    s.sum += o.sum;
+  }
+
+  inline double tenths(int32_t v)
+  {
+    return v == Batch::NONE ? NAN : v / 10.0;
+  }
+
+  // aggregates reports [first, last) into a thread-local table
+  void aggregate(const Batch& batch, Aggregate::bucket b,
+                 size_t first, size_t last, Table& table)
+  {
+    double knots[CHUNK];
+    double altimeter[CHUNK];
+
+    for (size_t i = first ; i < last ; i += CHUNK)
+    {
+      const size_t n = std::min(CHUNK, last - i);
+
+      Convert::SpeedsToKnots(batch.WindSpeed().subspan(i, n),
+                             batch.WindSpeedUnits().subspan(i, n),
+                             std::span<double>(knots, n));
+      Convert::AltimetersToMb(batch.AltimeterA().subspan(i, n),
+                              batch.AltimeterQ().subspan(i, n),
+                              std::span<double>(altimeter, n));
+
+      for (size_t j = 0 ; j < n ; j++)
+      {
+        const size_t r = i + j;
+        const uint32_t icao = batch.Station()[r];
+        const int64_t t = batch.ObservationTime()[r];
+        if (icao == 0 || t == Batch::NONE64) continue;
+
+        Key key{ icao, Aggregate::BucketStart(t, b) };
+        auto it = table.try_emplace(key, Group{ icao, key.start, 0, {} }).first;
+        Group& g = it->second;
+        g.reports++;
+
+        const double values[Aggregate::NUM_FIELDS] =
+        {
+          tenths(batch.Temperature()[r]),
+          tenths(batch.DewPoint()[r]),
+          knots[j],
+          tenths(batch.SeaLevelPressure()[r]),
+          altimeter[j]
+        };
+
+        for (size_t f = 0 ; f < Aggregate::NUM_FIELDS ; f++)
+        {
+          if (!std::isnan(values[f])) add(g.stats[f], values[f]);
+        }
+      }
+    }
+  }
+}
+
+int64_t Aggregate::BucketStart(int64_t t, bucket b)
+{
+  const int64_t days = t / 86400 - (t % 86400 < 0);
+
+  switch (b)
+  {
+    case bucket::HOUR:
+      return (t / 3600 - (t % 3600 < 0)) * 3600;
+    case bucket::DAY:
+      return days * 86400;
+    case bucket::MONTH:
+    {
+      int64_t y;
+      unsigned int m;
+      Civil::civil_from_days(days, y, m);
+      return Civil::days_from_civil(y, m, 1) * 86400;
+    }
+  }
+  return t;
+}
+
+void Aggregate::GroupBy(const Batch& batch, bucket b,
+                        std::vector<Group>& groups, unsigned int threads)
+{
+  const size_t n = batch.Size();
+
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = static_cast<unsigned int>(
+    std::max<size_t>(1, std::min<size_t>(threads, n / MIN_PER_THREAD)));
+
+  std::vector<Table> tables(threads);
+  std::vector<std::exception_ptr> errors(threads);
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+
+  const size_t per_thread = (n + threads - 1) / threads;
+  auto range = [&](unsigned int t) {
+    size_t first = std::min(n, t * per_thread);
+    size_t last = std::min(n, first + per_thread);
+    try
+    {
+      aggregate(batch, b, first, last, tables[t]);
+    }
+    catch (...)
+    {
+      errors[t] = std::current_exception();
+    }
+  };
+
+  // ranges no thread could be started for run on the calling thread
+  unsigned int t = 1;
+  for ( ; t < threads ; t++)
+  {
+    try
+    {
+      workers.emplace_back(range, t);
+    }
+    catch (const std::system_error&)
+    {
+      break;
+    }
+  }
+  range(0);
+  for ( ; t < threads ; t++) range(t);
+
+  for (auto& w : workers) w.join();
+
+  for (const auto& e : errors)
+  {
+    if (e) std::rethrow_exception(e);
+  }
+
+  // merge the partial aggregates into the first table
+  Table& result = tables[0];
+  for (unsigned int t = 1 ; t < threads ; t++)
+  {
+    for (const auto& [key, group] : tables[t])
+    {
+      auto [it, inserted] = result.try_emplace(key, group);
+      if (inserted) continue;
+
+      Group& g = it->second;
+      g.reports += group.reports;
+      for (size_t f = 0 ; f < NUM_FIELDS ; f++)
+      {
+        merge(g.stats[f], group.stats[f]);
+      }
+    }
+  }
+
+  groups.clear();
+  groups.reserve(result.size());
+  for (const auto& entry : result) groups.push_back(entry.second);
+
+  std::sort(groups.begin(), groups.end(),
+            [](const Group& a, const Group& c) {
+              return a.icao < c.icao || (a.icao == c.icao && a.start < c.start);
+            });
+}
@@ -0,0 +1,781 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Incremental evaluation of alert rules
+//
+
+#include "AlertEngine.h"
+
+#include "Batch.h"
+#include "Convert.h"
+#include "LatestCache.h"
+#include "Metar.h"
+#include "RecordDiff.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <strings.h>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  // a value of a report and the index of its unit, see Filter
+  struct Value
+  {
+    bool present;
+    double v;
+    unsigned int unit;
+  };
+
+  Value value(const Record& r, Filter::field f)
+  {
+    switch (f)
+    {
+      case Filter::field::VISIBILITY:
+        // as in Batch, CAVOK is reported as its visibility in meters
+        if (r.flags & Record::CAVOK)
+        {
+          return { true, static_cast<double>(Batch::CAVOK_VISIBILITY),
+                   static_cast<unsigned int>(Metar::distance_units::M) };
+        }
+        return { r.Has(Record::VISIBILITY), static_cast<double>(r.visibility),
+                 r.vis_units };
+      case Filter::field::CEILING:
+        return { r.Has(Record::CEILING), static_cast<double>(r.ceiling), 0 };
+      case Filter::field::WIND_SPEED:
+        return { r.Has(Record::WIND_SPEED) && r.Has(Record::WIND_UNITS),
+                 static_cast<double>(r.wind_speed), r.wind_units };
+      case Filter::field::WIND_GUST:
+        return { r.Has(Record::WIND_GUST) && r.Has(Record::WIND_UNITS),
+                 static_cast<double>(r.wind_gust), r.wind_units };
+      case Filter::field::TEMPERATURE:
+        if (r.Has(Record::TEMPERATURE_NA))
+          return { true, static_cast<double>(r.temperature_na), 0 };
+        return { r.Has(Record::TEMPERATURE), r.temperature * 10.0, 0 };
+      case Filter::field::DEW_POINT:
+        if (r.Has(Record::DEW_POINT_NA))
+          return { true, static_cast<double>(r.dew_point_na), 0 };
+        return { r.Has(Record::DEW_POINT), r.dew_point * 10.0, 0 };
+      case Filter::field::SEA_LEVEL_PRESSURE:
+        return { r.Has(Record::SEA_LEVEL_PRESS),
+                 static_cast<double>(r.sea_level_press), 0 };
+      case Filter::field::FLIGHT_CATEGORY:
+        return { r.Has(Record::FLIGHT_CATEGORY),
+                 static_cast<double>(r.flight_category), 0 };
+    }
+    return { false, 0, 0 };
+  }
+
+  uint32_t fields(Filter::field f)
+  {
+    switch (f)
+    {
+      case Filter::field::VISIBILITY:
+        return static_cast<uint32_t>(Record::VISIBILITY) | RecordDiff::FLAGS;
+      case Filter::field::CEILING:
+        return Record::CEILING;
+      case Filter::field::WIND_SPEED:
+        return Record::WIND_SPEED | Record::WIND_UNITS;
+      case Filter::field::WIND_GUST:
+        return Record::WIND_GUST | Record::WIND_UNITS;
+      case Filter::field::TEMPERATURE:
+        return Record::TEMPERATURE | Record::TEMPERATURE_NA;
+      case Filter::field::DEW_POINT:
+        return Record::DEW_POINT | Record::DEW_POINT_NA;
+      case Filter::field::SEA_LEVEL_PRESSURE:
+        return Record::SEA_LEVEL_PRESS;
+      case Filter::field::FLIGHT_CATEGORY:
+        return Record::FLIGHT_CATEGORY;
+    }
+    return 0;
+  }
+
+  bool compare(double a, Filter::op o, double b)
+  {
+    switch (o)
+    {
+      case Filter::op::LT: return a < b;
+      case Filter::op::LE: return a <= b;
+      case Filter::op::GT: return a > b;
+      case Filter::op::GE: return a >= b;
+      case Filter::op::EQ: return a == b;
+      case Filter::op::NE: return a != b;
+    }
+    return false;
+  }
+
+  // thresholds of a comparison in the units the values are reported in, as
+  // Filter does
+  void thresholds(Filter::field f, double value, double t[3])
+  {
+    switch (f)
+    {
+      case Filter::field::VISIBILITY:
+      {
+        // indexed by Metar::distance_units
+        const double m = Convert::Miles2Km(value) * 1000.0;
+        t[0] = m;
+        t[1] = value * Metar::VISIBILITY_SM_SCALE;
+        t[2] = m;
+        break;
+      }
+      case Filter::field::WIND_SPEED:
+      case Filter::field::WIND_GUST:
+        // indexed by Metar::speed_units
+        t[0] = value;
+        t[1] = Convert::Kts2Mps(value);
+        t[2] = Convert::Kts2Kph(value);
+        break;
+      case Filter::field::TEMPERATURE:
+      case Filter::field::DEW_POINT:
+      case Filter::field::SEA_LEVEL_PRESSURE:
+        t[0] = t[1] = t[2] = value * 10;
+        break;
+      case Filter::field::CEILING:
+      case Filter::field::FLIGHT_CATEGORY:
+        t[0] = t[1] = t[2] = value;
+        break;
+    }
+  }
+}
+
+AlertEngine::Condition AlertEngine::Condition::Compare(Filter::field f,
+                                                       Filter::op o,
+                                                       double value)
+{
+  Condition c;
+  c._field = f;
+  c._op = o;
+
+  thresholds(f, value, c._t);
+
+  return c;
+}
+
+AlertEngine::Condition AlertEngine::Condition::Weather(
+  Phenom::phenom p, Phenom::intensity min_intensity, uint16_t attributes)
+{
+  Condition c;
+  c._weather = true;
+  c._phenom = static_cast<uint8_t>(p);
+  c._intensity = static_cast<int8_t>(min_intensity);
+  c._attributes = attributes;
+  return c;
+}
+
+bool AlertEngine::Condition::Matches(const Record& r) const
+{
+  if (_weather)
+  {
+    for (unsigned int i = 0 ; i < r.num_phenomena ; i++)
+    {
+      const Record::Phenomenon& p = r.phenomena[i];
+      if (p.intensity < _intensity
+       || (p.attributes & _attributes) != _attributes)
+        continue;
+
+      for (uint8_t code : p.phenom)
+      {
+        if (code == _phenom) return true;
+      }
+    }
+    return false;
+  }
+
+  Value v = value(r, _field);
+  return v.present && v.unit < 3 && compare(v.v, _op, _t[v.unit]);
+}
+
+uint32_t AlertEngine::Condition::Fields() const
+{
+  return _weather ? RecordDiff::PHENOMENA : fields(_field);
+}
+
+//
+// compiled expressions
+//
+
+struct AlertEngine::Predicate::Compiler
+{
+  const char *p;
+  Predicate& pred;
+  unsigned int nesting = 0;
+  unsigned int stack = 0;
+  bool ok = true;
+
+  void emit(const Instruction& ins)
+  {
+    switch (ins.code)
+    {
+      case opcode::COMPARE:
+      case opcode::WEATHER:
+        if (++stack > MAX_DEPTH) ok = false;
+        break;
+      case opcode::AND:
+      case opcode::OR:
+        stack--;
+        break;
+      case opcode::NOT:
+        break;
+    }
+    pred._code.push_back(ins);
+  }
+
+  void skip()
+  {
+    while (isspace(static_cast<unsigned char>(*p))) p++;
+  }
+
+  static bool word_char(char c)
+  {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_';
+  }
+
+  // a case insensitive keyword or name, not followed by a word character
+  bool keyword(const char *kw)
+  {
+    skip();
+    size_t n = strlen(kw);
+    if (strncasecmp(p, kw, n) != 0 || word_char(p[n])) return false;
+    p += n;
+    return true;
+  }
+
+  bool symbol(const char *sym)
+  {
+    skip();
+    size_t n = strlen(sym);
+    if (strncmp(p, sym, n) != 0) return false;
+    p += n;
+    return true;
+  }
+
+  // expr := term (or term)*
+  void expr()
+  {
+    term();
+    while (ok && (keyword("or") || symbol("||")))
+    {
+      term();
+      emit(op(opcode::OR));
+    }
+  }
+
+  // term := factor (and factor)*
+  void term()
+  {
+    factor();
+    while (ok && (keyword("and") || symbol("&&")))
+    {
+      factor();
+      emit(op(opcode::AND));
+    }
+  }
+
+  // factor := not factor | ( expr ) | comparison | weather
+  void factor()
+  {
+    if (++nesting > MAX_DEPTH)
+    {
+      ok = false;
+      return;
+    }
+
+    if (keyword("not") || symbol("!"))
+    {
+      factor();
+      emit(op(opcode::NOT));
+    }
+    else if (symbol("("))
+    {
+      expr();
+      if (!symbol(")")) ok = false;
+    }
+    else if (!comparison())
+    {
+      weather();
+    }
+
+    nesting--;
+  }
+
+  bool comparison()
+  {
+    static const struct
+    {
+      const char *name;
+      Filter::field f;
+    } NAMES[] =
+    {
+      { "visibility", Filter::field::VISIBILITY },
+      { "ceiling", Filter::field::CEILING },
+      { "wind", Filter::field::WIND_SPEED },
+      { "gust", Filter::field::WIND_GUST },
+      { "temperature", Filter::field::TEMPERATURE },
+      { "dew_point", Filter::field::DEW_POINT },
+      { "slp", Filter::field::SEA_LEVEL_PRESSURE },
+      { "category", Filter::field::FLIGHT_CATEGORY }
+    };
+
+    static const struct
+    {
+      const char *sym;
+      Filter::op o;
+    } OPS[] =
+    {
+      // longest first
+      { "<=", Filter::op::LE }, { ">=", Filter::op::GE },
+      { "==", Filter::op::EQ }, { "!=", Filter::op::NE },
+      { "<", Filter::op::LT }, { ">", Filter::op::GT }
+    };
+
+    static const char *CATEGORIES[] = { "VFR", "MVFR", "IFR", "LIFR" };
+
+    const char *start = p;
+    for (const auto& n : NAMES)
+    {
+      if (!keyword(n.name)) continue;
+
+      for (const auto& o : OPS)
+      {
+        if (!symbol(o.sym)) continue;
+
+        skip();
+        double value = 0;
+        bool found = false;
+        if (n.f == Filter::field::FLIGHT_CATEGORY)
+        {
+          for (unsigned int i = 0 ; i < 4 && !found ; i++)
+          {
+            if (keyword(CATEGORIES[i]))
+            {
+              value = i;
+              found = true;
+            }
+          }
+        }
+        if (!found)
+        {
+          char *end;
+          value = strtod(p, &end);
+          if (end == p || word_char(*end))
+          {
+            ok = false;
+            return true;
+          }
+          p = end;
+        }
+
+        emit(compare(n.f, o.o, value));
+        return true;
+      }
+
+      // a field name must be followed by an operator
+      ok = false;
+      return true;
+    }
+
+    p = start;
+    return false;
+  }
+
+  // whether every two letters of a weather group are a descriptor or
+  // phenomenon; Phenom::Create() skips those it does not know
+  static bool recognised(const char *group)
+  {
+    static const char *const codes[] = {
+      "BC", "BL", "DR", "FZ", "MI", "PR", "SH", "TS", "VC",
+      "BR", "DS", "DU", "DZ", "FC", "FG", "FU", "GR", "GS", "HZ", "IC",
+      "PE", "PL", "PO", "PY", "RA", "SA", "SG", "SN", "SQ", "SS", "UP", "VA"
+    };
+
+    if (*group == '+' || *group == '-') group++;
+    if (*group == '\0' || strlen(group) % 2 != 0) return false;
+
+    for ( ; *group != '\0' ; group += 2)
+    {
+      auto known = [&](const char *code) { return !strncmp(group, code, 2); };
+      if (std::none_of(std::begin(codes), std::end(codes), known))
+        return false;
+    }
+    return true;
+  }
+
+  void weather()
+  {
+    skip();
+
+    char group[16];
+    size_t n = 0;
+    if (*p == '+' || *p == '-') group[n++] = *p++;
+    while (isalpha(static_cast<unsigned char>(*p)) && n < sizeof(group) - 1)
+    {
+      group[n++] = static_cast<char>(toupper(static_cast<unsigned char>(*p++)));
+    }
+    group[n] = '\0';
+
+    auto phenom = Phenom::Create(group);
+    if (word_char(*p) || phenom == nullptr || !recognised(group))
+    {
+      ok = false;
+      return;
+    }
+
+    Record::Phenomenon g = Record::Phenomenon::Create(*phenom);
+
+    Instruction ins = op(opcode::WEATHER);
+    ins.attributes = g.attributes;
+    // without a sign, any intensity
+    ins.intensity = static_cast<int8_t>(Phenom::intensity::LIGHT);
+    ins.max_intensity = static_cast<int8_t>(Phenom::intensity::HEAVY);
+    if (g.intensity != static_cast<int8_t>(Phenom::intensity::NORMAL))
+      ins.intensity = ins.max_intensity = g.intensity;
+    memcpy(ins.phenom, g.phenom, sizeof(ins.phenom));
+    emit(ins);
+
+    pred._fields |= RecordDiff::PHENOMENA;
+  }
+
+  static Instruction op(opcode code)
+  {
+    Instruction ins;
+    memset(&ins, 0, sizeof(ins));
+    ins.code = code;
+    ins.units = -1;
+    return ins;
+  }
+
+  static Load load(size_t offset, size_t size, bool is_signed,
+                   uint32_t present, double scale = 1)
+  {
+    return Load{ static_cast<uint16_t>(offset), static_cast<uint8_t>(size),
+                 is_signed, present, scale };
+  }
+
+  Instruction compare(Filter::field f, Filter::op o, double value)
+  {
+    Instruction ins = op(opcode::COMPARE);
+    ins.cmp = o;
+    thresholds(f, value, ins.t);
+
+    switch (f)
+    {
+      case Filter::field::VISIBILITY:
+        ins.value = load(offsetof(Record, visibility), 4, true,
+                         Record::VISIBILITY);
+        ins.units = offsetof(Record, vis_units);
+        ins.flag = Record::CAVOK;
+        ins.flag_value = Batch::CAVOK_VISIBILITY;
+        ins.flag_unit = static_cast<uint8_t>(Metar::distance_units::M);
+        break;
+      case Filter::field::CEILING:
+        ins.value = load(offsetof(Record, ceiling), 4, true, Record::CEILING);
+        break;
+      case Filter::field::WIND_SPEED:
+        ins.value = load(offsetof(Record, wind_speed), 2, true,
+                         Record::WIND_SPEED | Record::WIND_UNITS);
+        ins.units = offsetof(Record, wind_units);
+        break;
+      case Filter::field::WIND_GUST:
+        ins.value = load(offsetof(Record, wind_gust), 2, true,
+                         Record::WIND_GUST | Record::WIND_UNITS);
+        ins.units = offsetof(Record, wind_units);
+        break;
+      case Filter::field::TEMPERATURE:
+        ins.value = load(offsetof(Record, temperature_na), 2, true,
+                         Record::TEMPERATURE_NA);
+        ins.fallback = load(offsetof(Record, temperature), 1, true,
+                            Record::TEMPERATURE, 10);
+        break;
+      case Filter::field::DEW_POINT:
+        ins.value = load(offsetof(Record, dew_point_na), 2, true,
+                         Record::DEW_POINT_NA);
+        ins.fallback = load(offsetof(Record, dew_point), 1, true,
+                            Record::DEW_POINT, 10);
+        break;
+      case Filter::field::SEA_LEVEL_PRESSURE:
+        ins.value = load(offsetof(Record, sea_level_press), 2, true,
+                         Record::SEA_LEVEL_PRESS);
+        break;
+      case Filter::field::FLIGHT_CATEGORY:
+        ins.value = load(offsetof(Record, flight_category), 1, false,
+                         Record::FLIGHT_CATEGORY);
+        break;
+    }
+
+    pred._fields |= fields(f);
+    return ins;
+  }
+};
+
+std::shared_ptr<AlertEngine::Predicate>
+AlertEngine::Predicate::Create(const char *expr)
+{
+  std::shared_ptr<Predicate> pred(new Predicate());
+
+  Compiler c{ expr, *pred };
+  c.expr();
+  c.skip();
+
+  if (!c.ok || *c.p != '\0' || c.stack != 1) return nullptr;
+  return pred;
+}
+
+namespace
+{
+  template<typename T>
+  inline double read(const uint8_t *base, size_t offset)
+  {
+    T v;
+    memcpy(&v, base + offset, sizeof(v));
+    return static_cast<double>(v);
+  }
+}
+
+bool AlertEngine::Predicate::Matches(const Record& r) const
+{
+  const uint8_t *base = reinterpret_cast<const uint8_t *>(&r);
+
+  auto load = [base](const Load& l) {
+    double v = 0;
+    switch (l.size)
+    {
+      case 1:
+        v = l.is_signed ? read<int8_t>(base, l.offset)
+                        : read<uint8_t>(base, l.offset);
+        break;
+      case 2:
+        v = read<int16_t>(base, l.offset);
+        break;
+      case 4:
+        v = read<int32_t>(base, l.offset);
+        break;
+    }
+    return v * l.scale;
+  };
+
+  bool stack[MAX_DEPTH];
+  unsigned int sp = 0;
+
+  for (const Instruction& ins : _code)
+  {
+    switch (ins.code)
+    {
+      case opcode::COMPARE:
+      {
+        double v;
+        unsigned int unit = 0;
+        bool present = true;
+
+        if (ins.flag != 0 && (r.flags & ins.flag))
+        {
+          v = ins.flag_value;
+          unit = ins.flag_unit;
+        }
+        else if ((r.present & ins.value.present) == ins.value.present)
+        {
+          v = load(ins.value);
+          if (ins.units >= 0) unit = base[ins.units];
+        }
+        else if (ins.fallback.size != 0
+              && (r.present & ins.fallback.present) == ins.fallback.present)
+        {
+          v = load(ins.fallback);
+        }
+        else
+        {
+          v = 0;
+          present = false;
+        }
+
+        stack[sp++] = present && unit < 3 && compare(v, ins.cmp, ins.t[unit]);
+        break;
+      }
+      case opcode::WEATHER:
+      {
+        bool match = false;
+        for (unsigned int i = 0 ; i < r.num_phenomena && !match ; i++)
+        {
+          const Record::Phenomenon& g = r.phenomena[i];
+          match = g.intensity >= ins.intensity
+               && g.intensity <= ins.max_intensity
+               && (g.attributes & ins.attributes) == ins.attributes;
+          for (uint8_t code : ins.phenom)
+          {
+            if (code != 0 && std::find(std::begin(g.phenom),
+                                       std::end(g.phenom), code)
+                             == std::end(g.phenom))
+              match = false;
+          }
+        }
+        stack[sp++] = match;
+        break;
+      }
+      case opcode::AND:
+        sp--;
+        stack[sp - 1] = stack[sp - 1] && stack[sp];
+        break;
+      case opcode::OR:
+        sp--;
+        stack[sp - 1] = stack[sp - 1] || stack[sp];
+        break;
+      case opcode::NOT:
+        stack[sp - 1] = !stack[sp - 1];
+        break;
+    }
+  }
+
+  return stack[0];
+}
+
+//
+// rules
+//
+
+bool AlertEngine::matches(const Rule& rule, const Record& record) const
+{
+  for (const Condition& c : rule.conditions)
+  {
+    if (!c.Matches(record)) return false;
+  }
+  return rule.predicate == nullptr || rule.predicate->Matches(record);
+}
+
+uint32_t AlertEngine::Add(const std::vector<uint32_t>& stations,
+                          const std::vector<Condition>& conditions)
+{
+  Rule rule;
+  rule.stations = stations;
+  rule.conditions = conditions;
+  for (const Condition& c : conditions) rule.fields |= c.Fields();
+  return add(std::move(rule));
+}
+
+uint32_t AlertEngine::Add(const std::vector<uint32_t>& stations,
+                          std::shared_ptr<const Predicate> predicate)
+{
+  Rule rule;
+  rule.stations = stations;
+  rule.fields = predicate->Fields();
+  rule.predicate = std::move(predicate);
+  return add(std::move(rule));
+}
+
+uint32_t AlertEngine::add(Rule rule)
+{
+  const uint32_t id = static_cast<uint32_t>(_rules.size());
+  const std::vector<uint32_t>& stations = rule.stations;
+
+  const std::vector<uint32_t> any = { 0 };
+  for (uint32_t icao : stations.empty() ? any : stations)
+  {
+    for (uint32_t bits = rule.fields ; bits != 0 ; bits &= bits - 1)
+    {
+      _index[key(icao, std::countr_zero(bits))].push_back(id);
+    }
+  }
+
+  // initial state from the reports seen so far
+  for (const auto& station : _last)
+  {
+    bool applies = stations.empty()
+                || std::find(stations.begin(), stations.end(), station.first)
+                   != stations.end();
+    if (applies && rule.fields != 0 && matches(rule, station.second))
+      _active.insert(state(id, station.first));
+  }
+
+  _rules.push_back(std::move(rule));
+  _num_rules++;
+  return id;
+}
+
+bool AlertEngine::Remove(uint32_t id)
+{
+  if (id >= _rules.size() || _rules[id].removed) return false;
+
+  Rule& rule = _rules[id];
+
+  const std::vector<uint32_t> any = { 0 };
+  for (uint32_t icao : rule.stations.empty() ? any : rule.stations)
+  {
+    for (uint32_t bits = rule.fields ; bits != 0 ; bits &= bits - 1)
+    {
+      auto it = _index.find(key(icao, std::countr_zero(bits)));
+      if (it == _index.end()) continue;
+      std::erase(it->second, id);
+      if (it->second.empty()) _index.erase(it);
+    }
+  }
+
+  std::erase_if(_active, [id](uint64_t s) { return (s >> 32) == id; });
+
+  rule.removed = true;
+  rule.stations.clear();
+  rule.conditions.clear();
+  rule.predicate.reset();
+  _num_rules--;
+  return true;
+}
+
+void AlertEngine::Evaluate(const Record& record, std::vector<Event>& events)
+{
+  const uint32_t icao = record.icao;
+  if (icao == 0) return;
+
+  auto [it, inserted] = _last.try_emplace(icao);
+  Record& last = it->second;
+  if (inserted)
+  {
+    memset(&last, 0, sizeof(last));
+  }
+  else if (!LatestCache::Supersedes(record, last))
+  {
+    return;
+  }
+
+  const uint32_t changed = RecordDiff::Diff(last, record);
+  last = record;
+  if (changed == 0) return;
+
+  // a rule reading several changed fields is evaluated once
+  _epoch++;
+
+  for (uint32_t bits = changed ; bits != 0 ; bits &= bits - 1)
+  {
+    const unsigned int bit = std::countr_zero(bits);
+
+    for (uint32_t scope : { icao, 0u })
+    {
+      auto idx = _index.find(key(scope, bit));
+      if (idx == _index.end()) continue;
+
+      for (uint32_t id : idx->second)
+      {
+        Rule& rule = _rules[id];
+        if (rule.stamp == _epoch) continue;
+        rule.stamp = _epoch;
+        _evaluations++;
+
+        const bool now = matches(rule, record);
+        const uint64_t s = state(id, icao);
+        if (now == (_active.count(s) != 0)) continue;
+
+        if (now) _active.insert(s);
+        else _active.erase(s);
+        events.push_back({ id, icao, now });
+      }
+    }
+  }
+}
+
+bool AlertEngine::Active(uint32_t rule, uint32_t icao) const
+{
+  return _active.count(state(rule, icao)) != 0;
+}
@@ -0,0 +1,766 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Columnar archive of decoded METAR records
+//
+
+#include "Archive.h"
+
+#include "Varint.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <map>
+#include <type_traits>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  typedef Archive::column column;
+  typedef Archive::encoding encoding;
+
+  // footer offset and MAGIC
+  constexpr size_t TRAILER_SIZE = 12;
+  constexpr size_t HEADER_SIZE = 8;
+
+  //
+  // scalar columns
+  //
+
+  struct Scalar
+  {
+    uint32_t field;  // presence bit, 0 if always present
+    int64_t (*get)(const Record&);
+    void (*set)(Record&, int64_t);
+  };
+
+  template<auto M>
+  int64_t get(const Record& r)
+  {
+    return static_cast<int64_t>(r.*M);
+  }
+
+  template<auto M>
+  void set(Record& r, int64_t v)
+  {
+    r.*M = static_cast<std::remove_reference_t<decltype(r.*M)>>(v);
+  }
+
+  template<auto M>
+  constexpr Scalar scalar(uint32_t field)
+  {
+    return { field, get<M>, set<M> };
+  }
+
+  // in column order
+  const Scalar SCALARS[] =
+  {
+    scalar<&Record::icao>(Record::ICAO),
+    scalar<&Record::present>(0),
+    scalar<&Record::obs_time>(Record::OBSERVATION_TIME),
+    scalar<&Record::visibility>(Record::VISIBILITY),
+    scalar<&Record::ceiling>(Record::CEILING),
+    scalar<&Record::vertical_vis>(Record::VERTICAL_VIS),
+    scalar<&Record::wind_dir>(Record::WIND_DIRECTION),
+    scalar<&Record::wind_speed>(Record::WIND_SPEED),
+    scalar<&Record::wind_gust>(Record::WIND_GUST),
+    scalar<&Record::min_wind_dir>(Record::WIND_RANGE),
+    scalar<&Record::max_wind_dir>(Record::WIND_RANGE),
+    scalar<&Record::temperature_na>(Record::TEMPERATURE_NA),
+    scalar<&Record::dew_point_na>(Record::DEW_POINT_NA),
+    scalar<&Record::altimeter_a>(Record::ALTIMETER_A),
+    scalar<&Record::altimeter_q>(Record::ALTIMETER_Q),
+    scalar<&Record::sea_level_press>(Record::SEA_LEVEL_PRESS),
+    scalar<&Record::temperature>(Record::TEMPERATURE),
+    scalar<&Record::dew_point>(Record::DEW_POINT),
+    scalar<&Record::day>(Record::TIME),
+    scalar<&Record::hour>(Record::TIME),
+    scalar<&Record::minute>(Record::TIME),
+    scalar<&Record::message_type>(Record::MESSAGE_TYPE),
+    scalar<&Record::wind_units>(Record::WIND_UNITS),
+    scalar<&Record::vis_units>(Record::VISIBILITY),
+    scalar<&Record::flight_category>(Record::FLIGHT_CATEGORY),
+    scalar<&Record::flags>(0),
+    scalar<&Record::num_layers>(0),
+    scalar<&Record::num_phenomena>(0)
+  };
+
+  constexpr size_t NUM_SCALARS = sizeof(SCALARS) / sizeof(SCALARS[0]);
+
+  static_assert(NUM_SCALARS == static_cast<size_t>(column::LAYER_ALTITUDE));
+
+  // values of a column with the presence of each value
+  void extract(const std::vector<Record>& rows, size_t c,
+               std::vector<int64_t>& values, std::vector<bool>& present)
+  {
+    values.clear();
+    present.clear();
+
+    if (c < NUM_SCALARS)
+    {
+      for (const auto& r : rows)
+      {
+        values.push_back(SCALARS[c].get(r));
+        present.push_back(SCALARS[c].field == 0
+                          || (r.present & SCALARS[c].field));
+      }
+      return;
+    }
+
+    for (const auto& r : rows)
+    {
+      switch (static_cast<column>(c))
+      {
+        case column::LAYER_ALTITUDE:
+          for (size_t i = 0 ; i < r.num_layers ; i++)
+            values.push_back(r.layers[i].altitude);
+          break;
+        case column::LAYER_COVER:
+          for (size_t i = 0 ; i < r.num_layers ; i++)
+            values.push_back(r.layers[i].cover);
+          break;
+        case column::LAYER_TYPE:
+          for (size_t i = 0 ; i < r.num_layers ; i++)
+            values.push_back(r.layers[i].type);
+          break;
+        case column::LAYER_TEMPO:
+          for (size_t i = 0 ; i < r.num_layers ; i++)
+            values.push_back(r.layers[i].tempo);
+          break;
+        case column::PHENOMENON_ATTRIBUTES:
+          for (size_t i = 0 ; i < r.num_phenomena ; i++)
+            values.push_back(r.phenomena[i].attributes);
+          break;
+        case column::PHENOMENON_INTENSITY:
+          for (size_t i = 0 ; i < r.num_phenomena ; i++)
+            values.push_back(r.phenomena[i].intensity);
+          break;
+        default:
+          for (size_t i = 0 ; i < r.num_phenomena ; i++)
+            for (auto p : r.phenomena[i].phenom) values.push_back(p);
+          break;
+      }
+    }
+    present.assign(values.size(), true);
+  }
+
+  //
+  // byte level helpers
+  //
+
+  using Varint::zigzag;
+  using Varint::unzigzag;
+
+  inline void put_varint(std::vector<uint8_t>& out, uint64_t v)
+  {
+    Varint::put(out, v);
+  }
+
+  void put_fixed(std::vector<uint8_t>& out, uint64_t v, size_t bytes)
+  {
+    for (size_t i = 0 ; i < bytes ; i++)
+    {
+      out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+  }
+
+  inline unsigned int width(uint64_t v)
+  {
+    return static_cast<unsigned int>(std::bit_width(v));
+  }
+
+  // bit-packs values of the given width, least significant bit first
+  void pack(std::vector<uint8_t>& out, const std::vector<uint64_t>& v,
+            unsigned int w)
+  {
+    size_t base = out.size();
+    out.resize(base + (v.size() * w + 7) / 8, 0);
+
+    uint64_t pos = 0;
+    for (uint64_t x : v)
+    {
+      for (unsigned int done = 0 ; done < w ; )
+      {
+        unsigned int off = pos & 7;
+        unsigned int take = std::min(8 - off, w - done);
+        out[base + (pos >> 3)] |= static_cast<uint8_t>(((x >> done)
+                                  & ((1u << take) - 1)) << off);
+        done += take;
+        pos += take;
+      }
+    }
+  }
+
+  // bounds checked reader of an encoded chunk or footer
+  struct Cursor
+  {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool ok = true;
+
+    uint64_t varint()
+    {
+      uint64_t v;
+      if (!Varint::get(p, end, v)) ok = false;
+      return v;
+    }
+
+    uint64_t fixed(size_t bytes)
+    {
+      if (static_cast<size_t>(end - p) < bytes)
+      {
+        ok = false;
+        return 0;
+      }
+      uint64_t v = 0;
+      for (size_t i = 0 ; i < bytes ; i++)
+      {
+        v |= static_cast<uint64_t>(*p++) << (8 * i);
+      }
+      return v;
+    }
+
+    bool unpack(std::vector<uint64_t>& v, size_t n, unsigned int w)
+    {
+      if (w > 64 || (w > 0 && n > static_cast<size_t>(end - p) * 8 / w))
+      {
+        return ok = false;
+      }
+
+      v.assign(n, 0);
+      if (w == 0) return true;
+
+      uint64_t pos = 0;
+      for (auto& x : v)
+      {
+        for (unsigned int done = 0 ; done < w ; )
+        {
+          unsigned int off = pos & 7;
+          unsigned int take = std::min(8 - off, w - done);
+          x |= static_cast<uint64_t>((p[pos >> 3] >> off)
+                                     & ((1u << take) - 1)) << done;
+          done += take;
+          pos += take;
+        }
+      }
+      p += (pos + 7) / 8;
+      return true;
+    }
+  };
+
+  //
+  // column chunk encodings: encoding byte, value count, then
+  //   BIT_PACKED: zigzag min, width, packed (value - min)
+  //   DELTA:      zigzag first value, then for each block of deltas the
+  //               zigzag min delta, width and packed (delta - min delta)
+  //   DICTIONARY: dictionary size, zigzag entries, width, packed indices
+  //   RLE:        number of runs, (run length, zigzag value) pairs
+  //
+
+  // frame of reference: offsets of values from their minimum
+  void put_packed(std::vector<uint8_t>& out, const std::vector<int64_t>& v)
+  {
+    int64_t lo = *std::min_element(v.begin(), v.end());
+    std::vector<uint64_t> offsets;
+    uint64_t hi = 0;
+    for (int64_t x : v)
+    {
+      // wrapping difference, undone by the wrapping sum when decoding
+      offsets.push_back(static_cast<uint64_t>(x) - static_cast<uint64_t>(lo));
+      hi = std::max(hi, offsets.back());
+    }
+    put_varint(out, zigzag(lo));
+    out.push_back(static_cast<uint8_t>(width(hi)));
+    pack(out, offsets, width(hi));
+  }
+
+  bool get_packed(Cursor& in, size_t n, std::vector<int64_t>& v)
+  {
+    std::vector<uint64_t> offsets;
+    uint64_t lo = static_cast<uint64_t>(unzigzag(in.varint()));
+    unsigned int w = static_cast<unsigned int>(in.fixed(1));
+    if (!in.ok || !in.unpack(offsets, n, w)) return false;
+
+    v.clear();
+    for (uint64_t x : offsets) v.push_back(static_cast<int64_t>(lo + x));
+    return true;
+  }
+
+  // deltas are packed in blocks, so that an occasional large delta (e.g.,
+  // the first report of the next station) only widens its own block
+  constexpr size_t DELTA_BLOCK = 128;
+
+  void encode_delta(const std::vector<int64_t>& v, std::vector<uint8_t>& out)
+  {
+    put_varint(out, zigzag(v[0]));
+
+    std::vector<int64_t> deltas;
+    for (size_t i = 1 ; i < v.size() ; i++)
+    {
+      deltas.push_back(static_cast<int64_t>(static_cast<uint64_t>(v[i])
+                                            - static_cast<uint64_t>(v[i - 1])));
+      if (deltas.size() == DELTA_BLOCK || i + 1 == v.size())
+      {
+        put_packed(out, deltas);
+        deltas.clear();
+      }
+    }
+  }
+
+  bool encode_dictionary(const std::vector<int64_t>& v,
+                         std::vector<uint8_t>& out)
+  {
+    constexpr size_t MAX_DICTIONARY = 256;
+
+    std::map<int64_t, uint64_t> dict;
+    for (int64_t x : v)
+    {
+      dict.emplace(x, 0);
+      if (dict.size() > MAX_DICTIONARY) return false;
+    }
+
+    put_varint(out, dict.size());
+    uint64_t index = 0;
+    for (auto& entry : dict)
+    {
+      entry.second = index++;
+      put_varint(out, zigzag(entry.first));
+    }
+
+    std::vector<uint64_t> indices;
+    for (int64_t x : v) indices.push_back(dict[x]);
+
+    unsigned int w = width(dict.size() - 1);
+    out.push_back(static_cast<uint8_t>(w));
+    pack(out, indices, w);
+    return true;
+  }
+
+  void encode_rle(const std::vector<int64_t>& v, std::vector<uint8_t>& out)
+  {
+    std::vector<uint8_t> runs;
+    uint64_t num_runs = 0;
+    for (size_t i = 0 ; i < v.size() ; )
+    {
+      size_t j = i + 1;
+      while (j < v.size() && v[j] == v[i]) j++;
+      put_varint(runs, j - i);
+      put_varint(runs, zigzag(v[i]));
+      num_runs++;
+      i = j;
+    }
+    put_varint(out, num_runs);
+    out.insert(out.end(), runs.begin(), runs.end());
+  }
+
+  // encodes the chunk with the encoding giving the fewest bytes
+  encoding encode(const std::vector<int64_t>& v, std::vector<uint8_t>& out)
+  {
+    std::vector<uint8_t> candidates[4];
+    bool usable[4] = { true, true, true, true };
+
+    if (!v.empty())
+    {
+      put_packed(candidates[0], v);
+      encode_delta(v, candidates[1]);
+      usable[2] = encode_dictionary(v, candidates[2]);
+      encode_rle(v, candidates[3]);
+    }
+
+    size_t best = 0;
+    for (size_t i = 1 ; i < 4 ; i++)
+    {
+      if (usable[i] && candidates[i].size() < candidates[best].size()) best = i;
+    }
+
+    out.clear();
+    out.push_back(static_cast<uint8_t>(best));
+    put_varint(out, v.size());
+    out.insert(out.end(), candidates[best].begin(), candidates[best].end());
+    return static_cast<encoding>(best);
+  }
+
+  // 'limit' bounds the number of values accepted from a corrupt chunk
+  bool decode(const uint8_t *p, size_t size, uint64_t limit,
+              std::vector<int64_t>& v)
+  {
+    Cursor in{ p, p + size };
+    v.clear();
+
+    uint64_t enc = in.fixed(1);
+    uint64_t n = in.varint();
+    if (!in.ok || n > limit) return false;
+    if (n == 0) return true;
+
+    switch (static_cast<encoding>(enc))
+    {
+      case encoding::BIT_PACKED:
+        return get_packed(in, n, v);
+
+      case encoding::DELTA:
+      {
+        uint64_t x = static_cast<uint64_t>(unzigzag(in.varint()));
+        if (!in.ok) return false;
+        v.push_back(static_cast<int64_t>(x));
+
+        std::vector<int64_t> deltas;
+        while (v.size() < n)
+        {
+          size_t block = std::min<uint64_t>(DELTA_BLOCK, n - v.size());
+          if (!get_packed(in, block, deltas)) return false;
+          for (int64_t d : deltas)
+          {
+            x += static_cast<uint64_t>(d);
+            v.push_back(static_cast<int64_t>(x));
+          }
+        }
+        return true;
+      }
+
+      case encoding::DICTIONARY:
+      {
+        uint64_t entries = in.varint();
+        if (!in.ok || entries > size) return false;
+
+        std::vector<int64_t> dict;
+        for (uint64_t i = 0 ; i < entries ; i++)
+        {
+          dict.push_back(unzigzag(in.varint()));
+        }
+
+        std::vector<uint64_t> indices;
+        unsigned int w = static_cast<unsigned int>(in.fixed(1));
+        if (!in.ok || !in.unpack(indices, n, w)) return false;
+
+        for (uint64_t i : indices)
+        {
+          if (i >= dict.size()) return false;
+          v.push_back(dict[i]);
+        }
+        return true;
+      }
+
+      case encoding::RLE:
+      {
+        uint64_t runs = in.varint();
+        for (uint64_t i = 0 ; i < runs && in.ok ; i++)
+        {
+          uint64_t length = in.varint();
+          int64_t value = unzigzag(in.varint());
+          if (length > n - v.size()) return false;
+          v.insert(v.end(), length, value);
+        }
+        return in.ok && v.size() == n;
+      }
+    }
+    return false;
+  }
+
+  Archive::Statistics statistics(const std::vector<int64_t>& v,
+                                 const std::vector<bool>& present)
+  {
+    Archive::Statistics s{ 0, 0, 0 };
+    for (size_t i = 0 ; i < v.size() ; i++)
+    {
+      if (!present[i]) continue;
+      s.min = s.count ? std::min(s.min, v[i]) : v[i];
+      s.max = s.count ? std::max(s.max, v[i]) : v[i];
+      s.count++;
+    }
+    return s;
+  }
+}
+
+//
+// ArchiveWriter
+//
+
+ArchiveWriter::ArchiveWriter(std::ostream& os, size_t row_group_size)
+  : _os(os)
+  , _row_group_size(row_group_size > 0 ? row_group_size : 1)
+  , _offset(HEADER_SIZE)
+  , _closed(false)
+{
+  std::vector<uint8_t> header(Archive::MAGIC, Archive::MAGIC + 4);
+  put_fixed(header, Archive::VERSION, 2);
+  put_fixed(header, 0, 2);
+  _os.write(reinterpret_cast<const char *>(header.data()), header.size());
+}
+
+ArchiveWriter::~ArchiveWriter()
+{
+  Close();
+}
+
+bool ArchiveWriter::Append(const Record& record)
+{
+  if (_closed || !_os) return false;
+
+  _rows.push_back(record);
+  return _rows.size() < _row_group_size || flush();
+}
+
+bool ArchiveWriter::flush()
+{
+  if (_rows.empty()) return static_cast<bool>(_os);
+
+  std::vector<int64_t> values;
+  std::vector<bool> present;
+  std::vector<uint8_t> bytes;
+
+  for (size_t c = 0 ; c < Archive::NUM_COLUMNS ; c++)
+  {
+    extract(_rows, c, values, present);
+
+    Archive::Chunk chunk;
+    chunk.enc = encode(values, bytes);
+    chunk.offset = _offset;
+    chunk.size = bytes.size();
+    chunk.stats = statistics(values, present);
+    _chunks.push_back(chunk);
+
+    _os.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    _offset += bytes.size();
+  }
+
+  _group_rows.push_back(_rows.size());
+  _rows.clear();
+
+  return static_cast<bool>(_os);
+}
+
+// Footer: number of columns, number of row groups, then for each row group
+// its number of rows and, for each column, the chunk offset, size, encoding,
+// zigzag min, zigzag max and count.
+bool ArchiveWriter::Close()
+{
+  if (_closed) return static_cast<bool>(_os);
+  _closed = true;
+
+  if (!flush()) return false;
+
+  std::vector<uint8_t> footer;
+  put_varint(footer, Archive::NUM_COLUMNS);
+  put_varint(footer, _group_rows.size());
+  for (size_t g = 0 ; g < _group_rows.size() ; g++)
+  {
+    put_varint(footer, _group_rows[g]);
+    for (size_t c = 0 ; c < Archive::NUM_COLUMNS ; c++)
+    {
+      const auto& chunk = _chunks[g * Archive::NUM_COLUMNS + c];
+      put_varint(footer, chunk.offset);
+      put_varint(footer, chunk.size);
+      footer.push_back(static_cast<uint8_t>(chunk.enc));
+      put_varint(footer, zigzag(chunk.stats.min));
+      put_varint(footer, zigzag(chunk.stats.max));
+      put_varint(footer, chunk.stats.count);
+    }
+  }
+
+  put_fixed(footer, _offset, 8);
+  footer.insert(footer.end(), Archive::MAGIC, Archive::MAGIC + 4);
+
+  _os.write(reinterpret_cast<const char *>(footer.data()), footer.size());
+  _os.flush();
+
+  return static_cast<bool>(_os);
+}
+
+//
+// ArchiveReader
+//
+
+std::shared_ptr<ArchiveReader> ArchiveReader::Create(std::istream& is)
+{
+  is.seekg(0, std::ios::end);
+  std::streamoff size = is.tellg();
+  if (!is || size < static_cast<std::streamoff>(HEADER_SIZE + TRAILER_SIZE))
+    return nullptr;
+
+  uint8_t header[HEADER_SIZE];
+  uint8_t trailer[TRAILER_SIZE];
+  is.seekg(0);
+  is.read(reinterpret_cast<char *>(header), sizeof(header));
+  is.seekg(size - static_cast<std::streamoff>(TRAILER_SIZE));
+  is.read(reinterpret_cast<char *>(trailer), sizeof(trailer));
+
+  Cursor h{ header + 4, header + sizeof(header) };
+  Cursor t{ trailer, trailer + sizeof(trailer) };
+  uint64_t footer_offset = t.fixed(8);
+
+  if (!is || memcmp(header, Archive::MAGIC, 4) != 0
+      || memcmp(trailer + 8, Archive::MAGIC, 4) != 0
+      || h.fixed(2) != Archive::VERSION
+      || footer_offset < HEADER_SIZE
+      || footer_offset > static_cast<uint64_t>(size) - TRAILER_SIZE)
+    return nullptr;
+
+  std::vector<uint8_t> footer(size - TRAILER_SIZE - footer_offset);
+  is.seekg(static_cast<std::streamoff>(footer_offset));
+  is.read(reinterpret_cast<char *>(footer.data()), footer.size());
+  if (!is) return nullptr;
+
+  std::shared_ptr<ArchiveReader> reader(new ArchiveReader(is));
+
+  Cursor f{ footer.data(), footer.data() + footer.size() };
+  if (f.varint() != Archive::NUM_COLUMNS) return nullptr;
+
+  uint64_t groups = f.varint();
+  for (uint64_t g = 0 ; g < groups && f.ok ; g++)
+  {
+    reader->_group_rows.push_back(f.varint());
+    for (size_t c = 0 ; c < Archive::NUM_COLUMNS ; c++)
+    {
+      Archive::Chunk chunk;
+      chunk.offset = f.varint();
+      chunk.size = f.varint();
+      chunk.enc = static_cast<Archive::encoding>(f.fixed(1));
+      chunk.stats.min = unzigzag(f.varint());
+      chunk.stats.max = unzigzag(f.varint());
+      chunk.stats.count = f.varint();
+
+      if (chunk.offset > footer_offset
+          || chunk.size > footer_offset - chunk.offset) return nullptr;
+
+      reader->_chunks.push_back(chunk);
+    }
+  }
+
+  return f.ok ? reader : nullptr;
+}
+
+uint64_t ArchiveReader::NumRows() const
+{
+  uint64_t n = 0;
+  for (uint64_t rows : _group_rows) n += rows;
+  return n;
+}
+
+const Archive::Chunk& ArchiveReader::chunk(size_t group, column c) const
+{
+  return _chunks[group * Archive::NUM_COLUMNS + static_cast<size_t>(c)];
+}
+
+const Archive::Statistics& ArchiveReader::Statistics(size_t group,
+                                                     column c) const
+{
+  return chunk(group, c).stats;
+}
+
+encoding ArchiveReader::Encoding(size_t group, column c) const
+{
+  return chunk(group, c).enc;
+}
+
+bool ArchiveReader::ReadColumn(size_t group, column c,
+                               std::vector<int64_t>& values)
+{
+  values.clear();
+  if (group >= _group_rows.size()
+      || static_cast<size_t>(c) >= Archive::NUM_COLUMNS) return false;
+
+  const auto& ch = chunk(group, c);
+
+  std::vector<uint8_t> bytes(ch.size);
+  _is.clear();
+  _is.seekg(static_cast<std::streamoff>(ch.offset));
+  _is.read(reinterpret_cast<char *>(bytes.data()), bytes.size());
+  if (!_is) return false;
+
+  _bytes_read += ch.size;
+
+  // no column holds more values per row than the phenomenon codes
+  uint64_t limit = _group_rows[group] * Record::MAX_PHENOMENA
+                                      * Record::MAX_PHENOM;
+  return decode(bytes.data(), bytes.size(), limit, values);
+}
+
+bool ArchiveReader::ReadRecords(size_t group, std::vector<Record>& records)
+{
+  if (group >= _group_rows.size()) return false;
+
+  const size_t rows = static_cast<size_t>(_group_rows[group]);
+
+  std::vector<int64_t> columns[Archive::NUM_COLUMNS];
+  for (size_t c = 0 ; c < Archive::NUM_COLUMNS ; c++)
+  {
+    if (!ReadColumn(group, static_cast<column>(c), columns[c])) return false;
+    if (c < NUM_SCALARS && columns[c].size() != rows) return false;
+  }
+
+  const auto& num_layers = columns[static_cast<size_t>(column::NUM_LAYERS)];
+  const auto& num_phenomena =
+    columns[static_cast<size_t>(column::NUM_PHENOMENA)];
+
+  auto col = [&columns](column c) -> const std::vector<int64_t>& {
+    return columns[static_cast<size_t>(c)];
+  };
+
+  const size_t layers = col(column::LAYER_ALTITUDE).size();
+  const size_t phenomena = col(column::PHENOMENON_ATTRIBUTES).size();
+
+  if (col(column::LAYER_COVER).size() != layers
+      || col(column::LAYER_TYPE).size() != layers
+      || col(column::LAYER_TEMPO).size() != layers
+      || col(column::PHENOMENON_INTENSITY).size() != phenomena
+      || col(column::PHENOMENON_CODES).size() != phenomena * Record::MAX_PHENOM)
+    return false;
+
+  size_t base = records.size();
+  records.resize(base + rows);
+
+  size_t layer = 0;
+  size_t phenomenon = 0;
+  bool ok = true;
+
+  for (size_t i = 0 ; i < rows && ok ; i++)
+  {
+    Record& r = records[base + i];
+    memset(&r, 0, sizeof(r));
+
+    for (size_t c = 0 ; c < NUM_SCALARS ; c++)
+    {
+      SCALARS[c].set(r, columns[c][i]);
+    }
+
+    if (num_layers[i] < 0 || num_layers[i] > Record::MAX_LAYERS
+        || num_phenomena[i] < 0 || num_phenomena[i] > Record::MAX_PHENOMENA
+        || layer + r.num_layers > layers
+        || phenomenon + r.num_phenomena > phenomena)
+    {
+      ok = false;
+      break;
+    }
+
+    for (size_t l = 0 ; l < r.num_layers ; l++, layer++)
+    {
+      r.layers[l].altitude =
+        static_cast<int16_t>(col(column::LAYER_ALTITUDE)[layer]);
+      r.layers[l].cover = static_cast<uint8_t>(col(column::LAYER_COVER)[layer]);
+      r.layers[l].type = static_cast<uint8_t>(col(column::LAYER_TYPE)[layer]);
+      r.layers[l].tempo = static_cast<uint8_t>(col(column::LAYER_TEMPO)[layer]);
+    }
+
+    for (size_t p = 0 ; p < r.num_phenomena ; p++, phenomenon++)
+    {
+      auto& ph = r.phenomena[p];
+      ph.attributes = static_cast<uint16_t>(
+        col(column::PHENOMENON_ATTRIBUTES)[phenomenon]);
+      ph.intensity = static_cast<int8_t>(
+        col(column::PHENOMENON_INTENSITY)[phenomenon]);
+      for (size_t k = 0 ; k < Record::MAX_PHENOM ; k++)
+      {
+        ph.phenom[k] = static_cast<uint8_t>(
+          col(column::PHENOMENON_CODES)[phenomenon * Record::MAX_PHENOM + k]);
+      }
+    }
+  }
+
+  // every flattened value must belong to a record
+  ok = ok && layer == layers && phenomenon == phenomena;
+
+  if (!ok) records.resize(base);
+  return ok;
+}
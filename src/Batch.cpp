@@ -0,0 +1,220 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Columnar batch of decoded METAR reports
+//
+
+#include "Batch.h"
+
+#include "Metar.h"
+#include "Phenom.h"
+#include "Record.h"
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  template<typename T>
+  inline int32_t value(const std::optional<T>& v)
+  {
+    return v.has_value() ? static_cast<int32_t>(*v) : Batch::NONE;
+  }
+
+  template<typename T>
+  inline uint8_t value8(const std::optional<T>& v)
+  {
+    return v.has_value() ? static_cast<uint8_t>(*v) : Batch::NONE8;
+  }
+
+  uint64_t weather(const Metar& metar)
+  {
+    uint64_t bits = 0;
+    for (unsigned int i = 0 ; i < metar.NumPhenomena() ; i++)
+    {
+      const Phenom& p = metar.Phenomenon(i);
+      for (unsigned int j = 0 ; j < p.NumPhenom() ; j++)
+      {
+        uint64_t bit = 1ULL << static_cast<unsigned int>(p[j]);
+        bits |= bit;
+        if (p.Freezing()) bits |= bit << Batch::FREEZING_WEATHER;
+      }
+    }
+    return bits;
+  }
+
+  // prefer the tenths from the remarks T group over the whole degrees
+  inline int32_t tenths(const std::optional<int>& na,
+                        const std::optional<int>& whole)
+  {
+    if (na.has_value()) return *na;
+    if (whole.has_value()) return *whole * 10;
+    return Batch::NONE;
+  }
+}
+
+void Batch::Append(const Metar& metar)
+{
+  auto icao = metar.ICAO();
+  _icao.push_back(icao.has_value() ? Record::PackICAO(icao->c_str()) : 0);
+
+  auto t = metar.ObservationTime();
+  _obs_time.push_back(t.has_value() ? *t : NONE64);
+
+  _wind_dir.push_back(value(metar.WindDirection()));
+  _wind_spd.push_back(value(metar.WindSpeed()));
+  _gust.push_back(value(metar.WindGust()));
+  _min_wind_dir.push_back(value(metar.MinWindDirection()));
+  _max_wind_dir.push_back(value(metar.MaxWindDirection()));
+  _wind_units.push_back(value8(metar.WindSpeedUnits()));
+
+  if (metar.isCAVOK())
+  {
+    _vis.push_back(CAVOK_VISIBILITY);
+    _vis_units.push_back(static_cast<uint8_t>(Metar::distance_units::M));
+  }
+  else
+  {
+    _vis.push_back(value(metar.VisibilityScaled()));
+    _vis_units.push_back(value8(metar.VisibilityUnits()));
+  }
+
+  _ceiling.push_back(value(metar.Ceiling()));
+  _category.push_back(value8(metar.FlightCategory()));
+
+  _temp.push_back(tenths(metar.TemperatureNATenths(), metar.Temperature()));
+  _dew.push_back(tenths(metar.DewPointNATenths(), metar.DewPoint()));
+
+  _altimeterA.push_back(value(metar.AltimeterAHundredths()));
+  _altimeterQ.push_back(value(metar.AltimeterQ()));
+  _slp.push_back(value(metar.SeaLevelPressureTenths()));
+  _weather.push_back(weather(metar));
+}
+
+void Batch::Append(const Record& r)
+{
+  auto has = [&r](Record::field f) { return r.Has(f); };
+
+  _icao.push_back(has(Record::ICAO) ? r.icao : 0);
+  _obs_time.push_back(has(Record::OBSERVATION_TIME) ? r.obs_time : NONE64);
+
+  _wind_dir.push_back(has(Record::WIND_DIRECTION) ? r.wind_dir : NONE);
+  _wind_spd.push_back(has(Record::WIND_SPEED) ? r.wind_speed : NONE);
+  _gust.push_back(has(Record::WIND_GUST) ? r.wind_gust : NONE);
+  _min_wind_dir.push_back(has(Record::WIND_RANGE) ? r.min_wind_dir : NONE);
+  _max_wind_dir.push_back(has(Record::WIND_RANGE) ? r.max_wind_dir : NONE);
+  _wind_units.push_back(has(Record::WIND_UNITS) ? r.wind_units : NONE8);
+
+  if (r.flags & Record::CAVOK)
+  {
+    _vis.push_back(CAVOK_VISIBILITY);
+    _vis_units.push_back(static_cast<uint8_t>(Metar::distance_units::M));
+  }
+  else
+  {
+    _vis.push_back(has(Record::VISIBILITY) ? r.visibility : NONE);
+    _vis_units.push_back(has(Record::VISIBILITY) ? r.vis_units : NONE8);
+  }
+
+  _ceiling.push_back(has(Record::CEILING) ? r.ceiling : NONE);
+  _category.push_back(has(Record::FLIGHT_CATEGORY) ? r.flight_category
+                                                    : NONE8);
+
+  _temp.push_back(has(Record::TEMPERATURE_NA) ? r.temperature_na
+                : has(Record::TEMPERATURE) ? r.temperature * 10 : NONE);
+  _dew.push_back(has(Record::DEW_POINT_NA) ? r.dew_point_na
+               : has(Record::DEW_POINT) ? r.dew_point * 10 : NONE);
+
+  _altimeterA.push_back(has(Record::ALTIMETER_A) ? r.altimeter_a : NONE);
+  _altimeterQ.push_back(has(Record::ALTIMETER_Q) ? r.altimeter_q : NONE);
+  _slp.push_back(has(Record::SEA_LEVEL_PRESS) ? r.sea_level_press : NONE);
+
+  uint64_t bits = 0;
+  for (unsigned int i = 0 ; i < r.num_phenomena ; i++)
+  {
+    const auto& p = r.phenomena[i];
+    const bool freezing = p.attributes & Record::Phenomenon::FREEZING;
+    for (uint8_t code : p.phenom)
+    {
+      if (code == static_cast<uint8_t>(Phenom::phenom::NONE)) continue;
+
+      uint64_t bit = 1ULL << code;
+      bits |= bit;
+      if (freezing) bits |= bit << FREEZING_WEATHER;
+    }
+  }
+  _weather.push_back(bits);
+}
+
+void Batch::Reserve(size_t n)
+{
+  _icao.reserve(n);
+  _obs_time.reserve(n);
+  _wind_dir.reserve(n);
+  _wind_spd.reserve(n);
+  _gust.reserve(n);
+  _min_wind_dir.reserve(n);
+  _max_wind_dir.reserve(n);
+  _wind_units.reserve(n);
+  _vis.reserve(n);
+  _vis_units.reserve(n);
+  _ceiling.reserve(n);
+  _category.reserve(n);
+  _temp.reserve(n);
+  _dew.reserve(n);
+  _altimeterA.reserve(n);
+  _altimeterQ.reserve(n);
+  _slp.reserve(n);
+  _weather.reserve(n);
+}
+
+void Batch::Clear()
+{
+  _icao.clear();
+  _obs_time.clear();
+  _wind_dir.clear();
+  _wind_spd.clear();
+  _gust.clear();
+  _min_wind_dir.clear();
+  _max_wind_dir.clear();
+  _wind_units.clear();
+  _vis.clear();
+  _vis_units.clear();
+  _ceiling.clear();
+  _category.clear();
+  _temp.clear();
+  _dew.clear();
+  _altimeterA.clear();
+  _altimeterQ.clear();
+  _slp.clear();
+  _weather.clear();
+}
+
+void Batch::FlightCategories(std::span<const int32_t> ceiling,
+                             std::span<const int32_t> vis,
+                             std::span<const uint8_t> vis_units,
+                             std::span<uint8_t> out)
+{
+  constexpr int32_t SCALE = Metar::VISIBILITY_SM_SCALE;
+  constexpr uint8_t SM = static_cast<uint8_t>(Metar::distance_units::SM);
+
+  const size_t n = ceiling.size();
+  for (size_t i = 0 ; i < n ; i++)
+  {
+    const int32_t c = ceiling[i];
+    const int32_t v = vis[i];
+    const bool c_ok = c != NONE;
+    const bool v_ok = (v != NONE) & (vis_units[i] != NONE8);
+
+    // meters to sixteenths of a statute mile, rounded down
+    const int32_t m16 =
+      static_cast<int32_t>((static_cast<int64_t>(v) * SCALE * 1000) / 1609344);
+    const int32_t v16 = (vis_units[i] == SM) ? v : m16;
+
+    const int32_t ccat = c_ok * ((c <= 3000) + (c < 1000) + (c < 500));
+    const int32_t vcat = v_ok * ((v16 <= 5 * SCALE) + (v16 < 3 * SCALE)
+                                                    + (v16 < SCALE));
+    const int32_t cat = ccat > vcat ? ccat : vcat;
+
+    out[i] = (c_ok | v_ok) ? static_cast<uint8_t>(cat) : NONE8;
+  }
+}
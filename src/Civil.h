@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Proleptic Gregorian calendar helpers (library internal)
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <optional>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    namespace Civil
+    {
+      // days since 1970-01-01 of a date
+      inline int64_t days_from_civil(int64_t y, unsigned int m, unsigned int d)
+      {
+        y -= m <= 2;
+        const int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned int yoe = static_cast<unsigned int>(y - era * 400);
+        const unsigned int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const unsigned int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+      }
+
+      // year and month of a day since 1970-01-01
+      inline void civil_from_days(int64_t z, int64_t& y, unsigned int& m)
+      {
+        z += 719468;
+        const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned int doe = static_cast<unsigned int>(z - era * 146097);
+        const unsigned int yoe =
+          (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned int mp = (5 * doy + 2) / 153;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+      }
+
+      inline unsigned int days_in_month(int64_t y, unsigned int m)
+      {
+        static const unsigned int days[] =
+          { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        if (m == 2 && ((y % 4 == 0 && y % 100 != 0) || y % 400 == 0))
+          return 29;
+        return days[m - 1];
+      }
+
+      // resolve a day/hour/minute group against the month before, of and after
+      // the reference time, picking the candidate closest to the reference
+      inline std::optional<int64_t> resolve_time(std::time_t reference,
+                                                 int day, int hour, int min)
+      {
+        if (day < 1 || day > 31 || hour > 24 || min > 59)
+          return {};
+
+        int64_t ref = static_cast<int64_t>(reference);
+        int64_t ref_days = ref / 86400 - (ref % 86400 < 0);
+
+        int64_t y;
+        unsigned int m;
+        civil_from_days(ref_days, y, m);
+
+        std::optional<int64_t> best;
+        for (int offset = -1 ; offset <= 1 ; offset++)
+        {
+          int64_t cy = y;
+          int cm = static_cast<int>(m) + offset;
+          if (cm < 1) { cm = 12; cy--; }
+          if (cm > 12) { cm = 1; cy++; }
+
+          if (static_cast<unsigned int>(day) > days_in_month(cy, cm))
+            continue;
+
+          // hour 24 is sometimes used for midnight at the end of the day
+          int64_t t = days_from_civil(cy, cm, day) * 86400
+                    + hour * 3600 + min * 60;
+          if (!best.has_value() || llabs(t - ref) < llabs(*best - ref))
+            best = t;
+        }
+
+        return best;
+      }
+    }
+  }
+}
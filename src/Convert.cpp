@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Units conversion
+//
+
+#include "Convert.h"
+
+#include "Metar.h"
+#include "Simd.h"
+
+#include <climits>
+#include <limits>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  constexpr double MISSING = static_cast<double>(INT32_MIN);
+  constexpr double MISSING8 = static_cast<double>(UINT8_MAX);
+  constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+  // Runs a kernel over two columns WIDTH elements at a time; the tail is
+  // padded with missing values.
+  template<typename A, typename B, typename F>
+  void normalize(std::span<const A> a, std::span<const B> b,
+                 std::span<double> out, A fill_a, B fill_b, F f)
+  {
+    const size_t n = a.size();
+    for (size_t i = 0 ; i < n ; i += Simd::WIDTH)
+    {
+      size_t len = n - i < Simd::WIDTH ? n - i : Simd::WIDTH;
+      Simd::f64v r = f(Simd::load(a.data() + i, len, fill_a),
+                       Simd::load(b.data() + i, len, fill_b));
+      Simd::store(out.data() + i, r, len);
+    }
+  }
+}
+
+void Convert::SpeedsToKnots(std::span<const int32_t> speed,
+                            std::span<const uint8_t> units,
+                            std::span<double> out)
+{
+  normalize(speed, units, out, INT32_MIN, static_cast<uint8_t>(UINT8_MAX),
+    [](Simd::f64v s, Simd::f64v u)
+    {
+      constexpr double MPS = static_cast<double>(Metar::speed_units::MPS);
+      constexpr double KPH = static_cast<double>(Metar::speed_units::KPH);
+
+      Simd::f64v factor = Simd::select(u == MPS, Simd::splat(1.0 / mpsPerKnot),
+                            Simd::select(u == KPH,
+                                         Simd::splat(1.0 / kphPerKnot),
+                                         Simd::splat(1.0)));
+      return Simd::select((s == MISSING) | (u == MISSING8),
+                          Simd::splat(NaN), s * factor);
+    });
+}
+
+void Convert::VisibilitiesToMeters(std::span<const int32_t> vis,
+                                   std::span<const uint8_t> units,
+                                   std::span<double> out)
+{
+  normalize(vis, units, out, INT32_MIN, static_cast<uint8_t>(UINT8_MAX),
+    [](Simd::f64v v, Simd::f64v u)
+    {
+      constexpr double SM = static_cast<double>(Metar::distance_units::SM);
+      constexpr double SM_FACTOR =
+        miles2Km * 1000.0 / Metar::VISIBILITY_SM_SCALE;
+
+      Simd::f64v factor = Simd::select(u == SM, Simd::splat(SM_FACTOR),
+                                       Simd::splat(1.0));
+      return Simd::select((v == MISSING) | (u == MISSING8),
+                          Simd::splat(NaN), v * factor);
+    });
+}
+
+void Convert::AltimetersToMb(std::span<const int32_t> altA,
+                             std::span<const int32_t> altQ,
+                             std::span<double> out)
+{
+  normalize(altA, altQ, out, INT32_MIN, INT32_MIN,
+    [](Simd::f64v a, Simd::f64v q)
+    {
+      Simd::f64v mb = Simd::select(a == MISSING, Simd::splat(NaN),
+                                   a * (mbPerInHg / 100.0));
+      return Simd::select(q == MISSING, mb, q);
+    });
+}
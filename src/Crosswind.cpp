@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Runway wind components
+//
+
+#include "Crosswind.h"
+
+#include "Batch.h"
+#include "Convert.h"
+#include "Simd.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  constexpr double DEG2RAD = 3.14159265358979323846 / 180.0;
+  constexpr double MISSING = static_cast<double>(Batch::NONE);
+
+  // angle in degrees folded into [0, 360)
+  inline Simd::f64v wrap(Simd::f64v a)
+  {
+    return a - 360.0 * Simd::floor(a / 360.0);
+  }
+
+  // whether 'a' lies on the clockwise arc from 'lo' spanning 'span' degrees
+  inline Simd::i64v on_arc(double a, Simd::f64v lo, Simd::f64v span)
+  {
+    return wrap(a - lo) <= span;
+  }
+}
+
+void Crosswind::Components(std::span<const int32_t> headings,
+                           const Batch& batch,
+                           std::span<double> crosswind,
+                           std::span<double> headwind)
+{
+  const size_t n = batch.Size();
+
+  std::vector<double> speed(n);
+  std::vector<double> gust(n);
+  Convert::SpeedsToKnots(batch.WindSpeed(), batch.WindSpeedUnits(), speed);
+  Convert::SpeedsToKnots(batch.WindGust(), batch.WindSpeedUnits(), gust);
+
+  const int32_t *dir = batch.WindDirection().data();
+  const int32_t *min_dir = batch.MinWindDirection().data();
+  const int32_t *max_dir = batch.MaxWindDirection().data();
+
+  for (size_t r = 0 ; r < headings.size() ; r++)
+  {
+    const double heading = headings[r];
+    double *cross = crosswind.data() + r * n;
+    double *head = headwind.data() + r * n;
+
+    for (size_t i = 0 ; i < n ; i += Simd::WIDTH)
+    {
+      size_t len = n - i < Simd::WIDTH ? n - i : Simd::WIDTH;
+
+      Simd::f64v s = Simd::load(speed.data() + i, len, 0.0);
+      Simd::f64v g = Simd::load(gust.data() + i, len, 0.0);
+      Simd::f64v d = Simd::load(dir + i, len, Batch::NONE);
+      Simd::f64v lo = Simd::load(min_dir + i, len, Batch::NONE);
+      Simd::f64v hi = Simd::load(max_dir + i, len, Batch::NONE);
+
+      // NaN compares false, so a missing gust keeps the sustained speed
+      s = Simd::select(g > s, g, s);
+
+      Simd::i64v has_range = (lo != MISSING) & (hi != MISSING);
+      Simd::i64v any_dir = (d == MISSING) & ~has_range;
+
+      lo = wrap(Simd::select(has_range, lo, d) - heading);
+      hi = wrap(Simd::select(has_range, hi, d) - heading);
+      Simd::f64v span = wrap(hi - lo);
+
+      Simd::f64v lo_rad = lo * DEG2RAD;
+      Simd::f64v hi_rad = hi * DEG2RAD;
+
+      Simd::f64v x = Simd::max(Simd::abs(Simd::sin(lo_rad)),
+                               Simd::abs(Simd::sin(hi_rad)));
+      Simd::f64v h = Simd::min(Simd::cos(lo_rad), Simd::cos(hi_rad));
+
+      Simd::i64v beam = on_arc(90.0, lo, span) | on_arc(270.0, lo, span)
+                      | any_dir;
+      Simd::i64v tail = on_arc(180.0, lo, span) | any_dir;
+
+      x = Simd::select(beam, Simd::splat(1.0), x);
+      h = Simd::select(tail, Simd::splat(-1.0), h);
+
+      Simd::store(cross + i, s * x, len);
+      Simd::store(head + i, s * h, len);
+    }
+  }
+}
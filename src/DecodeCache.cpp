@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Cache of decoded reports keyed by their text
+//
+
+#include "DecodeCache.h"
+
+#include "Civil.h"
+#include "Metar.h"
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  // FNV-1a
+  inline uint64_t hash(std::string_view s)
+  {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (unsigned char c : s)
+    {
+      h ^= c;
+      h *= 0x100000001B3ULL;
+    }
+    return h;
+  }
+
+  // the observation time is the only part of a record that depends on the
+  // reference time
+  inline Record resolve(Record r, const std::time_t *reference)
+  {
+    if (reference != nullptr && r.Has(Record::TIME))
+    {
+      auto t = Civil::resolve_time(*reference, r.day, r.hour, r.minute);
+      if (t.has_value())
+      {
+        r.obs_time = *t;
+        r.present |= Record::OBSERVATION_TIME;
+      }
+    }
+    return r;
+  }
+}
+
+DecodeCache::DecodeCache(size_t capacity, size_t shards)
+  : _shards(std::make_unique<Shard[]>(shards > 0 ? shards : 1))
+  , _num_shards(shards > 0 ? shards : 1)
+{
+  size_t share = (capacity + _num_shards - 1) / _num_shards;
+  if (share == 0) share = 1;
+
+  for (size_t i = 0 ; i < _num_shards ; i++)
+  {
+    _shards[i].slots.resize(share);
+    _shards[i].index.reserve(share);
+  }
+}
+
+Record DecodeCache::Decode(const char *report)
+{
+  return decode(report, nullptr);
+}
+
+Record DecodeCache::Decode(const char *report, std::time_t reference)
+{
+  return decode(report, &reference);
+}
+
+Record DecodeCache::decode(std::string_view report,
+                           const std::time_t *reference)
+{
+  uint64_t h = hash(report);
+  Shard& shard = _shards[(h >> 40) % _num_shards];
+
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(h);
+    if (it != shard.index.end())
+    {
+      Slot& slot = shard.slots[it->second];
+      if (slot.text == report)
+      {
+        slot.referenced = true;
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        return resolve(slot.record, reference);
+      }
+    }
+  }
+
+  _misses.fetch_add(1, std::memory_order_relaxed);
+
+  // parse outside the lock, so a slow report does not hold up the shard
+  std::string text(report);
+  Record record = Record::Create(*Metar::Create(text.c_str()));
+  record.present &= ~Record::OBSERVATION_TIME;
+  record.obs_time = 0;
+
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(h);
+    if (it == shard.index.end())
+    {
+      size_t i = victim(shard);
+      it = shard.index.emplace(h, i).first;
+    }
+
+    // a colliding report replaces the one held
+    Slot& slot = shard.slots[it->second];
+    slot.hash = h;
+    slot.text = std::move(text);
+    slot.record = record;
+    slot.used = true;
+    slot.referenced = false;
+  }
+
+  return resolve(record, reference);
+}
+
+size_t DecodeCache::victim(Shard& shard)
+{
+  for ( ; ; shard.hand = (shard.hand + 1) % shard.slots.size())
+  {
+    Slot& slot = shard.slots[shard.hand];
+    if (!slot.used) break;
+    if (!slot.referenced)
+    {
+      shard.index.erase(slot.hash);
+      slot.used = false;
+      _evictions.fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+    slot.referenced = false;
+  }
+
+  size_t i = shard.hand;
+  shard.hand = (shard.hand + 1) % shard.slots.size();
+  return i;
+}
+
+size_t DecodeCache::Size() const
+{
+  size_t n = 0;
+  for (size_t i = 0 ; i < _num_shards ; i++)
+  {
+    std::lock_guard<std::mutex> lock(_shards[i].mutex);
+    n += _shards[i].index.size();
+  }
+  return n;
+}
+
+DecodeCache::Counters DecodeCache::Statistics() const
+{
+  return Counters{ _hits.load(std::memory_order_relaxed),
+                   _misses.load(std::memory_order_relaxed),
+                   _evictions.load(std::memory_order_relaxed) };
+}
+
+void DecodeCache::Clear()
+{
+  for (size_t i = 0 ; i < _num_shards ; i++)
+  {
+    Shard& shard = _shards[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.index.clear();
+    for (Slot& slot : shard.slots) slot = Slot{};
+    shard.hand = 0;
+  }
+
+  _hits.store(0, std::memory_order_relaxed);
+  _misses.store(0, std::memory_order_relaxed);
+  _evictions.store(0, std::memory_order_relaxed);
+}
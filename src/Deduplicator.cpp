@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Streaming duplicate and correction tracking
+//
+
+#include "Deduplicator.h"
+
+#include "RecordCodec.h"
+
+#include <climits>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  // FNV-1a of the encoded record. The COR flag is not part of the content,
+  // so a correction that repeats the original is a duplicate.
+  uint64_t fingerprint(const Record& record)
+  {
+    Record r = record;
+    r.flags &= ~Record::CORRECTION;
+
+    uint8_t buf[RecordCodec::ENCODED_SIZE];
+    RecordCodec::Encode(r, buf);
+
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (uint8_t c : buf)
+    {
+      h ^= c;
+      h *= 0x100000001B3ULL;
+    }
+    return h;
+  }
+}
+
+size_t Deduplicator::KeyHash::operator()(const Key& k) const
+{
+  uint64_t h = (static_cast<uint64_t>(k.time) * 0x9E3779B97F4A7C15ULL) ^ k.icao;
+  h *= 0xBF58476D1CE4E5B9ULL;
+  return static_cast<size_t>(h ^ (h >> 31));
+}
+
+Deduplicator::Deduplicator(int64_t window)
+  : _window(window > 0 ? window : 0)
+{
+  Clear();
+}
+
+void Deduplicator::Clear()
+{
+  _newest = INT64_MIN;
+  _seen.clear();
+  _expiry = decltype(_expiry)();
+  for (auto& c : _counts) c = 0;
+}
+
+Deduplicator::result Deduplicator::count(result r)
+{
+  _counts[static_cast<size_t>(r)]++;
+  return r;
+}
+
+void Deduplicator::expire()
+{
+  while (!_expiry.empty() && _expiry.top().time < _newest - _window)
+  {
+    _seen.erase(_expiry.top());
+    _expiry.pop();
+  }
+}
+
+Deduplicator::result Deduplicator::Offer(const Record& record)
+{
+  if (!record.Has(Record::ICAO) || !record.Has(Record::OBSERVATION_TIME))
+    return count(result::NEW);
+
+  const Key key{ record.icao, record.obs_time };
+
+  if (_newest != INT64_MIN && key.time < _newest - _window)
+    return count(result::STALE);
+
+  const uint64_t content = fingerprint(record);
+
+  auto it = _seen.find(key);
+  if (it == _seen.end())
+  {
+    _seen.emplace(key, content);
+    _expiry.push(key);
+
+    if (key.time > _newest)
+    {
+      _newest = key.time;
+      expire();
+    }
+    return count(result::NEW);
+  }
+
+  if (it->second == content) return count(result::DUPLICATE);
+
+  if (!(record.flags & Record::CORRECTION)) return count(result::CONFLICT);
+
+  it->second = content;
+  return count(result::CORRECTION);
+}
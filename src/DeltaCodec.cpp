@@ -0,0 +1,262 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Delta-encoded stream of station updates
+//
+
+#include "DeltaCodec.h"
+
+#include "Varint.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  constexpr uint32_t GROUPS = RecordDiff::FLAGS | RecordDiff::LAYERS
+                            | RecordDiff::PHENOMENA;
+
+  Record empty()
+  {
+    Record r;
+    memset(&r, 0, sizeof(r));
+    return r;
+  }
+
+  // Calls f(a.member, b.member) for every scalar member of the fields in
+  // bits, in stream order. The station identifier is sent in the message
+  // header instead.
+  template<typename A, typename B, typename F>
+  void scalars(A& a, B& b, uint32_t bits, F f)
+  {
+    if (bits & Record::MESSAGE_TYPE) f(a.message_type, b.message_type);
+    if (bits & Record::TIME)
+    {
+      f(a.day, b.day);
+      f(a.hour, b.hour);
+      f(a.minute, b.minute);
+    }
+    if (bits & Record::OBSERVATION_TIME) f(a.obs_time, b.obs_time);
+    if (bits & Record::WIND_DIRECTION) f(a.wind_dir, b.wind_dir);
+    if (bits & Record::WIND_SPEED) f(a.wind_speed, b.wind_speed);
+    if (bits & Record::WIND_GUST) f(a.wind_gust, b.wind_gust);
+    if (bits & Record::WIND_RANGE)
+    {
+      f(a.min_wind_dir, b.min_wind_dir);
+      f(a.max_wind_dir, b.max_wind_dir);
+    }
+    if (bits & Record::WIND_UNITS) f(a.wind_units, b.wind_units);
+    if (bits & Record::VISIBILITY)
+    {
+      f(a.visibility, b.visibility);
+      f(a.vis_units, b.vis_units);
+    }
+    if (bits & Record::VERTICAL_VIS) f(a.vertical_vis, b.vertical_vis);
+    if (bits & Record::CEILING) f(a.ceiling, b.ceiling);
+    if (bits & Record::FLIGHT_CATEGORY)
+      f(a.flight_category, b.flight_category);
+    if (bits & Record::TEMPERATURE) f(a.temperature, b.temperature);
+    if (bits & Record::DEW_POINT) f(a.dew_point, b.dew_point);
+    if (bits & Record::ALTIMETER_A) f(a.altimeter_a, b.altimeter_a);
+    if (bits & Record::ALTIMETER_Q) f(a.altimeter_q, b.altimeter_q);
+    if (bits & Record::SEA_LEVEL_PRESS)
+      f(a.sea_level_press, b.sea_level_press);
+    if (bits & Record::TEMPERATURE_NA) f(a.temperature_na, b.temperature_na);
+    if (bits & Record::DEW_POINT_NA) f(a.dew_point_na, b.dew_point_na);
+    if (bits & RecordDiff::FLAGS) f(a.flags, b.flags);
+  }
+
+  void message(DeltaCodec::kind k, const Record& r, const Record& base,
+               uint32_t changed, std::vector<uint8_t>& out)
+  {
+    using Varint::put;
+    using Varint::zigzag;
+
+    out.push_back(k);
+    put(out, r.icao);
+    put(out, changed);
+    put(out, r.present & changed);
+
+    uint32_t values = changed & (r.present | GROUPS);
+
+    scalars(r, base, values, [&out](auto v, auto b) {
+      put(out, zigzag(static_cast<int64_t>(v) - static_cast<int64_t>(b)));
+    });
+
+    if (values & RecordDiff::LAYERS)
+    {
+      put(out, r.num_layers);
+      for (unsigned int i = 0 ; i < r.num_layers ; i++)
+      {
+        const Record::Layer& l = r.layers[i];
+        put(out, zigzag(l.altitude));
+        put(out, l.cover);
+        put(out, l.type);
+        put(out, l.tempo);
+      }
+    }
+
+    if (values & RecordDiff::PHENOMENA)
+    {
+      put(out, r.num_phenomena);
+      for (unsigned int i = 0 ; i < r.num_phenomena ; i++)
+      {
+        const Record::Phenomenon& p = r.phenomena[i];
+        put(out, p.attributes);
+        put(out, zigzag(p.intensity));
+        for (uint8_t code : p.phenom) put(out, code);
+      }
+    }
+  }
+
+  // bounds checked reader of a message
+  struct Reader
+  {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool truncated = false;
+    bool corrupt = false;
+
+    uint64_t varint(uint64_t max)
+    {
+      uint64_t v;
+      if (!Varint::get(p, end, v))
+      {
+        (p >= end ? truncated : corrupt) = true;
+        return 0;
+      }
+      if (v > max)
+      {
+        corrupt = true;
+        return 0;
+      }
+      return v;
+    }
+
+    bool ok() const { return !truncated && !corrupt; }
+  };
+}
+
+DeltaEncoder::DeltaEncoder(unsigned int keyframe_interval)
+  : _interval(keyframe_interval)
+{
+}
+
+bool DeltaEncoder::Encode(const Record& record, std::vector<uint8_t>& out)
+{
+  const Record *last = _tracker.Get(record.icao);
+  const Record previous = last != nullptr ? *last : empty();
+
+  RecordDiff::Delta delta;
+  if (!_tracker.Update(record, delta)) return false;
+
+  unsigned int& deltas = _deltas[record.icao];
+  if (last == nullptr || deltas >= _interval)
+  {
+    message(DeltaCodec::KEYFRAME, record, empty(),
+            RecordDiff::Diff(empty(), record), out);
+    deltas = 0;
+  }
+  else
+  {
+    message(DeltaCodec::DELTA, record, previous, delta.changed, out);
+    deltas++;
+  }
+
+  return true;
+}
+
+void DeltaEncoder::Keyframes(std::vector<uint8_t>& out) const
+{
+  const Record zero = empty();
+  for (const auto& station : _deltas)
+  {
+    const Record& r = *_tracker.Get(station.first);
+    message(DeltaCodec::KEYFRAME, r, zero, RecordDiff::Diff(zero, r), out);
+  }
+}
+
+DeltaDecoder::result DeltaDecoder::Decode(std::span<const uint8_t> in,
+                                          size_t& consumed, Record& record)
+{
+  consumed = 0;
+  if (in.empty()) return result::INCOMPLETE;
+
+  Reader rd{ in.data() + 1, in.data() + in.size() };
+
+  const uint8_t k = in[0];
+  if (k != DeltaCodec::KEYFRAME && k != DeltaCodec::DELTA)
+    return result::CORRUPT;
+
+  const uint32_t icao = static_cast<uint32_t>(rd.varint(UINT32_MAX));
+  const uint32_t changed =
+    static_cast<uint32_t>(rd.varint(RecordDiff::ALL));
+  const uint32_t present = static_cast<uint32_t>(rd.varint(changed));
+
+  if (rd.ok() && icao == 0) rd.corrupt = true;
+  if (rd.ok() && (present & ~changed)) rd.corrupt = true;
+  if (!rd.ok()) return rd.corrupt ? result::CORRUPT : result::INCOMPLETE;
+
+  const Record zero = empty();
+  auto it = _last.find(icao);
+  const bool known = k == DeltaCodec::KEYFRAME || it != _last.end();
+  const Record base = (k == DeltaCodec::DELTA && known) ? it->second : zero;
+
+  // fields that disappeared are cleared as Record::Create() leaves them
+  Record r = base;
+  RecordDiff::Apply(r, zero, changed & ~present);
+  r.present |= present;
+  r.icao = icao;
+
+  const uint32_t values = changed & (present | GROUPS);
+
+  scalars(r, base, values, [&rd](auto& v, auto b) {
+    int64_t d = Varint::unzigzag(rd.varint(UINT64_MAX));
+    v = static_cast<std::remove_reference_t<decltype(v)>>(
+          static_cast<int64_t>(b) + d);
+  });
+
+  if (values & RecordDiff::LAYERS)
+  {
+    std::fill(std::begin(r.layers), std::end(r.layers), zero.layers[0]);
+    r.num_layers = static_cast<uint8_t>(rd.varint(Record::MAX_LAYERS));
+    for (unsigned int i = 0 ; rd.ok() && i < r.num_layers ; i++)
+    {
+      Record::Layer& l = r.layers[i];
+      l.altitude = static_cast<int16_t>(
+                     Varint::unzigzag(rd.varint(UINT32_MAX)));
+      l.cover = static_cast<uint8_t>(rd.varint(UINT8_MAX));
+      l.type = static_cast<uint8_t>(rd.varint(UINT8_MAX));
+      l.tempo = static_cast<uint8_t>(rd.varint(UINT8_MAX));
+    }
+  }
+
+  if (values & RecordDiff::PHENOMENA)
+  {
+    std::fill(std::begin(r.phenomena), std::end(r.phenomena),
+              zero.phenomena[0]);
+    r.num_phenomena = static_cast<uint8_t>(rd.varint(Record::MAX_PHENOMENA));
+    for (unsigned int i = 0 ; rd.ok() && i < r.num_phenomena ; i++)
+    {
+      Record::Phenomenon& p = r.phenomena[i];
+      p.attributes = static_cast<uint16_t>(rd.varint(UINT16_MAX));
+      p.intensity = static_cast<int8_t>(
+                      Varint::unzigzag(rd.varint(UINT16_MAX)));
+      for (uint8_t& code : p.phenom)
+        code = static_cast<uint8_t>(rd.varint(UINT8_MAX));
+    }
+  }
+
+  if (!rd.ok()) return rd.corrupt ? result::CORRUPT : result::INCOMPLETE;
+
+  consumed = static_cast<size_t>(rd.p - in.data());
+  if (!known) return result::WAITING;
+
+  _last[icao] = r;
+  record = r;
+  return result::RECORD;
+}
@@ -0,0 +1,256 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Predicate filters over columnar batches
+//
+
+#include "Filter.h"
+
+#include "Batch.h"
+#include "Convert.h"
+#include "Metar.h"
+#include "Simd.h"
+
+#include <bit>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  constexpr size_t WORD = 64;
+
+  // Thresholds of a comparison expressed in each unit of the field, so that
+  // values are compared in the units they were reported in.
+  struct Thresholds
+  {
+    double t[3];
+  };
+
+  // Sets the bits of the words of 'out' for the rows of column 'v' whose
+  // value is present and compares true against the threshold of their unit.
+  template<typename T, typename Cmp>
+  void compare(std::span<const T> v, std::span<const uint8_t> units,
+               T none, const Thresholds& th, Cmp cmp, uint64_t *out)
+  {
+    using namespace Simd;
+
+    const size_t n = v.size();
+    const f64v t0 = splat(th.t[0]);
+    const f64v t1 = splat(th.t[1]);
+    const f64v t2 = splat(th.t[2]);
+    const f64v missing = splat(static_cast<double>(none));
+    const f64v missing8 = splat(static_cast<double>(Batch::NONE8));
+
+    for (size_t w = 0 ; w * WORD < n ; w++)
+    {
+      uint64_t bits = 0;
+      for (size_t j = 0 ; j < WORD && w * WORD + j < n ; j += WIDTH)
+      {
+        size_t i = w * WORD + j;
+        size_t len = n - i < WIDTH ? n - i : WIDTH;
+
+        f64v x = load(v.data() + i, len, none);
+        f64v u = units.empty() ? splat(0.0)
+                               : load(units.data() + i, len, Batch::NONE8);
+        f64v t = select(u == 1.0, t1, select(u == 2.0, t2, t0));
+
+        i64v hit = (x != missing) & (u != missing8) & cmp(x, t);
+        for (size_t l = 0 ; l < len ; l++)
+        {
+          bits |= (static_cast<uint64_t>(hit[l]) & 1) << (j + l);
+        }
+      }
+      out[w] = bits;
+    }
+  }
+
+  template<typename T>
+  void compare(std::span<const T> v, std::span<const uint8_t> units, T none,
+               const Thresholds& th, Filter::op o, uint64_t *out)
+  {
+    using Simd::f64v;
+
+    switch (o)
+    {
+      case Filter::op::LT:
+        compare(v, units, none, th, [](f64v a, f64v b) { return a < b; }, out);
+        break;
+      case Filter::op::LE:
+        compare(v, units, none, th, [](f64v a, f64v b) { return a <= b; }, out);
+        break;
+      case Filter::op::GT:
+        compare(v, units, none, th, [](f64v a, f64v b) { return a > b; }, out);
+        break;
+      case Filter::op::GE:
+        compare(v, units, none, th, [](f64v a, f64v b) { return a >= b; }, out);
+        break;
+      case Filter::op::EQ:
+        compare(v, units, none, th, [](f64v a, f64v b) { return a == b; }, out);
+        break;
+      case Filter::op::NE:
+        compare(v, units, none, th, [](f64v a, f64v b) { return a != b; }, out);
+        break;
+    }
+  }
+
+  // thresholds of a speed in knots, indexed by Metar::speed_units
+  Thresholds knots(double v)
+  {
+    return { { v, Convert::Kts2Mps(v), Convert::Kts2Kph(v) } };
+  }
+
+  void evaluate(const Batch& batch, Filter::field f, Filter::op o,
+                double value, uint64_t *out)
+  {
+    const Thresholds same = { { value, value, value } };
+    const Thresholds tenths = { { value * 10, value * 10, value * 10 } };
+    const std::span<const uint8_t> none;
+
+    switch (f)
+    {
+      case Filter::field::VISIBILITY:
+      {
+        // indexed by Metar::distance_units
+        const double m = Convert::Miles2Km(value) * 1000.0;
+        const double sm = value * Metar::VISIBILITY_SM_SCALE;
+        compare(batch.Visibility(), batch.VisibilityUnits(), Batch::NONE,
+                { { m, sm, m } }, o, out);
+        break;
+      }
+      case Filter::field::CEILING:
+        compare(batch.Ceiling(), none, Batch::NONE, same, o, out);
+        break;
+      case Filter::field::WIND_SPEED:
+        compare(batch.WindSpeed(), batch.WindSpeedUnits(), Batch::NONE,
+                knots(value), o, out);
+        break;
+      case Filter::field::WIND_GUST:
+        compare(batch.WindGust(), batch.WindSpeedUnits(), Batch::NONE,
+                knots(value), o, out);
+        break;
+      case Filter::field::TEMPERATURE:
+        compare(batch.Temperature(), none, Batch::NONE, tenths, o, out);
+        break;
+      case Filter::field::DEW_POINT:
+        compare(batch.DewPoint(), none, Batch::NONE, tenths, o, out);
+        break;
+      case Filter::field::SEA_LEVEL_PRESSURE:
+        compare(batch.SeaLevelPressure(), none, Batch::NONE, tenths, o, out);
+        break;
+      case Filter::field::FLIGHT_CATEGORY:
+        compare(batch.FlightCategory(), none, Batch::NONE8, same, o, out);
+        break;
+    }
+  }
+
+  void contains(std::span<const uint64_t> weather, uint64_t mask,
+                uint64_t *out)
+  {
+    const size_t n = weather.size();
+    for (size_t w = 0 ; w * WORD < n ; w++)
+    {
+      uint64_t bits = 0;
+      for (size_t j = 0 ; j < WORD && w * WORD + j < n ; j++)
+      {
+        bits |= static_cast<uint64_t>((weather[w * WORD + j] & mask) != 0) << j;
+      }
+      out[w] = bits;
+    }
+  }
+}
+
+Filter Filter::Compare(field f, op o, double value)
+{
+  Filter filter;
+  filter._nodes.push_back({ kind::COMPARE, f, o, value, 0 });
+  return filter;
+}
+
+Filter Filter::Contains(Phenom::phenom p, bool freezing)
+{
+  unsigned int bit = static_cast<unsigned int>(p)
+                   + (freezing ? Batch::FREEZING_WEATHER : 0);
+
+  Filter filter;
+  filter._nodes.push_back({ kind::CONTAINS, field::VISIBILITY, op::EQ, 0,
+                            1ULL << bit });
+  return filter;
+}
+
+Filter Filter::combine(const Filter& a, const Filter& b, kind k)
+{
+  Filter filter;
+  filter._nodes = a._nodes;
+  filter._nodes.insert(filter._nodes.end(), b._nodes.begin(), b._nodes.end());
+  filter._nodes.push_back({ k, field::VISIBILITY, op::EQ, 0, 0 });
+  return filter;
+}
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    Filter operator&(const Filter& a, const Filter& b)
+    {
+      return Filter::combine(a, b, Filter::kind::AND);
+    }
+
+    Filter operator|(const Filter& a, const Filter& b)
+    {
+      return Filter::combine(a, b, Filter::kind::OR);
+    }
+  }
+}
+
+void Filter::Evaluate(const Batch& batch,
+                      std::vector<uint64_t>& selection) const
+{
+  const size_t words = (batch.Size() + WORD - 1) / WORD;
+
+  std::vector<std::vector<uint64_t>> stack;
+  for (const auto& node : _nodes)
+  {
+    if (node.k == kind::AND || node.k == kind::OR)
+    {
+      std::vector<uint64_t> b = std::move(stack.back());
+      stack.pop_back();
+      std::vector<uint64_t>& a = stack.back();
+      for (size_t w = 0 ; w < words ; w++)
+      {
+        a[w] = node.k == kind::AND ? a[w] & b[w] : a[w] | b[w];
+      }
+      continue;
+    }
+
+    stack.emplace_back(words);
+    if (node.k == kind::COMPARE)
+    {
+      evaluate(batch, node.f, node.o, node.value, stack.back().data());
+    }
+    else
+    {
+      contains(batch.PresentWeather(), node.mask, stack.back().data());
+    }
+  }
+
+  selection = std::move(stack.back());
+}
+
+size_t Filter::Count(std::span<const uint64_t> selection)
+{
+  size_t n = 0;
+  for (uint64_t w : selection) n += std::popcount(w);
+  return n;
+}
+
+void Filter::Indices(std::span<const uint64_t> selection,
+                     std::vector<size_t>& indices)
+{
+  for (size_t w = 0 ; w < selection.size() ; w++)
+  {
+    for (uint64_t bits = selection[w] ; bits ; bits &= bits - 1)
+    {
+      indices.push_back(w * WORD + std::countr_zero(bits));
+    }
+  }
+}
@@ -0,0 +1,227 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Concurrent latest observation per station
+//
+
+#include "LatestCache.h"
+
+#include "SeqLock.h"
+
+#include <algorithm>
+#include <bit>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  inline uint64_t hash(uint32_t icao)
+  {
+    uint64_t h = static_cast<uint64_t>(icao) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 29);
+  }
+
+  // position of a record's observation in time, minutes within the month when
+  // no absolute time was resolved
+  inline int64_t observed(const Record& r)
+  {
+    return (r.day * 24 + r.hour) * 60 + r.minute;
+  }
+
+  // day, hour and minute further apart than this wrap over a month boundary
+  constexpr int64_t HALF_MONTH = 15 * 24 * 60;
+}
+
+LatestCache::LatestCache(size_t max_stations, size_t shards,
+                         size_t log_capacity)
+  : _shards(std::make_unique<Shard[]>(shards > 0 ? shards : 1))
+  , _num_shards(shards > 0 ? shards : 1)
+  , _log(log_capacity > 0 ? log_capacity : 1)
+{
+  size_t share = (max_stations + _num_shards - 1) / _num_shards;
+  size_t table = std::bit_ceil(share * 4 + 1);
+
+  for (size_t i = 0 ; i < _num_shards ; i++)
+  {
+    _shards[i].slots = std::make_unique<Slot[]>(table);
+    _shards[i].mask = table - 1;
+    _shards[i].max_size = share * 2;
+  }
+}
+
+bool LatestCache::Supersedes(const Record& candidate, const Record& current)
+{
+  bool absolute = candidate.Has(Record::OBSERVATION_TIME)
+               && current.Has(Record::OBSERVATION_TIME);
+
+  int64_t a = absolute ? candidate.obs_time : observed(candidate);
+  int64_t b = absolute ? current.obs_time : observed(current);
+
+  if (a != b)
+  {
+    if (!absolute && (a > b ? a - b : b - a) > HALF_MONTH) return a < b;
+    return a > b;
+  }
+
+  return (candidate.flags & Record::CORRECTION) && !(candidate == current);
+}
+
+LatestCache::Shard& LatestCache::shard_of(uint64_t h) const
+{
+  return _shards[(h >> 40) % _num_shards];
+}
+
+bool LatestCache::Update(const Record& record)
+{
+  if (record.icao == 0) return false;
+
+  uint64_t h = hash(record.icao);
+  Shard& shard = shard_of(h);
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  for (size_t i = h & shard.mask ; ; i = (i + 1) & shard.mask)
+  {
+    Slot& slot = shard.slots[i];
+    uint32_t key = slot.icao.load(std::memory_order_relaxed);
+
+    if (key == record.icao)
+    {
+      // writers are serialized by the shard lock, so no retry is needed
+      Record current;
+      SeqLock::load(slot.words, current);
+      if (!Supersedes(record, current)) return false;
+
+      uint64_t seq = SeqLock::begin_write(slot.seq);
+      SeqLock::store(slot.words, record);
+      SeqLock::end_write(slot.seq, seq);
+      log(record.icao);
+      return true;
+    }
+
+    if (key == 0)
+    {
+      if (shard.size.load(std::memory_order_relaxed) >= shard.max_size)
+        return false;
+
+      SeqLock::store(slot.words, record);
+      // publishing the key makes the record visible to readers
+      slot.icao.store(record.icao, std::memory_order_release);
+      shard.size.fetch_add(1, std::memory_order_relaxed);
+      log(record.icao);
+      return true;
+    }
+  }
+}
+
+std::optional<Record> LatestCache::Get(uint32_t icao) const
+{
+  if (icao == 0) return {};
+
+  uint64_t h = hash(icao);
+  const Shard& shard = shard_of(h);
+
+  for (size_t i = h & shard.mask ; ; i = (i + 1) & shard.mask)
+  {
+    const Slot& slot = shard.slots[i];
+    uint32_t key = slot.icao.load(std::memory_order_acquire);
+
+    if (key == 0) return {};
+
+    if (key == icao)
+    {
+      Record r;
+      SeqLock::read(slot.seq, [&] { SeqLock::load(slot.words, r); });
+      return r;
+    }
+  }
+}
+
+size_t LatestCache::Size() const
+{
+  size_t n = 0;
+  for (size_t i = 0 ; i < _num_shards ; i++)
+  {
+    n += _shards[i].size.load(std::memory_order_relaxed);
+  }
+  return n;
+}
+
+// called after the record is visible to readers; claims the next version
+// and publishes the station in its log entry, tagged with that version
+void LatestCache::log(uint32_t icao)
+{
+  uint64_t v = _version.fetch_add(1, std::memory_order_acq_rel) + 1;
+  _log[(v - 1) % _log.size()].store((v << 32) | icao,
+                                    std::memory_order_release);
+}
+
+uint64_t LatestCache::Version() const
+{
+  return _version.load(std::memory_order_acquire);
+}
+
+uint64_t LatestCache::Changes(uint64_t since, std::vector<Record>& out) const
+{
+  out.clear();
+
+  uint64_t version = _version.load(std::memory_order_acquire);
+  if (since >= version) return version;
+
+  std::vector<uint32_t> changed;
+  if (version - since <= _log.size())
+  {
+    changed.reserve(version - since);
+    for (uint64_t v = since + 1 ; v <= version ; v++)
+    {
+      uint64_t entry = _log[(v - 1) % _log.size()].load(
+                         std::memory_order_acquire);
+
+      // the tag is the low half of the version that wrote the entry
+      int32_t age = static_cast<int32_t>(static_cast<uint32_t>(entry >> 32)
+                                         - static_cast<uint32_t>(v));
+      if (age < 0)
+      {
+        // not published yet; the next call resumes here
+        version = v - 1;
+        break;
+      }
+      if (age > 0)
+      {
+        // overwritten by a later update
+        changed.clear();
+        break;
+      }
+      changed.push_back(static_cast<uint32_t>(entry));
+    }
+    if (version == since) return version;
+  }
+
+  if (changed.empty())
+  {
+    // the log has wrapped past 'since'
+    for (size_t s = 0 ; s < _num_shards ; s++)
+    {
+      const Shard& shard = _shards[s];
+      for (size_t i = 0 ; i <= shard.mask ; i++)
+      {
+        uint32_t key = shard.slots[i].icao.load(std::memory_order_acquire);
+        if (key != 0) changed.push_back(key);
+      }
+    }
+  }
+  else
+  {
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+  }
+
+  out.reserve(changed.size());
+  for (uint32_t icao : changed)
+  {
+    auto r = Get(icao);
+    if (r.has_value()) out.push_back(*r);
+  }
+
+  return version;
+}
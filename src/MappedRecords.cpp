@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Memory-mapped record file
+//
+
+#include "MappedRecords.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Storage_B::Weather;
+
+std::shared_ptr<MappedRecords> MappedRecords::Create(const char *path)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0
+      || static_cast<size_t>(st.st_size) < RecordCodec::FILE_HEADER_SIZE)
+  {
+    close(fd);
+    return nullptr;
+  }
+
+  size_t length = static_cast<size_t>(st.st_size);
+  void *map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+  if (map == MAP_FAILED) return nullptr;
+
+  uint64_t count;
+  if (!RecordCodec::DecodeHeader(static_cast<const uint8_t *>(map), count)
+      || count > (length - RecordCodec::FILE_HEADER_SIZE)
+                 / RecordCodec::ENCODED_SIZE)
+  {
+    munmap(map, length);
+    return nullptr;
+  }
+
+  return std::shared_ptr<MappedRecords>(
+    new MappedRecords(map, length, static_cast<size_t>(count)));
+}
+
+MappedRecords::~MappedRecords()
+{
+  munmap(_map, _length);
+}
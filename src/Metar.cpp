@@ -8,6 +8,9 @@
 
 #include "Phenom.h"
 #include "Clouds.h"
+#include "Convert.h"
+#include "Utils.h"
+#include "Civil.h"
 
 #include <cstring>
 #include <cstdlib>
@@ -15,6 +18,9 @@
 
 #include <climits>
 #include <cfloat>
+#include <cstdint>
+
+#include <mutex>
 
 using namespace Storage_B::Weather;
 
@@ -149,6 +155,11 @@ namespace
     return strcmp(str, "RMK") == 0;
   }
 
+  inline bool is_cor(const char *str)
+  {
+    return strcmp(str, "COR") == 0;
+  }
+
   inline bool is_tempo(const char *str)
   {
     return strcmp(str, "TEMPO") == 0;
@@ -170,10 +181,27 @@ namespace
     return atoi(val);
   }
     
-  inline double tempNA(char *val)
+  inline int tempNA(char *val)
   {
     if (val[0] == '1') val[0] = '-';
-    return atof(val) / 10.0;
+    return atoi(val);
+  }
+
+  // statute mile visibility in sixteenths; meters are rounded down
+  inline int vis_sixteenths(int vis, Metar::distance_units units)
+  {
+    if (units == Metar::distance_units::SM)
+      return vis;
+    return (vis * Metar::VISIBILITY_SM_SCALE * 1000) / 1609344;
+  }
+
+  template<typename T>
+  inline std::optional<double> scaled(const std::optional<T>& val,
+                                      double scale)
+  {
+    if (val.has_value())
+      return static_cast<double>(*val) / scale;
+    return {};
   }
 }
 
@@ -209,8 +237,9 @@ public:
 class MetarImpl final : public Metar
 {
 public:
-  explicit MetarImpl(const char *metar_str);
-  MetarImpl(char *metar_str);
+  explicit MetarImpl(const char *metar_str,
+                     std::optional<std::time_t> reference = {});
+  MetarImpl(char *metar_str, std::optional<std::time_t> reference = {});
 
   ~MetarImpl() override = default;
 
@@ -220,6 +249,8 @@ public:
   std::optional<message_type> MessageType() const override { return _message_type; }
 
   std::optional<std::string> ICAO() const override { return _icao; }
+
+  bool isCorrection() const override { return _cor; }
       
   std::optional<int> Day() const override { return _day; }
 
@@ -227,6 +258,11 @@ public:
 
   std::optional<int> Minute() const override { return _min; }
 
+  std::optional<int64_t> ObservationTime() const override
+  {
+    return _obs_time;
+  }
+
   std::optional<int> WindDirection() const override { return _wind_dir; }
 
   bool isVariableWindDirection() const override { return _vrb; }
@@ -244,7 +280,14 @@ public:
     return _wind_speed_units;
   }
 
-  std::optional<double> Visibility() const override { return _vis; }
+  std::optional<double> Visibility() const override
+  {
+    if (_vis_units == distance_units::SM)
+      return scaled(_vis, VISIBILITY_SM_SCALE);
+    return scaled(_vis, 1.0);
+  }
+
+  std::optional<int> VisibilityScaled() const override { return _vis; }
 
   std::optional<distance_units> VisibilityUnits() const override
   {
@@ -256,20 +299,92 @@ public:
   bool isCAVOK() const override { return _cavok; }
       
   std::optional<int> VerticalVisibility() const override { return _vert_vis; }
+
+  std::optional<int> Ceiling() const override { return _ceiling; }
+
+  std::optional<flight_category> FlightCategory() const override
+  {
+    return _flight_category;
+  }
   
   std::optional<int> Temperature() const override { return _temp; }
 
   std::optional<int> DewPoint() const override { return _dew; }
 
-  std::optional<double> AltimeterA() const override { return _altimeterA; }
+  std::optional<double> AltimeterA() const override
+  {
+    return scaled(_altimeterA, 100.0);
+  }
+
+  std::optional<int> AltimeterAHundredths() const override
+  {
+    return _altimeterA;
+  }
 
   std::optional<int> AltimeterQ() const override { return _altimeterQ; }
 
-  std::optional<double> SeaLevelPressure() const override { return _slp; }
+  std::optional<double> SeaLevelPressure() const override
+  {
+    return scaled(_slp, 10.0);
+  }
+
+  std::optional<int> SeaLevelPressureTenths() const override { return _slp; }
+
+  std::optional<double> TemperatureNA() const override
+  {
+    return scaled(_ftemp, 10.0);
+  }
+
+  std::optional<int> TemperatureNATenths() const override { return _ftemp; }
 
-  std::optional<double> TemperatureNA() const override { return _ftemp; }
+  std::optional<double> DewPointNA() const override
+  {
+    return scaled(_fdew, 10.0);
+  }
+
+  std::optional<int> DewPointNATenths() const override { return _fdew; }
+
+  std::optional<double> RelativeHumidity() const override
+  {
+    return derived().humidity;
+  }
+
+  std::optional<double> WindChill() const override
+  {
+    return derived().wind_chill;
+  }
+
+  std::optional<double> HeatIndex() const override
+  {
+    return derived().heat_index;
+  }
+
+  std::optional<double> WindSpeedKnots() const override
+  {
+    return derived().wind_speed;
+  }
+
+  std::optional<double> WindGustKnots() const override
+  {
+    return derived().wind_gust;
+  }
 
-  std::optional<double> DewPointNA() const override { return _fdew; }
+  std::optional<double> PressureAltitude(double elevation) const override
+  {
+    auto& d = derived();
+    if (d.pressure_altitude.has_value())
+      return elevation + *d.pressure_altitude;
+    return {};
+  }
+
+  std::optional<double> DensityAltitude(double elevation) const override
+  {
+    auto pa = PressureAltitude(elevation);
+    auto& d = derived();
+    if (pa.has_value() && d.temperature.has_value())
+      return *pa + 120.0 * (*d.temperature - (15.0 - 2.0 * *pa / 1000.0));
+    return {};
+  }
 
   unsigned int NumCloudLayers() const override
   { 
@@ -333,6 +448,29 @@ private:
 
   void parse_phenom(const char *str);
 
+  void update_ceiling(int ceiling);
+
+  void compute_flight_category();
+
+  // quantities derived from the decoded fields, computed on first access
+  struct Derived
+  {
+    std::optional<double> temperature;
+    std::optional<double> humidity;
+    std::optional<double> wind_chill;
+    std::optional<double> heat_index;
+    std::optional<double> wind_speed;
+    std::optional<double> wind_gust;
+    // correction added to the station elevation, in feet
+    std::optional<double> pressure_altitude;
+  };
+
+  const Derived& derived() const;
+
+  void compute_derived() const;
+
+  std::optional<double> knots(const std::optional<int>& speed) const;
+
   std::optional<message_type> _message_type;
 
   std::optional<std::string> _icao;
@@ -341,6 +479,9 @@ private:
   std::optional<int> _hour;
   std::optional<int> _min;
 
+  std::optional<std::time_t> _reference;
+  std::optional<int64_t> _obs_time;
+
   std::optional<int> _wind_dir;
   std::optional<int> _wind_spd;
   std::optional<int> _gust;
@@ -350,7 +491,8 @@ private:
   std::optional<int> _max_wind_dir;
   bool _vrb;
 
-  std::optional<double> _vis;
+  // meters, or sixteenths of a statute mile
+  std::optional<int32_t> _vis;
   std::optional<distance_units> _vis_units;
   bool _vis_lt;
   bool _cavok;
@@ -361,23 +503,33 @@ private:
 
   std::optional<int> _vert_vis;
 
+  std::optional<int> _ceiling;
+  std::optional<flight_category> _flight_category;
+
   std::optional<int> _temp;
   std::optional<int> _dew;
 
-  std::optional<double> _altimeterA;
+  // hundredths of inHg
+  std::optional<int16_t> _altimeterA;
 
   std::optional<int> _altimeterQ;
 
   bool _rmk;
   bool _tempo;
+  bool _cor;
 
-  std::optional<double> _slp;
+  // tenths of hPa
+  std::optional<int16_t> _slp;
 
-  std::optional<double> _ftemp;
-  std::optional<double> _fdew;
+  // tenths of a degree Celsius
+  std::optional<int16_t> _ftemp;
+  std::optional<int16_t> _fdew;
 
   const char *_previous_element;
 
+  mutable std::once_flag _derived_flag;
+  mutable Derived _derived;
+
   std::shared_ptr<Phenom> _default_phenom;
 };
 
@@ -391,24 +543,40 @@ std::shared_ptr<Metar> Metar::Create(char *metar_str)
   return std::make_shared<MetarImpl>(metar_str);
 }
 
+std::shared_ptr<Metar> Metar::Create(const char *metar_str,
+                                     std::time_t reference)
+{
+  return std::make_shared<MetarImpl>(metar_str, reference);
+}
+
+std::shared_ptr<Metar> Metar::Create(char *metar_str, std::time_t reference)
+{
+  return std::make_shared<MetarImpl>(metar_str, reference);
+}
+
 MetarImpl::MetarImpl()
   : _vrb(false)
   , _vis_lt(false)
   , _cavok(false)
   , _rmk(false)
   , _tempo(false)
+  , _cor(false)
   , _previous_element(nullptr)
 {
   _default_phenom = std::make_shared<PhenomDefault>();
 }
 
-MetarImpl::MetarImpl(const char *metar_str) : MetarImpl()
+MetarImpl::MetarImpl(const char *metar_str,
+                     std::optional<std::time_t> reference) : MetarImpl()
 {
+  _reference = reference;
   parse(metar_str);
 }
 
-MetarImpl::MetarImpl(char *metar_str) : MetarImpl()
+MetarImpl::MetarImpl(char *metar_str,
+                     std::optional<std::time_t> reference) : MetarImpl()
 {
+  _reference = reference;
   parse(metar_str);
 }
 
@@ -465,6 +633,10 @@ void MetarImpl::parse(char *metar_str)
     {
       parse_alt(el);
     }
+    else if (!_cor && !_rmk && is_cor(el))
+    {
+      _cor = true;
+    }
     else if (!_tempo && is_tempo(el))
     {
       _tempo = true;
@@ -491,6 +663,8 @@ void MetarImpl::parse(char *metar_str)
 
     el = strtok_r(nullptr, " ", &sp);
   }
+
+  compute_flight_category();
 }
 
 void MetarImpl::parse_message_type(const char *str)
@@ -516,6 +690,11 @@ void MetarImpl::parse_ot(const char *str)
   _hour = atoi(val);
 
   _min = atoi(str + 4);
+
+  if (_reference.has_value())
+  {
+    _obs_time = Civil::resolve_time(*_reference, *_day, *_hour, *_min);
+  }
 }
 
 void MetarImpl::parse_wind(const char *str)
@@ -583,7 +762,7 @@ void MetarImpl::parse_vis(const char *str)
   const char *u = strstr(str, VIS_UNITS_SM);
   if (!u)
   {
-    _vis = atof(str);
+    _vis = atoi(str);
     _vis_units = distance_units::M;
   }
   else
@@ -592,7 +771,7 @@ void MetarImpl::parse_vis(const char *str)
 
     if (!p)
     {
-      _vis = atof(str);
+      _vis = atoi(str) * VISIBILITY_SM_SCALE;
     }
     else
     {
@@ -609,17 +788,20 @@ void MetarImpl::parse_vis(const char *str)
         strncpy(val, str, len);
       }
       val[len] = '\0';
-      double numerator = atof(val);
+      int numerator = atoi(val);
 
       len = u - p;
       strncpy(val, p + 1, len);
       val[len] = '\0';
-      double denominator = atof(val);
+      int denominator = atoi(val);
+      if (denominator <= 0) return;
 
-      double vis = numerator / denominator;
+      // round to the nearest sixteenth; exact for the reportable fractions
+      int vis = ((numerator * VISIBILITY_SM_SCALE) + (denominator / 2))
+                                                          / denominator;
       if (match("#", _previous_element))
       {
-        vis += atof(_previous_element);
+        vis += atoi(_previous_element) * VISIBILITY_SM_SCALE;
       }
       _vis = vis;
     }
@@ -634,12 +816,63 @@ void MetarImpl::parse_cloud_layer(const char *str)
   if (c != nullptr)
   {
     _layers.push_back(c);
+
+    if (!c->Temporary() && c->Altitude().has_value() &&
+        (c->Cover() == Clouds::cover::BKN || c->Cover() == Clouds::cover::OVC))
+    {
+      update_ceiling(*c->Altitude() * 100);
+    }
   }
 }
 
 void MetarImpl::parse_vert_vis(const char *str)
 {
   _vert_vis = atoi(str + 2) * 100;
+  if (!_tempo)
+  {
+    update_ceiling(*_vert_vis);
+  }
+}
+
+void MetarImpl::update_ceiling(int ceiling)
+{
+  if (!_ceiling.has_value() || ceiling < *_ceiling)
+  {
+    _ceiling = ceiling;
+  }
+}
+
+void MetarImpl::compute_flight_category()
+{
+  if (_cavok)
+  {
+    _flight_category = flight_category::VFR;
+    return;
+  }
+
+  if (!_ceiling.has_value() && !_vis.has_value())
+  {
+    return;
+  }
+
+  int cat = 0;
+
+  if (_ceiling.has_value())
+  {
+    int c = *_ceiling;
+    cat = (c <= 3000) + (c < 1000) + (c < 500);
+  }
+
+  if (_vis.has_value() && _vis_units.has_value())
+  {
+    int v = vis_sixteenths(*_vis, *_vis_units);
+    int vcat = (v <= 5 * VISIBILITY_SM_SCALE)
+             + (v < 3 * VISIBILITY_SM_SCALE)
+             + (v < VISIBILITY_SM_SCALE);
+    if (vcat > cat) cat = vcat;
+  }
+
+  _flight_category = static_cast<flight_category>(cat);
 }
 
 void MetarImpl::parse_temp(const char *str)
@@ -665,7 +898,7 @@ void MetarImpl::parse_alt(const char *str)
   if (str[0] == 'Q')
     _altimeterQ = val;
   else
-    _altimeterA = static_cast<double>(val) / 100.0;
+    _altimeterA = val;
 }
 
 void MetarImpl::parse_phenom(const char *str)
@@ -680,7 +913,7 @@ void MetarImpl::parse_phenom(const char *str)
 
 void MetarImpl::parse_slp(const char *str)
 {
-  _slp = (atof(str + 3) / 10.0) + 1000.0;
+  _slp = atoi(str + 3) + 10000;
 }
 
 void MetarImpl::parse_tempNA(const char *str)
@@ -698,3 +931,68 @@ void MetarImpl::parse_tempNA(const char *str)
     _fdew = tempNA(val);
   }
 }
+
+const MetarImpl::Derived& MetarImpl::derived() const
+{
+  std::call_once(_derived_flag, [this] { compute_derived(); });
+  return _derived;
+}
+
+std::optional<double> MetarImpl::knots(const std::optional<int>& speed) const
+{
+  if (!speed.has_value() || !_wind_speed_units.has_value())
+    return {};
+
+  switch (*_wind_speed_units)
+  {
+    case speed_units::MPS:
+      return *speed / Convert::Kts2Mps(1.0);
+
+    case speed_units::KPH:
+      return *speed / Convert::Kts2Kph(1.0);
+
+    default:
+      return static_cast<double>(*speed);
+  }
+}
+
+void MetarImpl::compute_derived() const
+{
+  std::optional<int> t = _ftemp;
+  if (!t.has_value() && _temp.has_value()) t = *_temp * 10;
+
+  std::optional<int> td = _fdew;
+  if (!td.has_value() && _dew.has_value()) td = *_dew * 10;
+
+  if (t.has_value())
+  {
+    _derived.temperature = *t / 10.0;
+  }
+
+  if (t.has_value() && td.has_value())
+  {
+    _derived.humidity = Utils::HumidityTenths(*t, *td);
+    _derived.heat_index = Utils::HeatIndex(*_derived.temperature,
+                                           *_derived.humidity);
+  }
+
+  _derived.wind_speed = knots(_wind_spd);
+  _derived.wind_gust = knots(_gust);
+
+  if (t.has_value() && _derived.wind_speed.has_value())
+  {
+    _derived.wind_chill = Utils::WindChill(*_derived.temperature,
+                            Convert::Kts2Kph(*_derived.wind_speed));
+  }
+
+  std::optional<double> inHg;
+  if (_altimeterA.has_value())
+    inHg = *_altimeterA / 100.0;
+  else if (_altimeterQ.has_value())
+    inHg = Convert::mb2InMg(*_altimeterQ);
+
+  if (inHg.has_value())
+  {
+    _derived.pressure_altitude = (29.92 - *inHg) * 1000.0;
+  }
+}
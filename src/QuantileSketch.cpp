@@ -0,0 +1,516 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Mergeable quantile sketches of station reports
+//
+
+#include "QuantileSketch.h"
+
+#include "Batch.h"
+#include "Convert.h"
+#include "Metar.h"
+#include "Varint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <utility>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  constexpr uint8_t SKETCH_VERSION = 1;
+  constexpr uint8_t STATIONS_VERSION = 1;
+
+  constexpr uint16_t MIN_K = 8;
+
+  // compactors beyond this would give values weights of 2^64
+  constexpr size_t MAX_COMPACTORS = 60;
+
+  // capacities shrink by this factor from the top compactor down
+  constexpr double SHRINK = 2.0 / 3.0;
+
+  constexpr uint64_t GOLDEN = 0x9E3779B97F4A7C15ULL;
+
+  // sketches are numbered so that each draws its own random offsets
+  std::atomic<uint64_t> instances{0};
+
+  // splitmix64; never returns 0, which xorshift could not leave
+  uint64_t mix(uint64_t x)
+  {
+    x += GOLDEN;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x != 0 ? x : GOLDEN;
+  }
+
+  constexpr size_t NUM_FIELDS =
+    static_cast<size_t>(Filter::field::FLIGHT_CATEGORY) + 1;
+
+  void put_double(std::vector<uint8_t>& out, double v)
+  {
+    uint64_t bits = std::bit_cast<uint64_t>(v);
+    for (int i = 0 ; i < 8 ; i++)
+    {
+      out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+  }
+
+  bool get_double(const uint8_t *& p, const uint8_t *end, double& v)
+  {
+    if (end - p < 8) return false;
+    uint64_t bits = 0;
+    for (int i = 0 ; i < 8 ; i++)
+    {
+      bits |= static_cast<uint64_t>(*p++) << (8 * i);
+    }
+    v = std::bit_cast<double>(bits);
+    return true;
+  }
+
+  bool get(const uint8_t *& p, const uint8_t *end, uint64_t& v, uint64_t max)
+  {
+    return Varint::get(p, end, v) && v <= max;
+  }
+
+  // a value of a report in the units of Filter::field, NaN if absent
+  double value(const Record& r, Filter::field f)
+  {
+    switch (f)
+    {
+      case Filter::field::VISIBILITY:
+      {
+        double m;
+        if (r.flags & Record::CAVOK)
+          m = Batch::CAVOK_VISIBILITY;
+        else if (!r.Has(Record::VISIBILITY))
+          return NAN;
+        else if (r.vis_units
+                 == static_cast<uint8_t>(Metar::distance_units::SM))
+          return r.visibility / static_cast<double>(Metar::VISIBILITY_SM_SCALE);
+        else
+          m = r.visibility;
+        return m / (Convert::Miles2Km(1.0) * 1000.0);
+      }
+      case Filter::field::CEILING:
+        return r.Has(Record::CEILING) ? r.ceiling : NAN;
+      case Filter::field::WIND_SPEED:
+      case Filter::field::WIND_GUST:
+      {
+        const bool gust = f == Filter::field::WIND_GUST;
+        if (!r.Has(gust ? Record::WIND_GUST : Record::WIND_SPEED)
+            || !r.Has(Record::WIND_UNITS))
+          return NAN;
+
+        const double v = gust ? r.wind_gust : r.wind_speed;
+        switch (static_cast<Metar::speed_units>(r.wind_units))
+        {
+          case Metar::speed_units::KT:
+            return v;
+          case Metar::speed_units::MPS:
+            return v / Convert::Kts2Mps(1.0);
+          case Metar::speed_units::KPH:
+            return v / Convert::Kts2Kph(1.0);
+        }
+        return NAN;
+      }
+      case Filter::field::TEMPERATURE:
+        if (r.Has(Record::TEMPERATURE_NA)) return r.temperature_na / 10.0;
+        return r.Has(Record::TEMPERATURE) ? r.temperature : NAN;
+      case Filter::field::DEW_POINT:
+        if (r.Has(Record::DEW_POINT_NA)) return r.dew_point_na / 10.0;
+        return r.Has(Record::DEW_POINT) ? r.dew_point : NAN;
+      case Filter::field::SEA_LEVEL_PRESSURE:
+        if (!r.Has(Record::SEA_LEVEL_PRESS)) return NAN;
+        return r.sea_level_press / 10.0;
+      case Filter::field::FLIGHT_CATEGORY:
+        return r.Has(Record::FLIGHT_CATEGORY) ? r.flight_category : NAN;
+    }
+    return NAN;
+  }
+}
+
+QuantileSketch::QuantileSketch(uint16_t k)
+  : _k(std::max(k, MIN_K))
+  , _min(NAN)
+  , _max(NAN)
+  , _random(mix(instances.fetch_add(1, std::memory_order_relaxed)))
+{
+  levels(1);
+}
+
+void QuantileSketch::levels(size_t n)
+{
+  _compactors.resize(n);
+  _capacity.resize(n);
+
+  _max_size = 0;
+  for (size_t h = 0 ; h < n ; h++)
+  {
+    const double depth = static_cast<double>(n - 1 - h);
+    const double c = std::ceil(_k * std::pow(SHRINK, depth));
+    _capacity[h] = std::max<size_t>(2, static_cast<size_t>(c));
+    _max_size += _capacity[h];
+  }
+}
+
+void QuantileSketch::compress()
+{
+  for (size_t h = 0 ; h < _compactors.size() ; h++)
+  {
+    if (_compactors[h].size() < _capacity[h]) continue;
+
+    if (h + 1 == _compactors.size()) levels(h + 2);
+
+    std::vector<double>& c = _compactors[h];
+    std::vector<double>& next = _compactors[h + 1];
+    std::sort(c.begin(), c.end());
+
+    // xorshift; the offset alternates at random so that the promoted values
+    // are an unbiased sample of the pairs
+    _random ^= _random << 13;
+    _random ^= _random >> 7;
+    _random ^= _random << 17;
+
+    // of an odd number of values the smallest stays behind
+    const size_t odd = c.size() & 1;
+    const size_t pairs = c.size() / 2;
+    for (size_t i = odd + (_random & 1) ; i < c.size() ; i += 2)
+    {
+      next.push_back(c[i]);
+    }
+    c.resize(odd);
+    _size -= pairs;
+
+    if (_size < _max_size) break;
+  }
+}
+
+void QuantileSketch::Add(double v)
+{
+  if (std::isnan(v)) return;
+
+  if (_count == 0)
+  {
+    _min = _max = v;
+  }
+  else
+  {
+    _min = std::min(_min, v);
+    _max = std::max(_max, v);
+  }
+  _count++;
+
+  _compactors[0].push_back(v);
+  if (++_size >= _max_size) compress();
+}
+
+bool QuantileSketch::Merge(const QuantileSketch& other)
+{
+  if (other._k != _k) return false;
+  if (other._count == 0) return true;
+
+  if (_count == 0)
+  {
+    _min = other._min;
+    _max = other._max;
+  }
+  else
+  {
+    _min = std::min(_min, other._min);
+    _max = std::max(_max, other._max);
+  }
+  _count += other._count;
+  // equal states, e.g., of two fresh sketches, must not cancel out
+  _random = mix(_random ^ std::rotl(other._random, 32) ^ _count);
+
+  if (_compactors.size() < other._compactors.size())
+    levels(other._compactors.size());
+
+  for (size_t h = 0 ; h < other._compactors.size() ; h++)
+  {
+    const std::vector<double>& o = other._compactors[h];
+    _compactors[h].insert(_compactors[h].end(), o.begin(), o.end());
+    _size += o.size();
+  }
+
+  while (_size >= _max_size) compress();
+  return true;
+}
+
+void QuantileSketch::Quantiles(std::span<const double> q,
+                               std::span<double> out) const
+{
+  if (_count == 0)
+  {
+    std::fill(out.begin(), out.begin() + q.size(), NAN);
+    return;
+  }
+
+  // the retained values, weighted by the number of values each stands for
+  std::vector<std::pair<double, uint64_t>> weighted;
+  weighted.reserve(_size);
+  for (size_t h = 0 ; h < _compactors.size() ; h++)
+  {
+    for (double v : _compactors[h]) weighted.push_back({ v, 1ULL << h });
+  }
+  std::sort(weighted.begin(), weighted.end());
+
+  uint64_t cumulative = 0;
+  for (auto& w : weighted)
+  {
+    cumulative += w.second;
+    w.second = cumulative;
+  }
+
+  for (size_t i = 0 ; i < q.size() ; i++)
+  {
+    if (!(q[i] > 0.0))
+    {
+      out[i] = _min;
+    }
+    else if (q[i] >= 1.0)
+    {
+      out[i] = _max;
+    }
+    else
+    {
+      const double target = q[i] * static_cast<double>(_count);
+      auto it = std::lower_bound(weighted.begin(), weighted.end(), target,
+                                 [](const auto& w, double t) {
+                                   return static_cast<double>(w.second) < t;
+                                 });
+      out[i] = it != weighted.end() ? it->first : _max;
+    }
+  }
+}
+
+double QuantileSketch::Quantile(double q) const
+{
+  double v;
+  Quantiles(std::span<const double>(&q, 1), std::span<double>(&v, 1));
+  return v;
+}
+
+double QuantileSketch::Rank(double v) const
+{
+  if (_count == 0) return NAN;
+
+  uint64_t weight = 0;
+  for (size_t h = 0 ; h < _compactors.size() ; h++)
+  {
+    for (double x : _compactors[h])
+    {
+      if (x <= v) weight += 1ULL << h;
+    }
+  }
+  return static_cast<double>(weight) / static_cast<double>(_count);
+}
+
+double QuantileSketch::Min() const
+{
+  return _min;
+}
+
+double QuantileSketch::Max() const
+{
+  return _max;
+}
+
+void QuantileSketch::Serialize(std::vector<uint8_t>& out) const
+{
+  out.push_back(SKETCH_VERSION);
+  Varint::put(out, _k);
+  Varint::put(out, _count);
+  if (_count == 0) return;
+
+  put_double(out, _min);
+  put_double(out, _max);
+  Varint::put(out, _compactors.size());
+  for (const auto& c : _compactors)
+  {
+    Varint::put(out, c.size());
+    for (double v : c) put_double(out, v);
+  }
+}
+
+std::shared_ptr<QuantileSketch>
+QuantileSketch::Create(std::span<const uint8_t> in, size_t& consumed)
+{
+  consumed = 0;
+
+  const uint8_t *p = in.data();
+  const uint8_t *end = p + in.size();
+
+  uint64_t k, count;
+  if (p >= end || *p++ != SKETCH_VERSION) return nullptr;
+  if (!get(p, end, k, UINT16_MAX) || k < MIN_K) return nullptr;
+  if (!get(p, end, count, UINT64_MAX)) return nullptr;
+
+  auto sketch = std::make_shared<QuantileSketch>(static_cast<uint16_t>(k));
+
+  if (count > 0)
+  {
+    uint64_t levels;
+    if (!get_double(p, end, sketch->_min) || !get_double(p, end, sketch->_max)
+        || !(sketch->_min <= sketch->_max)
+        || !get(p, end, levels, MAX_COMPACTORS) || levels == 0)
+      return nullptr;
+
+    sketch->levels(levels);
+
+    // the weights of the retained values must add up to the count
+    uint64_t weight = 0;
+    for (size_t h = 0 ; h < levels ; h++)
+    {
+      uint64_t n;
+      if (!get(p, end, n, static_cast<uint64_t>(end - p) / 8)) return nullptr;
+
+      std::vector<double>& c = sketch->_compactors[h];
+      c.resize(n);
+      for (double& v : c)
+      {
+        get_double(p, end, v);
+        if (!(v >= sketch->_min && v <= sketch->_max)) return nullptr;
+      }
+      weight += n << h;
+      sketch->_size += n;
+    }
+    if (weight != count) return nullptr;
+
+    sketch->_count = count;
+    while (sketch->_size >= sketch->_max_size) sketch->compress();
+  }
+
+  consumed = static_cast<size_t>(p - in.data());
+  return sketch;
+}
+
+StationSketches::StationSketches(const std::vector<Filter::field>& fields,
+                                 uint16_t k)
+  : _fields(fields)
+  , _k(std::max(k, MIN_K))
+{
+}
+
+std::vector<QuantileSketch>& StationSketches::station(uint32_t icao)
+{
+  auto it = _stations.find(icao);
+  if (it == _stations.end())
+  {
+    std::vector<QuantileSketch> sketches;
+    sketches.reserve(_fields.size());
+    for (size_t i = 0 ; i < _fields.size() ; i++) sketches.emplace_back(_k);
+    it = _stations.emplace(icao, std::move(sketches)).first;
+  }
+  return it->second;
+}
+
+bool StationSketches::Add(const Record& record)
+{
+  if (record.icao == 0) return false;
+
+  std::vector<QuantileSketch>& sketches = station(record.icao);
+  for (size_t i = 0 ; i < _fields.size() ; i++)
+  {
+    sketches[i].Add(value(record, _fields[i]));
+  }
+  return true;
+}
+
+bool StationSketches::Merge(const StationSketches& other)
+{
+  if (other._fields != _fields || other._k != _k) return false;
+
+  for (const auto& [icao, theirs] : other._stations)
+  {
+    std::vector<QuantileSketch>& ours = station(icao);
+    for (size_t i = 0 ; i < _fields.size() ; i++)
+    {
+      ours[i].Merge(theirs[i]);
+    }
+  }
+  return true;
+}
+
+const QuantileSketch *StationSketches::Get(uint32_t icao,
+                                           Filter::field f) const
+{
+  auto it = _stations.find(icao);
+  if (it == _stations.end()) return nullptr;
+
+  auto field = std::find(_fields.begin(), _fields.end(), f);
+  if (field == _fields.end()) return nullptr;
+
+  return &it->second[static_cast<size_t>(field - _fields.begin())];
+}
+
+void StationSketches::Serialize(std::vector<uint8_t>& out) const
+{
+  out.push_back(STATIONS_VERSION);
+  Varint::put(out, _k);
+  Varint::put(out, _fields.size());
+  for (Filter::field f : _fields) Varint::put(out, static_cast<uint64_t>(f));
+
+  Varint::put(out, _stations.size());
+  for (const auto& [icao, sketches] : _stations)
+  {
+    Varint::put(out, icao);
+    for (const QuantileSketch& s : sketches) s.Serialize(out);
+  }
+}
+
+std::shared_ptr<StationSketches>
+StationSketches::Create(std::span<const uint8_t> in)
+{
+  const uint8_t *p = in.data();
+  const uint8_t *end = p + in.size();
+
+  uint64_t k, num_fields, num_stations;
+  if (p >= end || *p++ != STATIONS_VERSION) return nullptr;
+  if (!get(p, end, k, UINT16_MAX) || k < MIN_K) return nullptr;
+  if (!get(p, end, num_fields, NUM_FIELDS)) return nullptr;
+
+  std::vector<Filter::field> fields;
+  for (uint64_t i = 0 ; i < num_fields ; i++)
+  {
+    uint64_t f;
+    if (!get(p, end, f, NUM_FIELDS - 1)) return nullptr;
+    fields.push_back(static_cast<Filter::field>(f));
+  }
+
+  auto sketches = std::make_shared<StationSketches>(
+                    fields, static_cast<uint16_t>(k));
+
+  if (!get(p, end, num_stations, static_cast<uint64_t>(end - p)))
+    return nullptr;
+
+  for (uint64_t i = 0 ; i < num_stations ; i++)
+  {
+    uint64_t icao;
+    if (!get(p, end, icao, UINT32_MAX) || icao == 0) return nullptr;
+
+    std::vector<QuantileSketch> station;
+    station.reserve(fields.size());
+    for (size_t f = 0 ; f < fields.size() ; f++)
+    {
+      size_t consumed;
+      auto s = QuantileSketch::Create(
+                 std::span<const uint8_t>(p, static_cast<size_t>(end - p)),
+                 consumed);
+      if (!s || s->K() != sketches->_k) return nullptr;
+      p += consumed;
+      station.push_back(std::move(*s));
+    }
+
+    if (!sketches->_stations.emplace(static_cast<uint32_t>(icao),
+                                     std::move(station)).second)
+      return nullptr;
+  }
+
+  if (p != end) return nullptr;
+  return sketches;
+}
@@ -0,0 +1,160 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Flat decoded METAR record
+//
+
+#include "Record.h"
+
+#include "Metar.h"
+#include "Clouds.h"
+#include "Phenom.h"
+
+#include <cstring>
+#include <type_traits>
+
+using namespace Storage_B::Weather;
+
+static_assert(std::is_trivially_copyable_v<Record>);
+
+namespace
+{
+  template<typename T, typename V>
+  inline void set(Record& r, Record::field f, T& dst, const std::optional<V>& v)
+  {
+    if (v.has_value())
+    {
+      dst = static_cast<T>(*v);
+      r.present |= f;
+    }
+  }
+}
+
+Record Record::Create(const Metar& metar)
+{
+  Record r;
+  memset(&r, 0, sizeof(r));
+
+  auto icao = metar.ICAO();
+  if (icao.has_value())
+  {
+    r.icao = PackICAO(icao->c_str());
+    r.present |= ICAO;
+  }
+
+  set(r, MESSAGE_TYPE, r.message_type, metar.MessageType());
+
+  if (metar.Day().has_value())
+  {
+    r.day = static_cast<uint8_t>(*metar.Day());
+    r.hour = static_cast<uint8_t>(*metar.Hour());
+    r.minute = static_cast<uint8_t>(*metar.Minute());
+    r.present |= TIME;
+  }
+
+  set(r, OBSERVATION_TIME, r.obs_time, metar.ObservationTime());
+
+  set(r, WIND_DIRECTION, r.wind_dir, metar.WindDirection());
+  set(r, WIND_SPEED, r.wind_speed, metar.WindSpeed());
+  set(r, WIND_GUST, r.wind_gust, metar.WindGust());
+  set(r, WIND_UNITS, r.wind_units, metar.WindSpeedUnits());
+
+  if (metar.MinWindDirection().has_value())
+  {
+    r.min_wind_dir = static_cast<int16_t>(*metar.MinWindDirection());
+    r.max_wind_dir = static_cast<int16_t>(*metar.MaxWindDirection());
+    r.present |= WIND_RANGE;
+  }
+
+  if (metar.VisibilityScaled().has_value())
+  {
+    r.visibility = *metar.VisibilityScaled();
+    r.vis_units = static_cast<uint8_t>(*metar.VisibilityUnits());
+    r.present |= VISIBILITY;
+  }
+
+  set(r, VERTICAL_VIS, r.vertical_vis, metar.VerticalVisibility());
+  set(r, CEILING, r.ceiling, metar.Ceiling());
+  set(r, FLIGHT_CATEGORY, r.flight_category, metar.FlightCategory());
+
+  set(r, TEMPERATURE, r.temperature, metar.Temperature());
+  set(r, DEW_POINT, r.dew_point, metar.DewPoint());
+  set(r, TEMPERATURE_NA, r.temperature_na, metar.TemperatureNATenths());
+  set(r, DEW_POINT_NA, r.dew_point_na, metar.DewPointNATenths());
+
+  set(r, ALTIMETER_A, r.altimeter_a, metar.AltimeterAHundredths());
+  set(r, ALTIMETER_Q, r.altimeter_q, metar.AltimeterQ());
+  set(r, SEA_LEVEL_PRESS, r.sea_level_press, metar.SeaLevelPressureTenths());
+
+  if (metar.isVariableWindDirection()) r.flags |= VARIABLE_WIND;
+  if (metar.isCAVOK()) r.flags |= CAVOK;
+  if (metar.isVisibilityLessThan()) r.flags |= VISIBILITY_LT;
+  if (metar.isCorrection()) r.flags |= CORRECTION;
+
+  for (unsigned int i = 0 ;
+       i < metar.NumCloudLayers() && r.num_layers < MAX_LAYERS ; i++)
+  {
+    auto c = metar.Layer(i);
+    Layer& l = r.layers[r.num_layers++];
+    l.cover = static_cast<uint8_t>(c->Cover());
+    l.altitude = c->Altitude().has_value()
+               ? static_cast<int16_t>(*c->Altitude()) : -1;
+    l.type = c->CloudType().has_value()
+           ? static_cast<uint8_t>(*c->CloudType()) : NONE8;
+    l.tempo = c->Temporary();
+  }
+
+  for (unsigned int i = 0 ;
+       i < metar.NumPhenomena() && r.num_phenomena < MAX_PHENOMENA ; i++)
+  {
+    r.phenomena[r.num_phenomena++] = Phenomenon::Create(metar.Phenomenon(i));
+  }
+
+  return r;
+}
+
+Record::Phenomenon Record::Phenomenon::Create(const Phenom& p)
+{
+  Phenomenon ph;
+  memset(&ph, 0, sizeof(ph));
+
+  ph.intensity = static_cast<int8_t>(p.Intensity());
+  ph.attributes = (p.Blowing() ? BLOWING : 0)
+                | (p.Freezing() ? FREEZING : 0)
+                | (p.Drifting() ? DRIFTING : 0)
+                | (p.Vicinity() ? VICINITY : 0)
+                | (p.Partial() ? PARTIAL : 0)
+                | (p.Shallow() ? SHALLOW : 0)
+                | (p.Patches() ? PATCHES : 0)
+                | (p.ThunderStorm() ? THUNDERSTORM : 0)
+                | (p.Temporary() ? TEMPORARY : 0);
+
+  for (unsigned int j = 0 ; j < p.NumPhenom() && j < MAX_PHENOM ; j++)
+  {
+    ph.phenom[j] = static_cast<uint8_t>(p[j]);
+  }
+
+  return ph;
+}
+
+uint32_t Record::PackICAO(const char *icao)
+{
+  uint32_t packed = 0;
+  for (size_t i = 0 ; i < 4 && icao[i] ; i++)
+  {
+    packed |= static_cast<uint32_t>(static_cast<uint8_t>(icao[i]))
+                                                        << (24 - 8 * i);
+  }
+  return packed;
+}
+
+std::string Record::UnpackICAO(uint32_t icao)
+{
+  std::string s;
+  for (int i = 0 ; i < 4 ; i++)
+  {
+    char c = static_cast<char>(icao >> (24 - 8 * i));
+    if (c) s += c;
+  }
+  return s;
+}
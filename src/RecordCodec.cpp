@@ -0,0 +1,233 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Binary encoding of decoded METAR records
+//
+
+#include "RecordCodec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  // records encoded or decoded per stream read or write
+  constexpr size_t BLOCK = 4096;
+
+  template<typename T>
+  inline uint8_t *put(uint8_t *p, T v)
+  {
+    using U = std::make_unsigned_t<T>;
+    U u = static_cast<U>(v);
+    for (size_t i = 0 ; i < sizeof(T) ; i++)
+    {
+      *p++ = static_cast<uint8_t>(u >> (8 * i));
+    }
+    return p;
+  }
+
+  template<typename T>
+  inline const uint8_t *get(const uint8_t *p, T& v)
+  {
+    using U = std::make_unsigned_t<T>;
+    U u = 0;
+    for (size_t i = 0 ; i < sizeof(T) ; i++)
+    {
+      u |= static_cast<U>(static_cast<U>(*p++) << (8 * i));
+    }
+    v = static_cast<T>(u);
+    return p;
+  }
+}
+
+// Fields are written in the order of the offset enumeration, followed by
+// the layers (altitude, cover, type, tempo) and phenomena (attributes,
+// intensity, phenom x MAX_PHENOM); the remaining bytes are reserved, zero.
+void RecordCodec::Encode(const Record& r, uint8_t *out)
+{
+  uint8_t *p = out;
+
+  p = put(p, r.icao);
+  p = put(p, r.present);
+  p = put(p, r.obs_time);
+
+  p = put(p, r.visibility);
+  p = put(p, r.ceiling);
+  p = put(p, r.vertical_vis);
+
+  p = put(p, r.wind_dir);
+  p = put(p, r.wind_speed);
+  p = put(p, r.wind_gust);
+  p = put(p, r.min_wind_dir);
+  p = put(p, r.max_wind_dir);
+
+  p = put(p, r.temperature_na);
+  p = put(p, r.dew_point_na);
+  p = put(p, r.altimeter_a);
+  p = put(p, r.altimeter_q);
+  p = put(p, r.sea_level_press);
+
+  p = put(p, r.temperature);
+  p = put(p, r.dew_point);
+  p = put(p, r.day);
+  p = put(p, r.hour);
+  p = put(p, r.minute);
+  p = put(p, r.message_type);
+  p = put(p, r.wind_units);
+  p = put(p, r.vis_units);
+  p = put(p, r.flight_category);
+  p = put(p, r.flags);
+  p = put(p, r.num_layers);
+  p = put(p, r.num_phenomena);
+
+  for (const auto& l : r.layers)
+  {
+    p = put(p, l.altitude);
+    p = put(p, l.cover);
+    p = put(p, l.type);
+    p = put(p, l.tempo);
+  }
+
+  for (const auto& ph : r.phenomena)
+  {
+    p = put(p, ph.attributes);
+    p = put(p, ph.intensity);
+    for (auto v : ph.phenom) p = put(p, v);
+  }
+
+  memset(p, 0, out + ENCODED_SIZE - p);
+}
+
+bool RecordCodec::Decode(const uint8_t *in, Record& r)
+{
+  memset(&r, 0, sizeof(r));
+
+  const uint8_t *p = in;
+
+  p = get(p, r.icao);
+  p = get(p, r.present);
+  p = get(p, r.obs_time);
+
+  p = get(p, r.visibility);
+  p = get(p, r.ceiling);
+  p = get(p, r.vertical_vis);
+
+  p = get(p, r.wind_dir);
+  p = get(p, r.wind_speed);
+  p = get(p, r.wind_gust);
+  p = get(p, r.min_wind_dir);
+  p = get(p, r.max_wind_dir);
+
+  p = get(p, r.temperature_na);
+  p = get(p, r.dew_point_na);
+  p = get(p, r.altimeter_a);
+  p = get(p, r.altimeter_q);
+  p = get(p, r.sea_level_press);
+
+  p = get(p, r.temperature);
+  p = get(p, r.dew_point);
+  p = get(p, r.day);
+  p = get(p, r.hour);
+  p = get(p, r.minute);
+  p = get(p, r.message_type);
+  p = get(p, r.wind_units);
+  p = get(p, r.vis_units);
+  p = get(p, r.flight_category);
+  p = get(p, r.flags);
+  p = get(p, r.num_layers);
+  p = get(p, r.num_phenomena);
+
+  for (auto& l : r.layers)
+  {
+    p = get(p, l.altitude);
+    p = get(p, l.cover);
+    p = get(p, l.type);
+    p = get(p, l.tempo);
+  }
+
+  for (auto& ph : r.phenomena)
+  {
+    p = get(p, ph.attributes);
+    p = get(p, ph.intensity);
+    for (auto& v : ph.phenom) p = get(p, v);
+  }
+
+  return r.num_layers <= Record::MAX_LAYERS
+      && r.num_phenomena <= Record::MAX_PHENOMENA;
+}
+
+void RecordCodec::EncodeHeader(uint64_t count, uint8_t *out)
+{
+  memcpy(out, MAGIC, sizeof(MAGIC));
+  uint8_t *p = out + sizeof(MAGIC);
+  p = put(p, VERSION);
+  p = put(p, static_cast<uint16_t>(ENCODED_SIZE));
+  put(p, count);
+}
+
+bool RecordCodec::DecodeHeader(const uint8_t *in, uint64_t& count)
+{
+  if (memcmp(in, MAGIC, sizeof(MAGIC)) != 0) return false;
+
+  uint16_t version, size;
+  const uint8_t *p = in + sizeof(MAGIC);
+  p = get(p, version);
+  p = get(p, size);
+  get(p, count);
+
+  return version == VERSION && size == ENCODED_SIZE;
+}
+
+bool RecordCodec::Write(std::ostream& os, std::span<const Record> records)
+{
+  uint8_t header[FILE_HEADER_SIZE];
+  EncodeHeader(records.size(), header);
+  os.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+  std::vector<uint8_t> buf(BLOCK * ENCODED_SIZE);
+  for (size_t i = 0 ; i < records.size() && os ; i += BLOCK)
+  {
+    size_t n = std::min(BLOCK, records.size() - i);
+    for (size_t j = 0 ; j < n ; j++)
+    {
+      Encode(records[i + j], buf.data() + j * ENCODED_SIZE);
+    }
+    os.write(reinterpret_cast<const char *>(buf.data()), n * ENCODED_SIZE);
+  }
+
+  return static_cast<bool>(os);
+}
+
+bool RecordCodec::Read(std::istream& is, std::vector<Record>& records)
+{
+  uint8_t header[FILE_HEADER_SIZE];
+  uint64_t count;
+
+  if (!is.read(reinterpret_cast<char *>(header), sizeof(header))
+      || !DecodeHeader(header, count)) return false;
+
+  std::vector<uint8_t> buf(BLOCK * ENCODED_SIZE);
+  while (count > 0)
+  {
+    size_t n = static_cast<size_t>(std::min<uint64_t>(BLOCK, count));
+    if (!is.read(reinterpret_cast<char *>(buf.data()), n * ENCODED_SIZE))
+      return false;
+
+    size_t base = records.size();
+    records.resize(base + n);
+    for (size_t j = 0 ; j < n ; j++)
+    {
+      if (!Decode(buf.data() + j * ENCODED_SIZE, records[base + j]))
+      {
+        records.resize(base + j);
+        return false;
+      }
+    }
+    count -= n;
+  }
+
+  return true;
+}
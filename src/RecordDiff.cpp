@@ -0,0 +1,145 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Field-level differences between decoded records
+//
+
+#include "RecordDiff.h"
+
+#include "LatestCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  struct part
+  {
+    uint32_t bit;
+    bool (*equal)(const Record&, const Record&);
+    void (*copy)(Record&, const Record&);
+  };
+
+  template<auto... M>
+  constexpr part members(uint32_t bit)
+  {
+    return part{ bit,
+                 [](const Record& a, const Record& b)
+                 {
+                   return ((a.*M == b.*M) && ...);
+                 },
+                 [](Record& a, const Record& b) { ((a.*M = b.*M), ...); } };
+  }
+
+  // inline arrays, compared over the used entries and copied whole
+  template<auto N, auto A>
+  constexpr part array(uint32_t bit)
+  {
+    return part{ bit,
+                 [](const Record& a, const Record& b)
+                 {
+                   return a.*N == b.*N
+                       && std::equal(a.*A, a.*A + a.*N, b.*A);
+                 },
+                 [](Record& a, const Record& b)
+                 {
+                   a.*N = b.*N;
+                   std::copy(std::begin(b.*A), std::end(b.*A), a.*A);
+                 } };
+  }
+
+  const part PARTS[] =
+  {
+    members<&Record::message_type>(Record::MESSAGE_TYPE),
+    members<&Record::icao>(Record::ICAO),
+    members<&Record::day, &Record::hour, &Record::minute>(Record::TIME),
+    members<&Record::obs_time>(Record::OBSERVATION_TIME),
+    members<&Record::wind_dir>(Record::WIND_DIRECTION),
+    members<&Record::wind_speed>(Record::WIND_SPEED),
+    members<&Record::wind_gust>(Record::WIND_GUST),
+    members<&Record::min_wind_dir, &Record::max_wind_dir>(Record::WIND_RANGE),
+    members<&Record::wind_units>(Record::WIND_UNITS),
+    members<&Record::visibility, &Record::vis_units>(Record::VISIBILITY),
+    members<&Record::vertical_vis>(Record::VERTICAL_VIS),
+    members<&Record::ceiling>(Record::CEILING),
+    members<&Record::flight_category>(Record::FLIGHT_CATEGORY),
+    members<&Record::temperature>(Record::TEMPERATURE),
+    members<&Record::dew_point>(Record::DEW_POINT),
+    members<&Record::altimeter_a>(Record::ALTIMETER_A),
+    members<&Record::altimeter_q>(Record::ALTIMETER_Q),
+    members<&Record::sea_level_press>(Record::SEA_LEVEL_PRESS),
+    members<&Record::temperature_na>(Record::TEMPERATURE_NA),
+    members<&Record::dew_point_na>(Record::DEW_POINT_NA),
+    members<&Record::flags>(RecordDiff::FLAGS),
+    array<&Record::num_layers, &Record::layers>(RecordDiff::LAYERS),
+    array<&Record::num_phenomena, &Record::phenomena>(RecordDiff::PHENOMENA)
+  };
+}
+
+uint32_t RecordDiff::Diff(const Record& previous, const Record& current)
+{
+  uint32_t changed = (previous.present ^ current.present) & ALL;
+  uint32_t both = previous.present & current.present;
+
+  for (const part& p : PARTS)
+  {
+    // the group bits have no presence bit, so compare them always
+    bool compare = (p.bit & (FLAGS | LAYERS | PHENOMENA)) || (both & p.bit);
+    if (compare && !p.equal(previous, current)) changed |= p.bit;
+  }
+
+  return changed;
+}
+
+void RecordDiff::Apply(Record& target, const Record& source, uint32_t changed)
+{
+  for (const part& p : PARTS)
+  {
+    if (changed & p.bit)
+    {
+      p.copy(target, source);
+      target.present = (target.present & ~p.bit) | (source.present & p.bit);
+    }
+  }
+}
+
+ChangeTracker::ChangeTracker(size_t max_stations)
+{
+  _last.reserve(max_stations);
+}
+
+bool ChangeTracker::Update(const Record& record, RecordDiff::Delta& delta)
+{
+  if (record.icao == 0) return false;
+
+  auto [it, inserted] = _last.try_emplace(record.icao);
+  Record& last = it->second;
+
+  if (inserted)
+  {
+    memset(&last, 0, sizeof(last));
+  }
+  else if (!LatestCache::Supersedes(record, last))
+  {
+    return false;
+  }
+
+  uint32_t changed = RecordDiff::Diff(last, record);
+  last = record;
+
+  if (changed == 0) return false;
+
+  delta.icao = record.icao;
+  delta.changed = changed;
+  delta.values = record;
+  return true;
+}
+
+const Record *ChangeTracker::Get(uint32_t icao) const
+{
+  auto it = _last.find(icao);
+  return it != _last.end() ? &it->second : nullptr;
+}
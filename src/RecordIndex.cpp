@@ -0,0 +1,212 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Station and time index of archived records
+//
+
+#include "RecordIndex.h"
+
+#include "MappedRecords.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  constexpr size_t HEADER_SIZE = 16;
+
+  // serialized entry: icao, time, position
+  constexpr size_t ENTRY_SIZE = 20;
+
+  // keys compare by station, then time
+  inline bool less(uint32_t a_icao, int64_t a_time,
+                   uint32_t b_icao, int64_t b_time)
+  {
+    return a_icao < b_icao || (a_icao == b_icao && a_time < b_time);
+  }
+
+  void put(std::vector<uint8_t>& out, uint64_t v, size_t bytes)
+  {
+    for (size_t i = 0 ; i < bytes ; i++)
+    {
+      out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+  }
+
+  uint64_t get(const uint8_t *p, size_t bytes)
+  {
+    uint64_t v = 0;
+    for (size_t i = 0 ; i < bytes ; i++)
+    {
+      v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return v;
+  }
+
+  constexpr uint32_t INDEXED = Record::ICAO | Record::OBSERVATION_TIME;
+}
+
+RecordIndex::RecordIndex(std::span<const Record> records)
+{
+  std::vector<Entry> entries;
+  for (size_t i = 0 ; i < records.size() ; i++)
+  {
+    const Record& r = records[i];
+    if ((r.present & INDEXED) == INDEXED)
+    {
+      entries.push_back({ r.icao, r.obs_time, i });
+    }
+  }
+  build(entries);
+}
+
+RecordIndex::RecordIndex(const MappedRecords& records)
+{
+  auto icao = records.ICAO();
+  auto time = records.ObservationTime();
+  auto present = records.Present();
+
+  std::vector<Entry> entries;
+  for (size_t i = 0 ; i < records.Size() ; i++)
+  {
+    if ((present[i] & INDEXED) == INDEXED)
+    {
+      entries.push_back({ icao[i], time[i], i });
+    }
+  }
+  build(entries);
+}
+
+void RecordIndex::build(std::vector<Entry>& entries)
+{
+  // stable, so duplicate keys keep their file order
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const Entry& a, const Entry& b) {
+                     return less(a.icao, a.time, b.icao, b.time);
+                   });
+
+  _icao.reserve(entries.size());
+  _time.reserve(entries.size());
+  _position.reserve(entries.size());
+
+  for (size_t i = 0 ; i < entries.size() ; i++)
+  {
+    if (i % BLOCK_SIZE == 0)
+    {
+      _fence_icao.push_back(entries[i].icao);
+      _fence_time.push_back(entries[i].time);
+    }
+    _icao.push_back(entries[i].icao);
+    _time.push_back(entries[i].time);
+    _position.push_back(entries[i].position);
+  }
+}
+
+// index of the first entry not less than the key
+size_t RecordIndex::lower_bound(uint32_t icao, int64_t time) const
+{
+  // the last block whose first key is less than the key holds the bound,
+  // unless the bound is the first entry of the following block
+  size_t lo = 0, hi = _fence_icao.size();
+  while (lo < hi)
+  {
+    size_t mid = (lo + hi) / 2;
+    if (less(_fence_icao[mid], _fence_time[mid], icao, time)) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo == 0) return 0;
+
+  size_t first = (lo - 1) * BLOCK_SIZE;
+  size_t last = std::min(first + BLOCK_SIZE, _icao.size());
+  while (first < last)
+  {
+    size_t mid = (first + last) / 2;
+    if (less(_icao[mid], _time[mid], icao, time)) first = mid + 1;
+    else last = mid;
+  }
+  return first;
+}
+
+void RecordIndex::Find(uint32_t icao, int64_t from, int64_t to,
+                       std::vector<uint64_t>& positions) const
+{
+  for (size_t i = lower_bound(icao, from) ;
+       i < _icao.size() && _icao[i] == icao && _time[i] <= to ; i++)
+  {
+    positions.push_back(_position[i]);
+  }
+}
+
+void RecordIndex::Find(int64_t from, int64_t to,
+                       std::vector<uint64_t>& positions) const
+{
+  size_t i = lower_bound(0, from);
+  while (i < _icao.size())
+  {
+    uint32_t icao = _icao[i];
+    if (_time[i] < from)
+    {
+      i = lower_bound(icao, from);
+      continue;
+    }
+
+    for ( ; i < _icao.size() && _icao[i] == icao && _time[i] <= to ; i++)
+    {
+      positions.push_back(_position[i]);
+    }
+
+    // skip to the next station
+    if (icao == std::numeric_limits<uint32_t>::max()) break;
+    i = lower_bound(icao + 1, std::numeric_limits<int64_t>::min());
+  }
+}
+
+// Layout: MAGIC, version (2 bytes), block size (2 bytes), entry count
+// (8 bytes), then the entries in key order, little-endian.
+bool RecordIndex::Write(std::ostream& os) const
+{
+  std::vector<uint8_t> buf(MAGIC, MAGIC + sizeof(MAGIC));
+  put(buf, VERSION, 2);
+  put(buf, BLOCK_SIZE, 2);
+  put(buf, _icao.size(), 8);
+
+  for (size_t i = 0 ; i < _icao.size() ; i++)
+  {
+    put(buf, _icao[i], 4);
+    put(buf, static_cast<uint64_t>(_time[i]), 8);
+    put(buf, _position[i], 8);
+  }
+
+  os.write(reinterpret_cast<const char *>(buf.data()), buf.size());
+  return static_cast<bool>(os);
+}
+
+std::shared_ptr<RecordIndex> RecordIndex::Create(std::istream& is)
+{
+  uint8_t header[HEADER_SIZE];
+  if (!is.read(reinterpret_cast<char *>(header), sizeof(header))
+      || memcmp(header, MAGIC, sizeof(MAGIC)) != 0
+      || get(header + 4, 2) != VERSION)
+    return nullptr;
+
+  uint64_t count = get(header + 8, 8);
+
+  std::vector<Entry> entries;
+  uint8_t entry[ENTRY_SIZE];
+  for (uint64_t i = 0 ; i < count ; i++)
+  {
+    if (!is.read(reinterpret_cast<char *>(entry), sizeof(entry)))
+      return nullptr;
+
+    entries.push_back({ static_cast<uint32_t>(get(entry, 4)),
+                        static_cast<int64_t>(get(entry + 4, 8)),
+                        get(entry + 12, 8) });
+  }
+
+  std::shared_ptr<RecordIndex> index(new RecordIndex());
+  index->build(entries);
+  return index;
+}
@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Sequence lock helpers for Record storage (library internal)
+//
+
+#pragma once
+
+#include "Record.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    namespace SeqLock
+    {
+      constexpr size_t WORDS = sizeof(Record) / sizeof(uint64_t);
+
+      static_assert(sizeof(Record) % sizeof(uint64_t) == 0);
+
+      // Records are moved through relaxed atomic words so that a read racing
+      // with a write is well defined; the sequence check discards such reads.
+      inline void store(std::atomic<uint64_t> *dst, const Record& r)
+      {
+        uint64_t words[WORDS];
+        memcpy(words, &r, sizeof(r));
+        for (size_t i = 0 ; i < WORDS ; i++)
+        {
+          dst[i].store(words[i], std::memory_order_relaxed);
+        }
+      }
+
+      inline void load(const std::atomic<uint64_t> *src, Record& r)
+      {
+        uint64_t words[WORDS];
+        for (size_t i = 0 ; i < WORDS ; i++)
+        {
+          words[i] = src[i].load(std::memory_order_relaxed);
+        }
+        memcpy(&r, words, sizeof(r));
+      }
+
+      // Writer side: marks the protected data as being modified.
+      inline uint64_t begin_write(std::atomic<uint64_t>& seq)
+      {
+        uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return s;
+      }
+
+      inline void end_write(std::atomic<uint64_t>& seq, uint64_t s)
+      {
+        seq.store(s + 2, std::memory_order_release);
+      }
+
+      // Reader side: read(f) runs f until it observes no concurrent write.
+      template<typename F>
+      inline void read(const std::atomic<uint64_t>& seq, F f)
+      {
+        for (;;)
+        {
+          uint64_t s = seq.load(std::memory_order_acquire);
+          if (s & 1) continue;
+
+          f();
+
+          std::atomic_thread_fence(std::memory_order_acquire);
+          if (seq.load(std::memory_order_relaxed) == s) return;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,226 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Portable SIMD helpers for the batch kernels (library internal)
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    namespace Simd
+    {
+      // GCC/Clang generic vector extensions. 128-bit vectors are native on
+      // both SSE2 and NEON, so no target specific flags are required.
+      constexpr size_t WIDTH = 2;
+
+      typedef double f64v __attribute__((vector_size(WIDTH * sizeof(double))));
+      typedef int64_t i64v __attribute__((vector_size(WIDTH * sizeof(int64_t))));
+      typedef uint64_t u64v __attribute__((vector_size(WIDTH * sizeof(uint64_t))));
+
+      inline f64v splat(double v)
+      {
+        return f64v{} + v;
+      }
+
+      inline f64v load(const double *p)
+      {
+        f64v v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+      }
+
+      inline void store(double *p, f64v v)
+      {
+        memcpy(p, &v, sizeof(v));
+      }
+
+      // partial load/store for the tail of a column, unused lanes are 'fill'
+      inline f64v load(const double *p, size_t n, double fill)
+      {
+        double tmp[WIDTH];
+        for (size_t i = 0 ; i < WIDTH ; i++) tmp[i] = i < n ? p[i] : fill;
+        return load(tmp);
+      }
+
+      inline void store(double *p, f64v v, size_t n)
+      {
+        double tmp[WIDTH];
+        store(tmp, v);
+        for (size_t i = 0 ; i < n ; i++) p[i] = tmp[i];
+      }
+
+      // converting loads of up to WIDTH integer column values, unused lanes
+      // are 'fill'
+      template<typename T>
+      inline f64v load(const T *p, size_t n, T fill)
+      {
+        f64v v;
+        for (size_t i = 0 ; i < WIDTH ; i++)
+        {
+          v[i] = static_cast<double>(i < n ? p[i] : fill);
+        }
+        return v;
+      }
+
+      // lane-wise mask ? a : b, where mask lanes are all ones or all zeros
+      inline f64v select(i64v mask, f64v a, f64v b)
+      {
+        return (f64v)((mask & (i64v)a) | (~mask & (i64v)b));
+      }
+
+      inline f64v min(f64v a, f64v b)
+      {
+        return select(a < b, a, b);
+      }
+
+      inline f64v max(f64v a, f64v b)
+      {
+        return select(a > b, a, b);
+      }
+
+      inline f64v abs(f64v a)
+      {
+        return (f64v)((i64v)a & INT64_MAX);
+      }
+
+      inline f64v sqrt(f64v a)
+      {
+        f64v r;
+        for (size_t i = 0 ; i < WIDTH ; i++) r[i] = __builtin_sqrt(a[i]);
+        return r;
+      }
+
+      constexpr double LN2_HI = 6.93147180369123816490e-01;
+      constexpr double LN2_LO = 1.90821492927058770002e-10;
+      constexpr double LOG2E = 1.44269504088896338700e+00;
+      constexpr double SQRT2 = 1.41421356237309504880e+00;
+
+      // adding 1.5 * 2^52 rounds to the nearest integer, which is then held
+      // in the low bits of the result
+      constexpr double ROUND_MAGIC = 6755399441055744.0;
+
+      // 2^52 + 1023, for reading a biased exponent back as a double
+      constexpr double EXP_MAGIC = 4503599627371519.0;
+
+      // exp(): x = n * ln2 + r, |r| <= ln2 / 2, with e^r from a degree 10
+      // Taylor polynomial (relative error < 1e-12).
+      inline f64v exp(f64v x)
+      {
+        x = max(min(x, splat(700.0)), splat(-700.0));
+
+        f64v k = x * LOG2E + ROUND_MAGIC;
+        f64v n = k - ROUND_MAGIC;
+        f64v r = (x - n * LN2_HI) - n * LN2_LO;
+
+        f64v p = splat(1.0 / 3628800.0);
+        p = p * r + 1.0 / 362880.0;
+        p = p * r + 1.0 / 40320.0;
+        p = p * r + 1.0 / 5040.0;
+        p = p * r + 1.0 / 720.0;
+        p = p * r + 1.0 / 120.0;
+        p = p * r + 1.0 / 24.0;
+        p = p * r + 1.0 / 6.0;
+        p = p * r + 0.5;
+        p = p * r + 1.0;
+        p = p * r + 1.0;
+
+        u64v bits = ((u64v)k + 1023) << 52;
+        return p * (f64v)bits;
+      }
+
+      // log() for positive normal x: x = m * 2^e with m in
+      // [sqrt(2)/2, sqrt(2)), log(m) = 2 atanh((m - 1) / (m + 1)) from its
+      // odd series (relative error < 1e-13).
+      inline f64v log(f64v x)
+      {
+        u64v bits = (u64v)x;
+        f64v e = (f64v)(0x4330000000000000ULL | (bits >> 52)) - EXP_MAGIC;
+        f64v m = (f64v)((bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL);
+
+        i64v adjust = m > SQRT2;
+        m = select(adjust, m * 0.5, m);
+        e = select(adjust, e + 1.0, e);
+
+        f64v s = (m - 1.0) / (m + 1.0);
+        f64v s2 = s * s;
+
+        f64v p = splat(1.0 / 15.0);
+        p = p * s2 + 1.0 / 13.0;
+        p = p * s2 + 1.0 / 11.0;
+        p = p * s2 + 1.0 / 9.0;
+        p = p * s2 + 1.0 / 7.0;
+        p = p * s2 + 1.0 / 5.0;
+        p = p * s2 + 1.0 / 3.0;
+        p = p * s2 + 1.0;
+
+        return 2.0 * s * p + e * LN2_HI + e * LN2_LO;
+      }
+
+      // largest integer not greater than x, for |x| < 2^51
+      inline f64v floor(f64v x)
+      {
+        f64v r = (x + ROUND_MAGIC) - ROUND_MAGIC;
+        return select(r > x, r - 1.0, r);
+      }
+
+      // sin(x): reduced to [-pi/2, pi/2] and evaluated with a degree 15
+      // Taylor polynomial (absolute error < 1e-11).
+      inline f64v sin(f64v x)
+      {
+        constexpr double PI = 3.14159265358979323846;
+        x = x - (2.0 * PI) * floor(x / (2.0 * PI) + 0.5);
+
+        x = select(x > PI / 2.0, PI - x, x);
+        x = select(x < -PI / 2.0, -PI - x, x);
+
+        f64v x2 = x * x;
+        f64v p = splat(-1.0 / 1307674368000.0);
+        p = p * x2 + 1.0 / 6227020800.0;
+        p = p * x2 - 1.0 / 39916800.0;
+        p = p * x2 + 1.0 / 362880.0;
+        p = p * x2 - 1.0 / 5040.0;
+        p = p * x2 + 1.0 / 120.0;
+        p = p * x2 - 1.0 / 6.0;
+        p = p * x2 + 1.0;
+
+        return x * p;
+      }
+
+      inline f64v cos(f64v x)
+      {
+        return sin(x + 1.57079632679489661923);
+      }
+
+      // x^y for positive x
+      inline f64v pow(f64v x, f64v y)
+      {
+        return exp(y * log(x));
+      }
+
+      // Applies a kernel to whole vectors of two input columns and a final
+      // padded vector for the tail.
+      template<typename F>
+      inline void transform(const double *a, const double *b, double *out,
+                            size_t n, double fill, F f)
+      {
+        size_t i = 0;
+        for ( ; i + WIDTH <= n ; i += WIDTH)
+        {
+          store(out + i, f(load(a + i), load(b + i)));
+        }
+        if (i < n)
+        {
+          store(out + i, f(load(a + i, n - i, fill), load(b + i, n - i, fill)),
+                n - i);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Per-station observation history
+//
+
+#include "StationHistory.h"
+
+#include "SeqLock.h"
+
+#include <bit>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  constexpr size_t WORDS = SeqLock::WORDS;
+
+  inline size_t hash(uint32_t icao)
+  {
+    return (static_cast<uint64_t>(icao) * 0x9E3779B97F4A7C15ULL) >> 32;
+  }
+}
+
+StationHistory::StationHistory(size_t max_stations, size_t capacity)
+  : _capacity(capacity > 0 ? capacity : 1)
+  , _max_stations(max_stations)
+  , _table(std::bit_ceil(max_stations * 2 + 1))
+{
+}
+
+const StationHistory::Station *StationHistory::find(uint32_t icao) const
+{
+  const size_t mask = _table.size() - 1;
+  for (size_t i = hash(icao) & mask ; ; i = (i + 1) & mask)
+  {
+    uint32_t key = _table[i].icao.load(std::memory_order_acquire);
+    if (key == icao) return &_table[i];
+    if (key == 0) return nullptr;
+  }
+}
+
+StationHistory::Station *StationHistory::insert(uint32_t icao)
+{
+  const size_t mask = _table.size() - 1;
+  for (size_t i = hash(icao) & mask ; ; i = (i + 1) & mask)
+  {
+    Station& s = _table[i];
+    uint32_t key = s.icao.load(std::memory_order_relaxed);
+    if (key == icao) return &s;
+    if (key == 0)
+    {
+      if (_num_stations.load(std::memory_order_relaxed) >= _max_stations)
+        return nullptr;
+
+      s.ring = std::make_unique<std::atomic<uint64_t>[]>(_capacity * WORDS);
+      // publishing the key makes the ring visible to readers
+      s.icao.store(icao, std::memory_order_release);
+      _num_stations.fetch_add(1, std::memory_order_relaxed);
+      return &s;
+    }
+  }
+}
+
+bool StationHistory::Append(const Record& record)
+{
+  if (record.icao == 0) return false;
+
+  Station *s = insert(record.icao);
+  if (!s) return false;
+
+  uint64_t count = s->count.load(std::memory_order_relaxed);
+
+  uint64_t seq = SeqLock::begin_write(s->seq);
+  SeqLock::store(&s->ring[(count % _capacity) * WORDS], record);
+  s->count.store(count + 1, std::memory_order_relaxed);
+  SeqLock::end_write(s->seq, seq);
+
+  return true;
+}
+
+size_t StationHistory::Snapshot(uint32_t icao, std::vector<Record>& out) const
+{
+  out.clear();
+
+  const Station *s = find(icao);
+  if (!s) return 0;
+
+  SeqLock::read(s->seq, [&]
+  {
+    uint64_t count = s->count.load(std::memory_order_relaxed);
+    size_t n = count < _capacity ? count : _capacity;
+    out.resize(n);
+
+    for (size_t i = 0 ; i < n ; i++)
+    {
+      SeqLock::load(&s->ring[((count - n + i) % _capacity) * WORDS], out[i]);
+    }
+  });
+
+  return out.size();
+}
+
+std::optional<Record> StationHistory::Latest(uint32_t icao) const
+{
+  const Station *s = find(icao);
+  if (!s) return {};
+
+  std::optional<Record> r;
+  SeqLock::read(s->seq, [&]
+  {
+    r.reset();
+
+    uint64_t count = s->count.load(std::memory_order_relaxed);
+    if (count == 0) return;
+
+    Record tmp;
+    SeqLock::load(&s->ring[((count - 1) % _capacity) * WORDS], tmp);
+    r = tmp;
+  });
+
+  return r;
+}
@@ -6,17 +6,63 @@
 #include "Utils.h"
 
 #include <cmath>
+#include <vector>
 
 #include <Convert.h>
 
+#include "Simd.h"
+
 using namespace Storage_B::Weather;
 
+namespace
+{
+  // whole degree range of the humidity table, in Celsius
+  constexpr int HUMIDITY_MIN = -70;
+  constexpr int HUMIDITY_MAX = 60;
+  constexpr int HUMIDITY_SPAN = HUMIDITY_MAX - HUMIDITY_MIN + 1;
+
+  const std::vector<double>& humidity_table()
+  {
+    static const std::vector<double> table = []
+    {
+      std::vector<double> v(HUMIDITY_SPAN * HUMIDITY_SPAN);
+      for (int t = HUMIDITY_MIN ; t <= HUMIDITY_MAX ; t++)
+      {
+        for (int td = HUMIDITY_MIN ; td <= HUMIDITY_MAX ; td++)
+        {
+          v[(t - HUMIDITY_MIN) * HUMIDITY_SPAN + (td - HUMIDITY_MIN)] =
+            Utils::Humidity(t, td);
+        }
+      }
+      return v;
+    }();
+
+    return table;
+  }
+}
+
 double Utils::Humidity(double t, double td)
 {
   return (100.0 * exp((17.625 * td) / (243.04 + td)) / 
                           exp((17.625 * t) / (243.04 + t)));
 }
 
+double Utils::HumidityTenths(int t, int td)
+{
+  if ((t % 10 == 0) && (td % 10 == 0))
+  {
+    int ti = t / 10 - HUMIDITY_MIN;
+    int tdi = td / 10 - HUMIDITY_MIN;
+
+    if (ti >= 0 && ti < HUMIDITY_SPAN && tdi >= 0 && tdi < HUMIDITY_SPAN)
+    {
+      return humidity_table()[ti * HUMIDITY_SPAN + tdi];
+    }
+  }
+
+  return Humidity(t / 10.0, td / 10.0);
+}
+
 double Utils::WindChill(double temp, double wind_speed)
 {
   double twc(temp);
@@ -66,3 +112,71 @@ double Utils::HeatIndex(double temp, double humidity, bool celsius_flg)
 
   return temp;
 }
+
+void Utils::Humidity(std::span<const double> t,
+                     std::span<const double> td,
+                     std::span<double> out)
+{
+  Simd::transform(t.data(), td.data(), out.data(), t.size(), 0.0,
+    [](Simd::f64v t, Simd::f64v td)
+    {
+      // the quotient of the two exponentials is a single exponential
+      return 100.0 * Simd::exp((17.625 * td) / (243.04 + td)
+                             - (17.625 * t) / (243.04 + t));
+    });
+}
+
+void Utils::WindChill(std::span<const double> temp,
+                      std::span<const double> wind_speed,
+                      std::span<double> out)
+{
+  Simd::transform(temp.data(), wind_speed.data(), out.data(), temp.size(), 0.0,
+    [](Simd::f64v t, Simd::f64v w)
+    {
+      Simd::i64v apply = (w > 4.8) & (t <= 10.0);
+      Simd::f64v v16 = Simd::pow(Simd::select(apply, w, Simd::splat(1.0)),
+                                 Simd::splat(0.16));
+      Simd::f64v twc = 13.12 + (0.6215 * t) - (11.37 * v16)
+                                            + (0.3965 * t * v16);
+      return Simd::select(apply, twc, t);
+    });
+}
+
+void Utils::HeatIndex(std::span<const double> temp,
+                      std::span<const double> humidity,
+                      std::span<double> out,
+                      bool celsius_flg)
+{
+  auto kernel = [celsius_flg](Simd::f64v temp, Simd::f64v h)
+  {
+    Simd::f64v t = celsius_flg ? (temp * 1.8) + 32.0 : temp;
+
+    Simd::f64v root = (17.0 - Simd::abs(t - 95.0)) / 17.0;
+    Simd::f64v adj_low = -(((13.0 - h) / 4.0)
+                * Simd::sqrt(Simd::max(root, Simd::splat(0.0))));
+    Simd::f64v adj_high = ((h - 85.0) / 10.0) * ((87.0 - t) / 5.0);
+
+    Simd::i64v is_low = (h < 13.0) & (t > 80.0) & (t < 112.0);
+    Simd::i64v is_high = (h > 85.0) & (t >= 80.0) & (t < 87.0);
+    Simd::f64v adj = Simd::select(is_low, adj_low,
+                       Simd::select(is_high, adj_high, Simd::splat(0.0)));
+
+    Simd::f64v thi = -42.379
+      + 2.04901523 * t 
+      + 10.14333127 * h 
+      - 0.22475541 * t * h 
+      - 0.00683783 * t * t 
+      - 0.05481717 * h * h 
+      + 0.00122874 * t * t * h 
+      + 0.00085282 * t * h * h 
+      - 0.00000199 * t * t * h * h;
+
+    thi += adj;
+    thi = celsius_flg ? (thi - 32.0) / 1.8 : thi;
+
+    return Simd::select(t >= 80.0, thi, temp);
+  };
+
+  Simd::transform(temp.data(), humidity.data(), out.data(), temp.size(), 0.0,
+                  kernel);
+}
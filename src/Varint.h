@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Variable length integer helpers for the binary formats (library internal)
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Storage_B
+{
+  namespace Weather
+  {
+    namespace Varint
+    {
+      // maps signed values of small magnitude to small unsigned values
+      inline uint64_t zigzag(int64_t v)
+      {
+        return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+      }
+
+      inline int64_t unzigzag(uint64_t v)
+      {
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+      }
+
+      // seven bits per byte, least significant first, high bit set on all
+      // but the last byte
+      inline void put(std::vector<uint8_t>& out, uint64_t v)
+      {
+        while (v >= 0x80)
+        {
+          out.push_back(static_cast<uint8_t>(v | 0x80));
+          v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+      }
+
+      // reads a value from [p, end), advancing p; false if truncated or
+      // longer than 64 bits
+      inline bool get(const uint8_t *& p, const uint8_t *end, uint64_t& v)
+      {
+        v = 0;
+        for (unsigned int shift = 0 ; shift < 64 ; shift += 7)
+        {
+          if (p >= end) break;
+          uint8_t b = *p++;
+          v |= static_cast<uint64_t>(b & 0x7F) << shift;
+          if (!(b & 0x80)) return true;
+        }
+        v = 0;
+        return false;
+      }
+    }
+  }
+}
@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2020 James A. Chappell (rlrrlrll@gmail.com)
+//
+// Sliding time window statistics of station reports
+//
+
+#include "WindowStats.h"
+
+#include "Convert.h"
+#include "Metar.h"
+
+#include <cmath>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  // gust in tenths of knots
+  std::optional<int64_t> gust(const Record& r)
+  {
+    if (!r.Has(Record::WIND_GUST) || !r.Has(Record::WIND_UNITS)) return {};
+
+    double v = r.wind_gust;
+    switch (static_cast<Metar::speed_units>(r.wind_units))
+    {
+      case Metar::speed_units::KT:
+        break;
+      case Metar::speed_units::MPS:
+        v /= Convert::Kts2Mps(1.0);
+        break;
+      case Metar::speed_units::KPH:
+        v /= Convert::Kts2Kph(1.0);
+        break;
+      default:
+        return {};
+    }
+    return std::llround(v * 10.0);
+  }
+
+  // temperature in tenths of a degree
+  std::optional<int64_t> temperature(const Record& r)
+  {
+    if (r.Has(Record::TEMPERATURE_NA)) return r.temperature_na;
+    if (r.Has(Record::TEMPERATURE))
+      return static_cast<int64_t>(r.temperature) * 10;
+    return {};
+  }
+}
+
+SlidingWindow::SlidingWindow(int64_t length)
+  : _length(length)
+{
+}
+
+void SlidingWindow::Add(int64_t t, int64_t v)
+{
+  Advance(t);
+
+  _samples.push_back({ t, v });
+  _sum += v;
+
+  // a sample can never again be the minimum (maximum) once a later sample
+  // is not greater (less)
+  while (!_min.empty() && _min.back().v >= v) _min.pop_back();
+  _min.push_back({ t, v });
+
+  while (!_max.empty() && _max.back().v <= v) _max.pop_back();
+  _max.push_back({ t, v });
+}
+
+void SlidingWindow::Clear()
+{
+  _sum = 0;
+  _samples.clear();
+  _min.clear();
+  _max.clear();
+}
+
+void SlidingWindow::Advance(int64_t now)
+{
+  const int64_t oldest = now - _length;
+
+  while (!_samples.empty() && _samples.front().t < oldest)
+  {
+    _sum -= _samples.front().v;
+    _samples.pop_front();
+  }
+  while (!_min.empty() && _min.front().t < oldest) _min.pop_front();
+  while (!_max.empty() && _max.front().t < oldest) _max.pop_front();
+}
+
+// pressure in tenths of hPa from one source
+std::optional<int64_t> StationWindows::pressure(const Record& r,
+                                                PressureSource source)
+{
+  switch (source)
+  {
+    case PressureSource::ALTIMETER_Q:
+      if (!r.Has(Record::ALTIMETER_Q)) return {};
+      return static_cast<int64_t>(r.altimeter_q) * 10;
+    case PressureSource::ALTIMETER_A:
+      if (!r.Has(Record::ALTIMETER_A)) return {};
+      return std::llround(Convert::inHg2Mb(r.altimeter_a / 100.0) * 10.0);
+    case PressureSource::SEA_LEVEL_PRESS:
+      if (!r.Has(Record::SEA_LEVEL_PRESS)) return {};
+      return r.sea_level_press;
+    case PressureSource::NONE:
+      break;
+  }
+  return {};
+}
+
+bool StationWindows::Update(const Record& r)
+{
+  if (!r.Has(Record::ICAO) || !r.Has(Record::OBSERVATION_TIME)) return false;
+
+  const int64_t t = r.obs_time;
+
+  auto [it, inserted] = _stations.try_emplace(r.icao);
+  Windows& w = it->second;
+  if (!inserted && t <= w.last) return false;
+  w.last = t;
+
+  // keep to the source of the samples in the window; an altimeter setting
+  // and the sea-level pressure differ by the station's elevation
+  auto p = pressure(r, w.pressure_source);
+  if (!p)
+  {
+    for (auto source : { PressureSource::ALTIMETER_Q,
+                         PressureSource::ALTIMETER_A,
+                         PressureSource::SEA_LEVEL_PRESS })
+    {
+      if ((p = pressure(r, source)))
+      {
+        w.pressure.Clear();
+        w.pressure_source = source;
+        break;
+      }
+    }
+  }
+
+  if (p) w.pressure.Add(t, *p);
+  else w.pressure.Advance(t);
+
+  if (auto v = gust(r)) w.gust.Add(t, *v);
+  else w.gust.Advance(t);
+
+  if (auto v = temperature(r)) w.temperature.Add(t, *v);
+  else w.temperature.Advance(t);
+
+  return true;
+}
+
+std::optional<StationWindows::Stats> StationWindows::Get(uint32_t icao) const
+{
+  auto it = _stations.find(icao);
+  if (it == _stations.end()) return {};
+
+  const Windows& w = it->second;
+  Stats s;
+
+  // as of the station's last report
+  if (w.pressure.Count() >= 2
+   && w.pressure.LastTime() - w.pressure.FirstTime() >= PRESSURE_MIN_SPAN)
+  {
+    s.pressure_tendency = (w.pressure.Last() - w.pressure.First()) / 10.0;
+  }
+
+  if (w.gust.Count() > 0) s.max_gust = w.gust.Max() / 10.0;
+
+  if (w.temperature.Count() > 0)
+  {
+    s.min_temperature = w.temperature.Min() / 10.0;
+    s.max_temperature = w.temperature.Max() / 10.0;
+    s.mean_temperature = w.temperature.Mean() / 10.0;
+  }
+
+  return s;
+}
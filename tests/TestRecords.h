@@ -0,0 +1,26 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Records of reports shared by the tests
+//
+
+#pragma once
+
+#include "Metar.h"
+#include "Record.h"
+
+#include <ctime>
+
+namespace TestRecords
+{
+  // 2020-03-12 18:00:00 UTC
+  const std::time_t REFERENCE = 1584036000;
+
+  // the record of a report, with its observation time resolved against
+  // REFERENCE
+  inline Storage_B::Weather::Record decode(const char *report)
+  {
+    using namespace Storage_B::Weather;
+    return Record::Create(*Metar::Create(report, REFERENCE));
+  }
+}
@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Station and time bucket aggregation tests
+//
+
+#include "Aggregate.h"
+#include "Batch.h"
+#include "Metar.h"
+#include "Record.h"
+
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  // 2024-01-01T00:00:00Z
+  constexpr int64_t START = 1704067200;
+
+  Record make(const char *icao, int64_t t, int temp_tenths, int slp_tenths)
+  {
+    Record r;
+    memset(&r, 0, sizeof(r));
+    r.icao = Record::PackICAO(icao);
+    r.obs_time = t;
+    r.temperature_na = static_cast<int16_t>(temp_tenths);
+    r.sea_level_press = static_cast<int16_t>(slp_tenths);
+    r.present = Record::ICAO | Record::OBSERVATION_TIME
+              | Record::TEMPERATURE_NA;
+    if (slp_tenths) r.present |= Record::SEA_LEVEL_PRESS;
+    return r;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(AggregateTests)
+
+BOOST_AUTO_TEST_CASE(bucket_start)
+{
+  const int64_t t = START + 40 * 86400 + 5 * 3600 + 1234;  // 2024-02-10
+
+  BOOST_CHECK(Aggregate::BucketStart(t, Aggregate::bucket::HOUR)
+              == START + 40 * 86400 + 5 * 3600);
+  BOOST_CHECK(Aggregate::BucketStart(t, Aggregate::bucket::DAY)
+              == START + 40 * 86400);
+  BOOST_CHECK(Aggregate::BucketStart(t, Aggregate::bucket::MONTH)
+              == START + 31 * 86400);
+  BOOST_CHECK(Aggregate::BucketStart(-1, Aggregate::bucket::DAY) == -86400);
+}
+
+BOOST_AUTO_TEST_CASE(metar)
+{
+  Batch batch;
+  batch.Append(*Metar::Create("KSTL 091651Z 10010KT 10SM CLR 07/M06 A2998 RMK SLP160 T00671056", START));
+  batch.Append(*Metar::Create("KSTL 091751Z 10005MPS 10SM CLR 09/M06 Q1013", START));
+  batch.Append(*Metar::Create("KSTL 101651Z 10010KT 10SM CLR M01/M06 A2998", START));
+  batch.Append(*Metar::Create("KSTL 10010KT 10SM CLR 07/M06 A2998", START));
+
+  std::vector<Aggregate::Group> groups;
+  Aggregate::GroupBy(batch, Aggregate::bucket::DAY, groups);
+
+  BOOST_REQUIRE(groups.size() == 2);
+  const auto& g = groups[0];
+  BOOST_CHECK(g.icao == Record::PackICAO("KSTL"));
+  BOOST_CHECK(g.start == START + 8 * 86400);
+  BOOST_CHECK(g.reports == 2);
+
+  const auto& temp = g[Aggregate::field::TEMPERATURE];
+  BOOST_CHECK(temp.count == 2);
+  BOOST_CHECK_CLOSE(temp.min, 6.7, 1e-9);
+  BOOST_CHECK_CLOSE(temp.max, 9.0, 1e-9);
+  BOOST_CHECK_CLOSE(temp.Mean(), 7.85, 1e-9);
+
+  BOOST_CHECK_CLOSE(g[Aggregate::field::WIND_SPEED].min, 5 / 0.514444, 1e-6);
+  BOOST_CHECK(g[Aggregate::field::WIND_SPEED].max == 10);
+  BOOST_CHECK_CLOSE(g[Aggregate::field::ALTIMETER].max, 1015.2, 0.01);
+  BOOST_CHECK(g[Aggregate::field::SEA_LEVEL_PRESSURE].count == 1);
+
+  BOOST_CHECK(groups[1][Aggregate::field::SEA_LEVEL_PRESSURE].count == 0);
+  BOOST_CHECK(std::isnan(groups[1][Aggregate::field::SEA_LEVEL_PRESSURE].Mean()));
+}
+
+BOOST_AUTO_TEST_CASE(threads)
+{
+  const char *stations[] = { "KSTL", "KJFK", "EGLL", "LFPG", "RJTT",
+                             "KORD", "KDEN", "KSEA", "EDDF", "YSSY" };
+
+  // interleaved half-hourly reports over 200 days, enough for 4 threads
+  Batch batch;
+  std::map<std::pair<uint32_t, int64_t>, std::vector<double>> expected;
+  for (int64_t i = 0 ; i < 200 * 48 * 10 ; i++)
+  {
+    const char *icao = stations[i % 10];
+    int64_t t = START + (i / 10) * 1800;
+    int temp = static_cast<int>((i * 37) % 400) - 100;
+    batch.Append(make(icao, t, temp, (i % 3) ? 10130 : 0));
+
+    int64_t day = START + ((t - START) / 86400) * 86400;
+    expected[{ Record::PackICAO(icao), day }].push_back(temp / 10.0);
+  }
+
+  std::vector<Aggregate::Group> single, parallel;
+  Aggregate::GroupBy(batch, Aggregate::bucket::DAY, single, 1);
+  Aggregate::GroupBy(batch, Aggregate::bucket::DAY, parallel, 4);
+
+  BOOST_REQUIRE(single.size() == expected.size());
+  BOOST_REQUIRE(parallel.size() == expected.size());
+
+  size_t i = 0;
+  for (const auto& [key, temps] : expected)
+  {
+    const auto& a = single[i];
+    const auto& b = parallel[i];
+    i++;
+
+    BOOST_CHECK(a.icao == key.first && a.start == key.second);
+    BOOST_CHECK(b.icao == key.first && b.start == key.second);
+    BOOST_CHECK(a.reports == 48 && b.reports == 48);
+
+    double sum = 0, lo = 1e9, hi = -1e9;
+    for (double t : temps) { sum += t; lo = std::min(lo, t); hi = std::max(hi, t); }
+
+    for (const auto *g : { &a, &b })
+    {
+      const auto& s = (*g)[Aggregate::field::TEMPERATURE];
+      BOOST_CHECK(s.count == temps.size());
+      BOOST_CHECK(s.min == lo && s.max == hi);
+      BOOST_CHECK(std::abs(s.Mean() - sum / temps.size()) < 1e-9);
+      BOOST_CHECK((*g)[Aggregate::field::SEA_LEVEL_PRESSURE].count
+                  + (*g)[Aggregate::field::WIND_SPEED].count < 48);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
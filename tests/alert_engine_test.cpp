@@ -0,0 +1,267 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Alert rule engine tests
+//
+
+#include "AlertEngine.h"
+#include "TestRecords.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+using TestRecords::decode;
+
+namespace
+{
+  typedef AlertEngine::Condition Condition;
+}
+
+BOOST_AUTO_TEST_SUITE(AlertEngineTests)
+
+BOOST_AUTO_TEST_CASE(fire_and_clear)
+{
+  AlertEngine engine;
+  const uint32_t kbos = Record::PackICAO("KBOS");
+
+  uint32_t low = engine.Add({ kbos },
+    { Condition::Compare(Filter::field::CEILING, Filter::op::LT, 500) });
+  uint32_t storm = engine.Add({},
+    { Condition::Weather(Phenom::phenom::RAIN, Phenom::intensity::HEAVY,
+                         Record::Phenomenon::THUNDERSTORM) });
+  BOOST_CHECK(engine.NumRules() == 2);
+
+  std::vector<AlertEngine::Event> events;
+
+  engine.Evaluate(decode("METAR KBOS 121654Z 09012KT 2SM BR OVC008 08/07 "
+                         "A2990"), events);
+  BOOST_CHECK(events.empty());
+
+  engine.Evaluate(decode("METAR KBOS 121754Z 09014KT 1SM +TSRA OVC004CB "
+                         "08/07 A2985"), events);
+  BOOST_REQUIRE(events.size() == 2);
+  for (const auto& e : events)
+  {
+    BOOST_CHECK(e.icao == kbos);
+    BOOST_CHECK(e.active);
+  }
+  BOOST_CHECK(engine.Active(low, kbos));
+  BOOST_CHECK(engine.Active(storm, kbos));
+
+  // still matching: no events
+  events.clear();
+  engine.Evaluate(decode("METAR KBOS 121854Z 09014KT 1SM +TSRA OVC003CB "
+                         "08/07 A2984"), events);
+  BOOST_CHECK(events.empty());
+
+  // light rain does not match the storm rule
+  engine.Evaluate(decode("METAR KBOS 121954Z 09010KT 3SM -RA OVC004 "
+                         "08/07 A2986"), events);
+  BOOST_REQUIRE(events.size() == 1);
+  BOOST_CHECK(events[0].rule == storm);
+  BOOST_CHECK(!events[0].active);
+
+  // late reports are ignored
+  events.clear();
+  engine.Evaluate(decode("METAR KBOS 121754Z 09014KT 1SM +TSRA OVC004CB "
+                         "08/07 A2985"), events);
+  BOOST_CHECK(events.empty());
+
+  // the rule applies to KBOS only
+  engine.Evaluate(decode("METAR KJFK 121951Z 18010KT 1SM +TSRA OVC003CB "
+                         "12/11 A2990"), events);
+  BOOST_REQUIRE(events.size() == 1);
+  BOOST_CHECK(events[0].rule == storm);
+  BOOST_CHECK(events[0].icao == Record::PackICAO("KJFK"));
+}
+
+BOOST_AUTO_TEST_CASE(units_and_conjunction)
+{
+  AlertEngine engine;
+
+  // wind of 25 kt or more and below freezing
+  uint32_t rule = engine.Add({},
+    { Condition::Compare(Filter::field::WIND_SPEED, Filter::op::GE, 25),
+      Condition::Compare(Filter::field::TEMPERATURE, Filter::op::LT, 0) });
+
+  std::vector<AlertEngine::Event> events;
+  engine.Evaluate(decode("METAR EFHK 121650Z 27014MPS 9999 FEW020 M05/M09 "
+                         "Q1001"), events);
+  BOOST_REQUIRE(events.size() == 1);
+  BOOST_CHECK(events[0].rule == rule);
+
+  engine.Evaluate(decode("METAR EFHK 121720Z 27011MPS 9999 FEW020 M05/M09 "
+                         "Q1001"), events);
+  BOOST_REQUIRE(events.size() == 2);
+  BOOST_CHECK(!events[1].active);
+
+  // CAVOK counts as 10 km visibility
+  uint32_t vis = engine.Add({},
+    { Condition::Compare(Filter::field::VISIBILITY, Filter::op::GE, 6) });
+  events.clear();
+  engine.Evaluate(decode("METAR LFPG 121700Z 24008KT CAVOK 15/08 Q1015"),
+                  events);
+  BOOST_REQUIRE(events.size() == 1);
+  BOOST_CHECK(events[0].rule == vis);
+}
+
+BOOST_AUTO_TEST_CASE(indexing)
+{
+  AlertEngine engine;
+
+  // many rules on other stations and on fields that do not change
+  for (int i = 0 ; i < 500 ; i++)
+  {
+    char icao[5];
+    snprintf(icao, sizeof(icao), "K%c%c%c", 'A' + i % 26, 'A' + i / 26 % 26,
+             'Z');
+    engine.Add({ Record::PackICAO(icao) },
+      { Condition::Compare(Filter::field::CEILING, Filter::op::LT, 1000) });
+  }
+  for (int i = 0 ; i < 100 ; i++)
+  {
+    engine.Add({},
+      { Condition::Compare(Filter::field::SEA_LEVEL_PRESSURE, Filter::op::LT,
+                           980 + i) });
+  }
+  uint32_t temp = engine.Add({},
+    { Condition::Compare(Filter::field::TEMPERATURE, Filter::op::GE, 25) });
+
+  std::vector<AlertEngine::Event> events;
+  engine.Evaluate(decode("METAR KSTL 121651Z 31008KT 10SM FEW050 24/14 A3002 "
+                         "RMK SLP163"), events);
+  uint64_t first = engine.Evaluations();
+  BOOST_CHECK(first == 101);
+  BOOST_CHECK(events.size() == 63);
+  events.clear();
+
+  // only the temperature changed, so only its rule is evaluated
+  engine.Evaluate(decode("METAR KSTL 121751Z 31008KT 10SM FEW050 25/14 A3002 "
+                         "RMK SLP163"), events);
+  BOOST_CHECK(engine.Evaluations() - first == 1);
+  BOOST_REQUIRE(events.size() == 1);
+  BOOST_CHECK(events[0].rule == temp);
+
+  // a rule added later starts from the current state
+  uint32_t warm = engine.Add({},
+    { Condition::Compare(Filter::field::TEMPERATURE, Filter::op::GE, 20) });
+  BOOST_CHECK(engine.Active(warm, Record::PackICAO("KSTL")));
+
+  BOOST_CHECK(engine.Remove(temp));
+  BOOST_CHECK(!engine.Remove(temp));
+  BOOST_CHECK(!engine.Active(temp, Record::PackICAO("KSTL")));
+  BOOST_CHECK(engine.NumRules() == 601);
+
+  events.clear();
+  engine.Evaluate(decode("METAR KSTL 121851Z 31008KT 10SM FEW050 18/14 A3002 "
+                         "RMK SLP163"), events);
+  BOOST_REQUIRE(events.size() == 1);
+  BOOST_CHECK(events[0].rule == warm);
+  BOOST_CHECK(!events[0].active);
+}
+
+BOOST_AUTO_TEST_CASE(predicate)
+{
+  typedef AlertEngine::Predicate Predicate;
+
+  Record storm = decode("METAR KBOS 121754Z 09014G38KT 1SM +TSRA OVC004CB "
+                        "M01/M02 A2985");
+  Record fair = decode("METAR KBOS 121854Z 09008KT 10SM FEW250 12/02 A2995 "
+                       "RMK T01220017");
+  Record cavok = decode("METAR LFPG 121700Z 24008KT CAVOK 15/08 Q1015");
+
+  auto p = Predicate::Create("ceiling < 500");
+  BOOST_REQUIRE(p != nullptr);
+  BOOST_CHECK(p->Size() == 1);
+  BOOST_CHECK(p->Fields() == Record::CEILING);
+  BOOST_CHECK(p->Matches(storm));
+  BOOST_CHECK(!p->Matches(fair));
+
+  p = Predicate::Create("Ceiling < 500 OR (gust >= 35 and temperature < 0) "
+                        "or +TSRA");
+  BOOST_REQUIRE(p != nullptr);
+  BOOST_CHECK(p->Size() == 7);
+  BOOST_CHECK(p->Matches(storm));
+  BOOST_CHECK(!p->Matches(fair));
+
+  // tenths from the remarks are used when present
+  BOOST_CHECK(Predicate::Create("temperature > 12.1")->Matches(fair));
+  BOOST_CHECK(!Predicate::Create("temperature > 12.3")->Matches(fair));
+  BOOST_CHECK(Predicate::Create("dew_point == 1.7")->Matches(fair));
+
+  // weather groups
+  BOOST_CHECK(Predicate::Create("TSRA")->Matches(storm));
+  BOOST_CHECK(Predicate::Create("RA")->Matches(storm));
+  BOOST_CHECK(Predicate::Create("+RA")->Matches(storm));
+  BOOST_CHECK(!Predicate::Create("-RA")->Matches(storm));
+  BOOST_CHECK(Predicate::Create("-RA")->Matches(
+    decode("METAR KBOS 121854Z 09008KT 5SM -RA BR OVC010 08/06 A2990")));
+  BOOST_CHECK(!Predicate::Create("FZRA")->Matches(storm));
+  BOOST_CHECK(!Predicate::Create("+SN")->Matches(storm));
+  BOOST_CHECK(Predicate::Create("not SN")->Matches(storm));
+
+  // units and flags
+  BOOST_CHECK(Predicate::Create("visibility >= 6")->Matches(cavok));
+  BOOST_CHECK(Predicate::Create("visibility < 2")->Matches(storm));
+  BOOST_CHECK(Predicate::Create("category == LIFR")->Matches(storm));
+  BOOST_CHECK(Predicate::Create("category != VFR && wind > 10")
+              ->Matches(storm));
+  BOOST_CHECK(Predicate::Create("!(slp > 0)")->Matches(storm));
+
+  // missing values never match
+  BOOST_CHECK(!Predicate::Create("slp > 0")->Matches(storm));
+  BOOST_CHECK(!Predicate::Create("slp <= 0")->Matches(storm));
+
+  const char *invalid[] = {
+    "", "ceiling", "ceiling <", "ceiling < x", "ceiling < 500 and",
+    "(ceiling < 500", "ceiling < 500)", "XX", "ceiling < 500 RA",
+    "category == FOO", "ceiling < 500x", "XXRA", "RAandSN", "RAX", "+",
+    "TSRAXX", "ceiling < 500 or FZRAIN"
+  };
+  for (const char *expr : invalid)
+    BOOST_CHECK_MESSAGE(Predicate::Create(expr) == nullptr, expr);
+
+  std::string deep(40, '(');
+  deep += "RA" + std::string(40, ')');
+  BOOST_CHECK(Predicate::Create(deep.c_str()) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(predicate_rules)
+{
+  AlertEngine engine;
+
+  auto p = AlertEngine::Predicate::Create("ceiling < 500 or +TSRA");
+  BOOST_REQUIRE(p != nullptr);
+  uint32_t rule = engine.Add({ Record::PackICAO("KBOS") }, p);
+
+  std::vector<AlertEngine::Event> events;
+  engine.Evaluate(decode("METAR KBOS 121654Z 09012KT 2SM BR OVC008 08/07 "
+                         "A2990"), events);
+  BOOST_CHECK(events.empty());
+
+  engine.Evaluate(decode("METAR KBOS 121754Z 09014KT 1SM +TSRA OVC008CB "
+                         "08/07 A2985"), events);
+  BOOST_REQUIRE(events.size() == 1);
+  BOOST_CHECK(events[0].rule == rule);
+  BOOST_CHECK(events[0].active);
+
+  // still matching through the other branch
+  engine.Evaluate(decode("METAR KBOS 121854Z 09014KT 1SM BR OVC004 "
+                         "08/07 A2985"), events);
+  BOOST_CHECK(events.size() == 1);
+
+  // a temperature change does not evaluate the rule at all
+  uint64_t n = engine.Evaluations();
+  engine.Evaluate(decode("METAR KBOS 121954Z 09014KT 1SM BR OVC004 "
+                         "07/07 A2985"), events);
+  BOOST_CHECK(engine.Evaluations() == n);
+
+  BOOST_CHECK(engine.Remove(rule));
+  BOOST_CHECK(engine.NumRules() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
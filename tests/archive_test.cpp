@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Columnar archive tests
+//
+
+#include "Archive.h"
+#include "Metar.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  // hourly reports of a few stations with slowly changing weather, ordered
+  // by station and time
+  size_t make_reports(std::vector<Record>& records)
+  {
+    const char *stations[] = { "KSTL", "KJFK", "KORD", "KDEN", "KSEA" };
+    size_t text = 0;
+
+    for (int s = 0 ; s < 5 ; s++)
+    {
+      for (int hour = 0 ; hour < 24 * 28 ; hour++)
+      {
+        int t = 10 + (hour / 6 + s) % 8;
+        char buf[160];
+        snprintf(buf, sizeof(buf),
+                 "METAR %s %02d%02d51Z %03d%02dKT 10SM %s %02d/%02d A%04d "
+                 "RMK AO2 SLP%03d T0%02d00%02d0",
+                 stations[s], 1 + hour / 24, hour % 24,
+                 (hour % 4) * 10 + 180, 5 + hour % 3,
+                 hour % 5 ? "FEW035 BKN250" : "-RA OVC008",
+                 t, t - 4, 2990 + hour % 7, 100 + hour % 7,
+                 t, t - 4);
+        text += strlen(buf);
+        records.push_back(Record::Create(*Metar::Create(buf, 1704153600)));
+      }
+    }
+    return text;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(ArchiveTests)
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+  std::vector<Record> records;
+  size_t text = make_reports(records);
+
+  std::stringstream ss;
+  {
+    ArchiveWriter writer(ss, 1000);
+    for (const auto& r : records) BOOST_CHECK(writer.Append(r));
+    BOOST_CHECK(writer.Close());
+  }
+
+  // the archive is an order of magnitude smaller than the text
+  BOOST_CHECK(ss.str().size() * 10 < text);
+
+  auto reader = ArchiveReader::Create(ss);
+  BOOST_REQUIRE(reader);
+  BOOST_CHECK(reader->NumRowGroups() == 4);
+  BOOST_CHECK(reader->NumRows() == records.size());
+  BOOST_CHECK(reader->NumRows(3) == records.size() - 3000);
+
+  std::vector<Record> loaded;
+  for (size_t g = 0 ; g < reader->NumRowGroups() ; g++)
+  {
+    BOOST_CHECK(reader->ReadRecords(g, loaded));
+  }
+  BOOST_CHECK(loaded == records);
+}
+
+BOOST_AUTO_TEST_CASE(columns)
+{
+  std::vector<Record> records;
+  make_reports(records);
+
+  std::stringstream ss;
+  {
+    ArchiveWriter writer(ss);
+    for (const auto& r : records) writer.Append(r);
+  }
+
+  auto reader = ArchiveReader::Create(ss);
+  BOOST_REQUIRE(reader);
+  BOOST_REQUIRE(reader->NumRowGroups() == 1);
+
+  std::vector<int64_t> temp, obs_time;
+  BOOST_CHECK(reader->ReadColumn(0, Archive::column::TEMPERATURE_NA, temp));
+  BOOST_CHECK(reader->ReadColumn(0, Archive::column::OBSERVATION_TIME,
+                                 obs_time));
+  BOOST_REQUIRE(temp.size() == records.size());
+  for (size_t i = 0 ; i < records.size() ; i++)
+  {
+    BOOST_CHECK(temp[i] == records[i].temperature_na);
+    BOOST_CHECK(obs_time[i] == records[i].obs_time);
+  }
+
+  // only the two chunks were read
+  BOOST_CHECK(reader->BytesRead() * 3 < ss.str().size());
+
+  const auto& stats = reader->Statistics(0, Archive::column::TEMPERATURE_NA);
+  BOOST_CHECK(stats.min == 100 && stats.max == 170);
+  BOOST_CHECK(stats.count == records.size());
+
+  // absent values are excluded from the statistics
+  const auto& gust = reader->Statistics(0, Archive::column::WIND_GUST);
+  BOOST_CHECK(gust.count == 0);
+
+  BOOST_CHECK(reader->Encoding(0, Archive::column::ICAO)
+              == Archive::encoding::RLE);
+  BOOST_CHECK(reader->Encoding(0, Archive::column::WIND_DIRECTION)
+              == Archive::encoding::DICTIONARY);
+  BOOST_CHECK(reader->Encoding(0, Archive::column::MINUTE)
+              == Archive::encoding::BIT_PACKED);
+
+  std::vector<int64_t> cover;
+  size_t layers = 0;
+  for (const auto& r : records) layers += r.num_layers;
+  BOOST_CHECK(reader->ReadColumn(0, Archive::column::LAYER_COVER, cover));
+  BOOST_CHECK(cover.size() == layers);
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+  std::stringstream ss;
+  {
+    ArchiveWriter writer(ss);
+  }
+
+  auto reader = ArchiveReader::Create(ss);
+  BOOST_REQUIRE(reader);
+  BOOST_CHECK(reader->NumRowGroups() == 0);
+  BOOST_CHECK(reader->NumRows() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(corrupt)
+{
+  std::vector<Record> records;
+  make_reports(records);
+
+  std::stringstream ss;
+  {
+    ArchiveWriter writer(ss);
+    for (const auto& r : records) writer.Append(r);
+  }
+  std::string bytes = ss.str();
+
+  std::stringstream text("METAR KSTL 091651Z 10010KT 10SM CLR 07/M06 A2998");
+  BOOST_CHECK(!ArchiveReader::Create(text));
+
+  std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+  BOOST_CHECK(!ArchiveReader::Create(truncated));
+
+  // damaged column chunks are detected, not returned
+  for (size_t i = 8 ; i < 200 ; i++) bytes[i] = static_cast<char>(0xFF);
+  std::stringstream damaged(bytes);
+  auto reader = ArchiveReader::Create(damaged);
+  BOOST_REQUIRE(reader);
+  std::vector<Record> loaded;
+  BOOST_CHECK(!reader->ReadRecords(0, loaded));
+  BOOST_CHECK(loaded.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Columnar batch tests
+//
+
+#include "Batch.h"
+#include "Metar.h"
+#include "Phenom.h"
+#include "Record.h"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+BOOST_AUTO_TEST_SUITE(BatchTests)
+
+BOOST_AUTO_TEST_CASE(append)
+{
+  Batch batch;
+
+  batch.Append(*Metar::Create("KSTL 091651Z 10010G20KT 060V120 2 1/2SM BKN012 07/M06 A2998 RMK SLP160 T00671056"));
+  batch.Append(*Metar::Create("LBBG 041600Z 12012MPS CAVOK M04/M07 Q1020"));
+
+  BOOST_CHECK(batch.Size() == 2);
+
+  BOOST_CHECK(batch.WindDirection()[0] == 100);
+  BOOST_CHECK(batch.WindGust()[0] == 20);
+  BOOST_CHECK(batch.WindGust()[1] == Batch::NONE);
+  BOOST_CHECK(batch.WindSpeedUnits()[1] ==
+              static_cast<uint8_t>(Metar::speed_units::MPS));
+
+  BOOST_CHECK(batch.Visibility()[0] == 40);
+  BOOST_CHECK(batch.Visibility()[1] == Batch::CAVOK_VISIBILITY);
+
+  BOOST_CHECK(batch.Ceiling()[0] == 1200);
+  BOOST_CHECK(batch.Ceiling()[1] == Batch::NONE);
+
+  BOOST_CHECK(batch.Temperature()[0] == 67);
+  BOOST_CHECK(batch.Temperature()[1] == -40);
+  BOOST_CHECK(batch.DewPoint()[0] == -56);
+
+  BOOST_CHECK(batch.AltimeterA()[0] == 2998);
+  BOOST_CHECK(batch.AltimeterA()[1] == Batch::NONE);
+  BOOST_CHECK(batch.AltimeterQ()[1] == 1020);
+  BOOST_CHECK(batch.SeaLevelPressure()[0] == 10160);
+
+  BOOST_CHECK(batch.ObservationTime()[0] == Batch::NONE64);
+
+  BOOST_CHECK(batch.PresentWeather()[0] == 0);
+
+  batch.Append(*Metar::Create("KORD 091651Z 36010KT 1SM -FZRA BR OVC004 M01/M02 A3001"));
+  uint64_t rain = 1ULL << static_cast<int>(Phenom::phenom::RAIN);
+  uint64_t mist = 1ULL << static_cast<int>(Phenom::phenom::MIST);
+  BOOST_CHECK(batch.PresentWeather()[2]
+              == ((rain << Batch::FREEZING_WEATHER) | rain | mist));
+
+  batch.Clear();
+  BOOST_CHECK(batch.Size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(append_record)
+{
+  const char *reports[] =
+  {
+    "KSTL 091651Z 10010G20KT 060V120 2 1/2SM BKN012 07/M06 A2998 RMK SLP160 T00671056",
+    "LBBG 041600Z 12012MPS CAVOK M04/M07 Q1020",
+    "KORD 091651Z 36010KT 1SM -FZRA BR OVC004 M01/M02 A3001"
+  };
+
+  Batch a, b;
+  for (auto report : reports)
+  {
+    auto metar = Metar::Create(report, 1704153600);
+    a.Append(*metar);
+    b.Append(Record::Create(*metar));
+  }
+
+  BOOST_CHECK(b.Station()[0] == Record::PackICAO("KSTL"));
+  for (size_t i = 0 ; i < 3 ; i++)
+  {
+    BOOST_CHECK(a.Station()[i] == b.Station()[i]);
+    BOOST_CHECK(a.ObservationTime()[i] == b.ObservationTime()[i]);
+    BOOST_CHECK(a.WindSpeed()[i] == b.WindSpeed()[i]);
+    BOOST_CHECK(a.WindGust()[i] == b.WindGust()[i]);
+    BOOST_CHECK(a.MinWindDirection()[i] == b.MinWindDirection()[i]);
+    BOOST_CHECK(a.WindSpeedUnits()[i] == b.WindSpeedUnits()[i]);
+    BOOST_CHECK(a.Visibility()[i] == b.Visibility()[i]);
+    BOOST_CHECK(a.VisibilityUnits()[i] == b.VisibilityUnits()[i]);
+    BOOST_CHECK(a.Ceiling()[i] == b.Ceiling()[i]);
+    BOOST_CHECK(a.FlightCategory()[i] == b.FlightCategory()[i]);
+    BOOST_CHECK(a.Temperature()[i] == b.Temperature()[i]);
+    BOOST_CHECK(a.DewPoint()[i] == b.DewPoint()[i]);
+    BOOST_CHECK(a.AltimeterA()[i] == b.AltimeterA()[i]);
+    BOOST_CHECK(a.AltimeterQ()[i] == b.AltimeterQ()[i]);
+    BOOST_CHECK(a.SeaLevelPressure()[i] == b.SeaLevelPressure()[i]);
+    BOOST_CHECK(a.PresentWeather()[i] == b.PresentWeather()[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(flight_categories)
+{
+  const char *reports[] =
+  {
+    "KSTL 091651Z 10010KT 10SM FEW120 BKN250 07/M06 A2998",
+    "KSTL 091651Z 10010KT 4SM BKN040 07/M06 A2998",
+    "KSTL 091651Z 10010KT 10SM OVC008 07/M06 A2998",
+    "KSTL 091651Z 10010KT 1/2SM FG VV002 07/M06 A2998",
+    "LBBG 041600Z 12012MPS 1400 +SN BKN022 OVC050 M04/M07 Q1020",
+    "LBBG 041600Z 12012MPS CAVOK M04/M07 Q1020",
+    "KSTL 091651Z 10010KT 07/M06 A2998"
+  };
+
+  Batch batch;
+  for (auto r : reports)
+  {
+    batch.Append(*Metar::Create(r));
+  }
+
+  std::vector<uint8_t> out(batch.Size());
+  Batch::FlightCategories(batch.Ceiling(), batch.Visibility(),
+                          batch.VisibilityUnits(), out);
+
+  for (size_t i = 0 ; i < batch.Size() ; i++)
+  {
+    BOOST_CHECK(out[i] == batch.FlightCategory()[i]);
+  }
+
+  BOOST_CHECK(out[0] == static_cast<uint8_t>(Metar::flight_category::VFR));
+  BOOST_CHECK(out[1] == static_cast<uint8_t>(Metar::flight_category::MVFR));
+  BOOST_CHECK(out[2] == static_cast<uint8_t>(Metar::flight_category::IFR));
+  BOOST_CHECK(out[3] == static_cast<uint8_t>(Metar::flight_category::LIFR));
+  BOOST_CHECK(out[4] == static_cast<uint8_t>(Metar::flight_category::LIFR));
+  BOOST_CHECK(out[5] == static_cast<uint8_t>(Metar::flight_category::VFR));
+  BOOST_CHECK(out[6] == Batch::NONE8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,11 @@
 //
 
 #include "Convert.h"
+#include "Batch.h"
+#include "Metar.h"
+
+#include <cmath>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -26,4 +31,38 @@ BOOST_AUTO_TEST_CASE(to_celsius)
   BOOST_TEST(Convert::f2c(-40.0) == -40.0);
 }
 
+BOOST_AUTO_TEST_CASE(normalize_columns, * boost::unit_test::tolerance(1e-9))
+{
+  Batch batch;
+  batch.Append(*Metar::Create("KSTL 091651Z 10010KT 2 1/2SM A2998"));
+  batch.Append(*Metar::Create("LBBG 041600Z 12012MPS 1400 Q1020"));
+  batch.Append(*Metar::Create("UUEE 041600Z 12036KPH CAVOK"));
+  batch.Append(*Metar::Create("KSTL 091651Z VRB03KT 10SM A3012 Q1020"));
+  batch.Append(*Metar::Create("KSTL"));
+
+  std::vector<double> out(batch.Size());
+
+  Convert::SpeedsToKnots(batch.WindSpeed(), batch.WindSpeedUnits(), out);
+  BOOST_TEST(out[0] == 10.0);
+  BOOST_TEST(out[1] == 12.0 / Convert::Kts2Mps(1.0));
+  BOOST_TEST(out[2] == 36.0 / Convert::Kts2Kph(1.0));
+  BOOST_TEST(out[3] == 3.0);
+  BOOST_CHECK(std::isnan(out[4]));
+
+  Convert::VisibilitiesToMeters(batch.Visibility(), batch.VisibilityUnits(),
+                                out);
+  BOOST_TEST(out[0] == Convert::Miles2Km(2.5) * 1000.0);
+  BOOST_TEST(out[1] == 1400.0);
+  BOOST_TEST(out[2] == 10000.0);
+  BOOST_TEST(out[3] == Convert::Miles2Km(10.0) * 1000.0);
+  BOOST_CHECK(std::isnan(out[4]));
+
+  Convert::AltimetersToMb(batch.AltimeterA(), batch.AltimeterQ(), out);
+  BOOST_TEST(out[0] == Convert::inHg2Mb(29.98));
+  BOOST_TEST(out[1] == 1020.0);
+  BOOST_CHECK(std::isnan(out[2]));
+  BOOST_TEST(out[3] == 1020.0);
+  BOOST_CHECK(std::isnan(out[4]));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
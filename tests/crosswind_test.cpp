@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Runway wind component tests
+//
+
+#include "Crosswind.h"
+#include "Batch.h"
+#include "Metar.h"
+
+#include <cmath>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  const double DEG2RAD = M_PI / 180.0;
+
+  // brute force over every whole degree of the direction range
+  void worst_case(int heading, int from, int to, double speed,
+                  double& cross, double& head)
+  {
+    cross = 0.0;
+    head = speed;
+    int span = ((to - from) % 360 + 360) % 360;
+    for (int k = 0 ; k <= span ; k++)
+    {
+      double a = (from + k - heading) * DEG2RAD;
+      cross = std::fmax(cross, fabs(speed * sin(a)));
+      head = std::fmin(head, speed * cos(a));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(CrosswindTests)
+
+BOOST_AUTO_TEST_CASE(components, * boost::unit_test::tolerance(1e-6))
+{
+  Batch batch;
+  batch.Append(*Metar::Create("KSTL 091651Z 10010KT 10SM"));
+  batch.Append(*Metar::Create("KSTL 091651Z 30015G25KT 10SM"));
+  batch.Append(*Metar::Create("KSTL 091651Z 10010KT 060V120 10SM"));
+  batch.Append(*Metar::Create("KSTL 091651Z 35008KT 330V020 10SM"));
+  batch.Append(*Metar::Create("KSTL 091651Z VRB03KT 10SM"));
+  batch.Append(*Metar::Create("LBBG 041600Z 12012MPS 090V150 1400"));
+  batch.Append(*Metar::Create("KSTL 091651Z 10SM"));
+
+  const std::vector<int32_t> headings = { 120, 300, 60, 240, 360 };
+  const size_t n = batch.Size();
+
+  std::vector<double> cross(headings.size() * n);
+  std::vector<double> head(headings.size() * n);
+  Crosswind::Components(headings, batch, cross, head);
+
+  const double mps = 12.0 / 0.514444;
+
+  for (size_t r = 0 ; r < headings.size() ; r++)
+  {
+    double x, h;
+    const int hd = headings[r];
+
+    worst_case(hd, 100, 100, 10.0, x, h);
+    BOOST_TEST(cross[r * n + 0] == x);
+    BOOST_TEST(head[r * n + 0] == h);
+
+    worst_case(hd, 300, 300, 25.0, x, h);
+    BOOST_TEST(cross[r * n + 1] == x);
+    BOOST_TEST(head[r * n + 1] == h);
+
+    worst_case(hd, 60, 120, 10.0, x, h);
+    BOOST_TEST(cross[r * n + 2] == x);
+    BOOST_TEST(head[r * n + 2] == h);
+
+    worst_case(hd, 330, 20, 8.0, x, h);
+    BOOST_TEST(cross[r * n + 3] == x);
+    BOOST_TEST(head[r * n + 3] == h);
+
+    BOOST_TEST(cross[r * n + 4] == 3.0);
+    BOOST_TEST(head[r * n + 4] == -3.0);
+
+    worst_case(hd, 90, 150, mps, x, h);
+    BOOST_TEST(cross[r * n + 5] == x);
+    BOOST_TEST(head[r * n + 5] == h);
+
+    BOOST_CHECK(std::isnan(cross[r * n + 6]));
+    BOOST_CHECK(std::isnan(head[r * n + 6]));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
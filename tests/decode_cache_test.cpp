@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Decode cache tests
+//
+
+#include "DecodeCache.h"
+#include "Metar.h"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  const char *KSTL =
+    "METAR KSTL 121651Z 31008KT 10SM FEW050 SCT250 23/14 A3002 RMK AO2 "
+    "SLP163 T02330139";
+
+  const char *EGLL =
+    "METAR EGLL 121650Z 24012G22KT 9999 -RA BKN014 12/09 Q1008";
+
+  // 2020-03-12 18:00:00 UTC
+  const std::time_t REFERENCE = 1584036000;
+
+  std::string report(int i)
+  {
+    char buf[80];
+    snprintf(buf, sizeof(buf),
+             "METAR K%c%c%c 121651Z 31008KT 10SM %02d/10 A3002",
+             'A' + i % 26, 'A' + i / 26 % 26, 'A' + i / 676 % 26, i % 40);
+    return buf;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(DecodeCacheTests)
+
+BOOST_AUTO_TEST_CASE(hit)
+{
+  DecodeCache cache(64, 4);
+
+  Record a = cache.Decode(KSTL);
+  Record b = cache.Decode(KSTL);
+
+  BOOST_CHECK(a == Record::Create(*Metar::Create(KSTL)));
+  BOOST_CHECK(a == b);
+  BOOST_CHECK(cache.Size() == 1);
+
+  DecodeCache::Counters c = cache.Statistics();
+  BOOST_CHECK(c.hits == 1);
+  BOOST_CHECK(c.misses == 1);
+  BOOST_CHECK_CLOSE(c.HitRate(), 0.5, 1e-9);
+
+  BOOST_CHECK(cache.Decode(EGLL).Has(Record::ALTIMETER_Q));
+  BOOST_CHECK(cache.Size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(reference_time)
+{
+  DecodeCache cache(64, 4);
+
+  // the cached record must not keep the time resolved for another reference
+  Record plain = cache.Decode(KSTL);
+  BOOST_CHECK(!plain.Has(Record::OBSERVATION_TIME));
+
+  Record resolved = cache.Decode(KSTL, REFERENCE);
+  BOOST_CHECK(resolved ==
+              Record::Create(*Metar::Create(KSTL, REFERENCE)));
+  BOOST_CHECK(resolved.obs_time == 1584031860);
+
+  // a reference in the next month resolves to the 12th of that month
+  Record later = cache.Decode(KSTL, REFERENCE + 30 * 86400);
+  BOOST_CHECK(later.obs_time == 1584031860 + 31 * 86400);
+
+  BOOST_CHECK(cache.Statistics().hits == 2);
+  BOOST_CHECK(cache.Statistics().misses == 1);
+}
+
+BOOST_AUTO_TEST_CASE(eviction)
+{
+  DecodeCache cache(8, 1);
+
+  for (int i = 0 ; i < 8 ; i++) cache.Decode(report(i).c_str());
+  BOOST_CHECK(cache.Size() == 8);
+  BOOST_CHECK(cache.Statistics().evictions == 0);
+
+  // recently used reports survive the next evictions
+  cache.Decode(report(0).c_str());
+  cache.Decode(report(1).c_str());
+
+  for (int i = 8 ; i < 12 ; i++) cache.Decode(report(i).c_str());
+  BOOST_CHECK(cache.Size() == 8);
+  BOOST_CHECK(cache.Statistics().evictions == 4);
+
+  DecodeCache::Counters before = cache.Statistics();
+  cache.Decode(report(0).c_str());
+  cache.Decode(report(1).c_str());
+  cache.Decode(report(2).c_str());
+  DecodeCache::Counters after = cache.Statistics();
+  BOOST_CHECK(after.hits - before.hits == 2);
+  BOOST_CHECK(after.misses - before.misses == 1);
+
+  cache.Clear();
+  BOOST_CHECK(cache.Size() == 0);
+  BOOST_CHECK(cache.Statistics().hits == 0);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent)
+{
+  DecodeCache cache(256, 8);
+
+  std::vector<std::string> reports;
+  for (int i = 0 ; i < 100 ; i++) reports.push_back(report(i));
+
+  std::vector<Record> expected;
+  for (const auto& r : reports)
+    expected.push_back(Record::Create(*Metar::Create(r.c_str(), REFERENCE)));
+
+  std::vector<std::thread> threads;
+  std::vector<int> errors(4, 0);
+  for (int t = 0 ; t < 4 ; t++)
+  {
+    threads.emplace_back([&, t]() {
+      for (int n = 0 ; n < 20 ; n++)
+      {
+        for (size_t i = 0 ; i < reports.size() ; i++)
+        {
+          size_t j = (i * 7 + t) % reports.size();
+          if (!(cache.Decode(reports[j].c_str(), REFERENCE) == expected[j]))
+            errors[t]++;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  for (int e : errors) BOOST_CHECK(e == 0);
+
+  DecodeCache::Counters c = cache.Statistics();
+  BOOST_CHECK(c.hits + c.misses == 4 * 20 * reports.size());
+  BOOST_CHECK(c.misses >= reports.size());
+  BOOST_CHECK(c.evictions == 0);
+  BOOST_CHECK(c.HitRate() > 0.9);
+  BOOST_CHECK(cache.Size() == reports.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Streaming deduplication tests
+//
+
+#include "Deduplicator.h"
+#include "Metar.h"
+#include "TestRecords.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+using TestRecords::decode;
+
+namespace
+{
+  using result = Deduplicator::result;
+}
+
+BOOST_AUTO_TEST_SUITE(DeduplicatorTests)
+
+BOOST_AUTO_TEST_CASE(duplicates_and_corrections)
+{
+  Deduplicator dedup;
+
+  Record original = decode("METAR KSTL 121651Z 31008KT 10SM FEW050 23/14 A3002");
+  Record cor = decode("METAR KSTL 121651Z COR 31008KT 10SM FEW050 23/13 A3002");
+  Record same = decode("METAR KSTL 121651Z COR 31008KT 10SM FEW050 23/14 A3002");
+  Record other = decode("METAR KSTL 121651Z 31010KT 10SM FEW050 23/14 A3002");
+
+  BOOST_CHECK(cor.flags & Record::CORRECTION);
+
+  BOOST_CHECK(dedup.Offer(original) == result::NEW);
+  BOOST_CHECK(dedup.Offer(original) == result::DUPLICATE);
+
+  // a correction repeating the original adds nothing
+  BOOST_CHECK(dedup.Offer(same) == result::DUPLICATE);
+
+  BOOST_CHECK(dedup.Offer(cor) == result::CORRECTION);
+  BOOST_CHECK(dedup.Offer(cor) == result::DUPLICATE);
+
+  // the original arriving late does not undo the correction
+  BOOST_CHECK(dedup.Offer(original) == result::CONFLICT);
+  BOOST_CHECK(dedup.Offer(other) == result::CONFLICT);
+
+  // another station, another time
+  BOOST_CHECK(dedup.Offer(decode("METAR KORD 121651Z 27012KT 10SM 20/10 A3001"))
+              == result::NEW);
+  BOOST_CHECK(dedup.Offer(decode("METAR KSTL 121751Z 31008KT 10SM 24/14 A3001"))
+              == result::NEW);
+
+  BOOST_CHECK(dedup.Size() == 3);
+  BOOST_CHECK(dedup.Count(result::NEW) == 3);
+  BOOST_CHECK(dedup.Count(result::DUPLICATE) == 3);
+  BOOST_CHECK(dedup.Count(result::CORRECTION) == 1);
+  BOOST_CHECK(dedup.Count(result::CONFLICT) == 2);
+
+  BOOST_CHECK(Deduplicator::Emit(result::NEW));
+  BOOST_CHECK(Deduplicator::Emit(result::CORRECTION));
+  BOOST_CHECK(!Deduplicator::Emit(result::DUPLICATE));
+  BOOST_CHECK(!Deduplicator::Emit(result::CONFLICT));
+  BOOST_CHECK(!Deduplicator::Emit(result::STALE));
+}
+
+BOOST_AUTO_TEST_CASE(window)
+{
+  Deduplicator dedup(2 * 3600);
+
+  Record r = decode("METAR KSTL 121651Z 31008KT 10SM 23/14 A3002");
+  BOOST_CHECK(dedup.Offer(r) == result::NEW);
+
+  // hourly reports, each remembered for two hours
+  for (int i = 1 ; i <= 24 ; i++)
+  {
+    Record next = r;
+    next.obs_time += i * 3600;
+    BOOST_CHECK(dedup.Offer(next) == result::NEW);
+    BOOST_CHECK(dedup.Size() <= 3);
+  }
+  BOOST_CHECK(dedup.Size() == 3);
+
+  // within the window duplicates are still recognised
+  Record recent = r;
+  recent.obs_time += 22 * 3600;
+  BOOST_CHECK(dedup.Offer(recent) == result::DUPLICATE);
+
+  BOOST_CHECK(dedup.Offer(r) == result::STALE);
+  BOOST_CHECK(dedup.Count(result::STALE) == 1);
+
+  dedup.Clear();
+  BOOST_CHECK(dedup.Size() == 0);
+  BOOST_CHECK(dedup.Offer(r) == result::NEW);
+}
+
+BOOST_AUTO_TEST_CASE(unidentified)
+{
+  Deduplicator dedup;
+
+  // without a reference time there is no observation time to key on
+  Record r = Record::Create(*Metar::Create("METAR KSTL 121651Z 31008KT 10SM"));
+  BOOST_CHECK(dedup.Offer(r) == result::NEW);
+  BOOST_CHECK(dedup.Offer(r) == result::NEW);
+  BOOST_CHECK(dedup.Size() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
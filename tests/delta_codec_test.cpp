@@ -0,0 +1,194 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Delta stream encoding tests
+//
+
+#include "DeltaCodec.h"
+#include "RecordCodec.h"
+#include "TestRecords.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+using TestRecords::decode;
+
+namespace
+{
+  // hourly reports of a few stations with slowly changing weather
+  std::vector<Record> stream(int hours)
+  {
+    const char *stations[] = { "KSTL", "KORD", "EGLL", "KJFK" };
+
+    std::vector<Record> records;
+    for (int h = 0 ; h < hours ; h++)
+    {
+      for (int s = 0 ; s < 4 ; s++)
+      {
+        char buf[128];
+        snprintf(buf, sizeof(buf),
+                 "METAR %s 12%02d51Z %03d%02dKT 10SM %sFEW050 BKN250 "
+                 "%02d/10 A30%02d RMK AO2",
+                 stations[s], h % 24, 270 + (h / 6) * 10, 8 + (h / 4) % 3,
+                 (h % 8 == 5) ? "-RA " : "", 15 + (h % 5), h / 3 % 10);
+        Record r = decode(buf);
+        // keep the observation times increasing past the day
+        r.obs_time += (h / 24) * 86400;
+        records.push_back(r);
+      }
+    }
+    return records;
+  }
+
+  using result = DeltaDecoder::result;
+
+  // decodes every message of a buffer
+  std::vector<Record> replay(DeltaDecoder& decoder,
+                             const std::vector<uint8_t>& buf,
+                             size_t *waiting = nullptr)
+  {
+    std::vector<Record> out;
+    std::span<const uint8_t> in(buf);
+    while (!in.empty())
+    {
+      size_t n;
+      Record r;
+      result res = decoder.Decode(in, n, r);
+      BOOST_REQUIRE(res == result::RECORD || res == result::WAITING);
+      if (res == result::RECORD) out.push_back(r);
+      else if (waiting != nullptr) (*waiting)++;
+      in = in.subspan(n);
+    }
+    return out;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(DeltaCodecTests)
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+  std::vector<Record> records = stream(48);
+
+  DeltaEncoder encoder(8);
+  std::vector<uint8_t> buf;
+  size_t messages = 0;
+  for (const Record& r : records) messages += encoder.Encode(r, buf);
+  BOOST_CHECK(messages == records.size());
+
+  // repeats produce nothing
+  BOOST_CHECK(!encoder.Encode(records.back(), buf));
+
+  DeltaDecoder decoder;
+  std::vector<Record> decoded = replay(decoder, buf);
+  BOOST_REQUIRE(decoded.size() == records.size());
+  for (size_t i = 0 ; i < records.size() ; i++)
+    BOOST_CHECK(decoded[i] == records[i]);
+  BOOST_CHECK(decoder.Size() == 4);
+
+  // far smaller than the fixed records
+  BOOST_CHECK(buf.size() * 4 < records.size() * RecordCodec::ENCODED_SIZE);
+}
+
+BOOST_AUTO_TEST_CASE(changes)
+{
+  Record a = decode("METAR KSTL 121651Z 31008KT 10SM -RA FEW050 23/14 A3002");
+  Record b = decode("METAR KSTL 121751Z 31008KT 10SM FEW050 23/14 A3002");
+
+  DeltaEncoder encoder;
+  std::vector<uint8_t> key, delta;
+  BOOST_CHECK(encoder.Encode(a, key));
+  BOOST_CHECK(encoder.Encode(b, delta));
+
+  // kind, station, change and presence bits, time, observation time and
+  // the now empty phenomena
+  BOOST_CHECK(delta[0] == DeltaCodec::DELTA);
+  BOOST_CHECK(delta.size() < 24);
+  BOOST_CHECK(delta.size() * 2 < key.size());
+  BOOST_CHECK(key[0] == DeltaCodec::KEYFRAME);
+
+  DeltaDecoder decoder;
+  Record r;
+  size_t n;
+  BOOST_CHECK(decoder.Decode(key, n, r) == result::RECORD);
+  BOOST_CHECK(n == key.size());
+  BOOST_CHECK(r == a);
+  BOOST_CHECK(decoder.Decode(delta, n, r) == result::RECORD);
+  BOOST_CHECK(r == b);
+  BOOST_CHECK(r.num_phenomena == 0);
+
+  // a field that disappears
+  Record c = decode("METAR KSTL 121851Z 31008KT 10SM FEW050 23/14");
+  std::vector<uint8_t> gone;
+  BOOST_CHECK(encoder.Encode(c, gone));
+  BOOST_CHECK(decoder.Decode(gone, n, r) == result::RECORD);
+  BOOST_CHECK(r == c);
+  BOOST_CHECK(!r.Has(Record::ALTIMETER_A));
+}
+
+BOOST_AUTO_TEST_CASE(late_joiner)
+{
+  std::vector<Record> records = stream(24);
+
+  DeltaEncoder encoder(4);
+  std::vector<uint8_t> early, late;
+  for (size_t i = 0 ; i < records.size() ; i++)
+    encoder.Encode(records[i], i < 24 ? early : late);
+
+  // a subscriber that missed the first 6 hours waits for keyframes
+  DeltaDecoder decoder;
+  size_t waiting = 0;
+  std::vector<Record> decoded = replay(decoder, late, &waiting);
+  BOOST_CHECK(waiting > 0);
+  BOOST_CHECK(decoder.Size() == 4);
+
+  // ... after which it follows the stream exactly
+  BOOST_CHECK(decoded.size() + waiting == records.size() - 24);
+  BOOST_CHECK(decoded.back() == records.back());
+
+  // or it starts from a snapshot of every station
+  std::vector<uint8_t> snapshot;
+  encoder.Keyframes(snapshot);
+  DeltaDecoder fresh;
+  BOOST_CHECK(replay(fresh, snapshot).size() == 4);
+  BOOST_CHECK(fresh.Size() == 4);
+}
+
+BOOST_AUTO_TEST_CASE(malformed)
+{
+  DeltaEncoder encoder;
+  std::vector<uint8_t> buf;
+  encoder.Encode(decode("METAR KSTL 121651Z 31008KT 10SM FEW050 23/14 A3002"),
+                 buf);
+
+  DeltaDecoder decoder;
+  Record r;
+  size_t n;
+
+  // every truncation is detected
+  for (size_t len = 0 ; len < buf.size() ; len++)
+  {
+    BOOST_CHECK(decoder.Decode(std::span<const uint8_t>(buf.data(), len), n, r)
+                == result::INCOMPLETE);
+    BOOST_CHECK(n == 0);
+  }
+  BOOST_CHECK(decoder.Size() == 0);
+
+  std::vector<uint8_t> bad = buf;
+  bad[0] = 7;
+  BOOST_CHECK(decoder.Decode(bad, n, r) == result::CORRUPT);
+
+  // presence bits outside the change bits
+  std::vector<uint8_t> mask = { DeltaCodec::DELTA, 1, 2, 4 };
+  BOOST_CHECK(decoder.Decode(mask, n, r) == result::CORRUPT);
+
+  // presence bits numerically below the change bits but not among them
+  std::vector<uint8_t> subset = { DeltaCodec::DELTA, 1, 4, 3 };
+  BOOST_CHECK(decoder.Decode(subset, n, r) == result::CORRUPT);
+  BOOST_CHECK(decoder.Size() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
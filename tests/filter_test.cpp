@@ -0,0 +1,170 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Predicate filter tests
+//
+
+#include "Filter.h"
+#include "Batch.h"
+#include "Metar.h"
+#include "Phenom.h"
+
+#include <cstdio>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  const char *reports[] =
+  {
+    "KSTL 091651Z 10010G40KT 2 1/2SM -TSRA BR OVC008 07/M06 A2998 RMK SLP160",
+    "KORD 091651Z 36010KT 1/2SM -FZRA FG OVC002 M01/M02 A3001",
+    "EGLL 091650Z 24015MPS 9999 FEW030 12/08 Q1012",
+    "LFPG 091700Z 18005KT CAVOK 15/09 Q1020",
+    "KDEN 091653Z 27035G45KT 10SM SKC 20/M10 A3010",
+    "UUEE 091700Z 33005MPS 4000 -SN BKN010 M05/M07 Q1015",
+    "KJFK 091651Z 18008KT 3SM RA BKN009 10/09 A2990",
+    "KSEA 091653Z 00000KT M1/4SM FZFG VV001 M02/M02 A3005",
+    "RJTT 091700Z 09070KPH 6000 RA SCT020 18/16 Q1004",
+    "KBOS 091654Z VRB03KT"
+  };
+
+  bool freezing_rain(const Metar& m)
+  {
+    for (unsigned int i = 0 ; i < m.NumPhenomena() ; i++)
+    {
+      const Phenom& p = m.Phenomenon(i);
+      for (unsigned int j = 0 ; j < p.NumPhenom() ; j++)
+      {
+        if (p.Freezing() && p[j] == Phenom::phenom::RAIN) return true;
+      }
+    }
+    return false;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(FilterTests)
+
+BOOST_AUTO_TEST_CASE(predicates)
+{
+  Batch batch;
+  for (auto r : reports) batch.Append(*Metar::Create(r));
+
+  std::vector<uint64_t> sel;
+  std::vector<size_t> idx;
+
+  auto f = Filter::Compare(Filter::field::VISIBILITY, Filter::op::LT, 3);
+  f.Evaluate(batch, sel);
+  Filter::Indices(sel, idx);
+  // 2 1/2SM, 1/2SM, 4000 m, M1/4SM
+  BOOST_CHECK((idx == std::vector<size_t>{ 0, 1, 5, 7 }));
+
+  idx.clear();
+  Filter::Compare(Filter::field::CEILING, Filter::op::LT, 1000)
+    .Evaluate(batch, sel);
+  Filter::Indices(sel, idx);
+  // OVC008, OVC002, BKN009, VV001; BKN010 is not below
+  BOOST_CHECK((idx == std::vector<size_t>{ 0, 1, 6, 7 }));
+
+  // 40KT, 45KT; 70 KPH is 37.8KT but is not a gust
+  idx.clear();
+  Filter::Compare(Filter::field::WIND_GUST, Filter::op::GT, 35)
+    .Evaluate(batch, sel);
+  Filter::Indices(sel, idx);
+  BOOST_CHECK((idx == std::vector<size_t>{ 0, 4 }));
+
+  // 24015MPS is 29KT, 09070KPH is 37.8KT
+  idx.clear();
+  Filter::Compare(Filter::field::WIND_SPEED, Filter::op::GE, 35)
+    .Evaluate(batch, sel);
+  Filter::Indices(sel, idx);
+  BOOST_CHECK((idx == std::vector<size_t>{ 4, 8 }));
+
+  idx.clear();
+  Filter::Contains(Phenom::phenom::RAIN, true).Evaluate(batch, sel);
+  Filter::Indices(sel, idx);
+  BOOST_CHECK((idx == std::vector<size_t>{ 1 }));
+
+  idx.clear();
+  Filter::Contains(Phenom::phenom::RAIN).Evaluate(batch, sel);
+  Filter::Indices(sel, idx);
+  BOOST_CHECK((idx == std::vector<size_t>{ 0, 1, 6, 8 }));
+
+  idx.clear();
+  Filter::Compare(Filter::field::TEMPERATURE, Filter::op::LE, -2)
+    .Evaluate(batch, sel);
+  Filter::Indices(sel, idx);
+  BOOST_CHECK((idx == std::vector<size_t>{ 5, 7 }));
+
+  // missing values never match, not even NE
+  idx.clear();
+  Filter::Compare(Filter::field::TEMPERATURE, Filter::op::NE, 1000)
+    .Evaluate(batch, sel);
+  BOOST_CHECK(Filter::Count(sel) == 9);
+}
+
+BOOST_AUTO_TEST_CASE(combinations)
+{
+  Batch batch;
+  for (auto r : reports) batch.Append(*Metar::Create(r));
+
+  auto ifr = Filter::Compare(Filter::field::VISIBILITY, Filter::op::LT, 3)
+           | Filter::Compare(Filter::field::CEILING, Filter::op::LT, 1000);
+  auto cold = Filter::Compare(Filter::field::TEMPERATURE, Filter::op::LT, 0);
+
+  std::vector<uint64_t> sel;
+  std::vector<size_t> idx;
+
+  (ifr & cold).Evaluate(batch, sel);
+  Filter::Indices(sel, idx);
+  BOOST_CHECK((idx == std::vector<size_t>{ 1, 5, 7 }));
+
+  idx.clear();
+  (cold | Filter::Contains(Phenom::phenom::RAIN)).Evaluate(batch, sel);
+  Filter::Indices(sel, idx);
+  BOOST_CHECK((idx == std::vector<size_t>{ 0, 1, 5, 6, 7, 8 }));
+}
+
+BOOST_AUTO_TEST_CASE(large_batch)
+{
+  Batch batch;
+  std::vector<std::shared_ptr<Metar>> metars;
+
+  // more than one bitmap word, with a partial last word
+  for (int i = 0 ; i < 1000 ; i++)
+  {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "KSTL 091651Z 180%02dKT %dSM %s OVC%03d %02d/00 A2990",
+             i % 50, 1 + i % 10, i % 7 ? "BR" : "-FZRA", 1 + i % 40, i % 30);
+    metars.push_back(Metar::Create(buf));
+    batch.Append(*metars.back());
+  }
+
+  auto f = (Filter::Compare(Filter::field::WIND_SPEED, Filter::op::GT, 30)
+            & Filter::Compare(Filter::field::VISIBILITY, Filter::op::LE, 4))
+         | Filter::Contains(Phenom::phenom::RAIN, true)
+         | Filter::Compare(Filter::field::FLIGHT_CATEGORY, Filter::op::EQ,
+                           static_cast<double>(Metar::flight_category::LIFR));
+
+  std::vector<uint64_t> sel;
+  f.Evaluate(batch, sel);
+  BOOST_REQUIRE(sel.size() == 16);
+  BOOST_CHECK((sel.back() >> (1000 % 64)) == 0);
+
+  size_t expected = 0;
+  for (size_t i = 0 ; i < metars.size() ; i++)
+  {
+    const Metar& m = *metars[i];
+    bool match = (*m.WindSpeed() > 30 && *m.Visibility() <= 4)
+              || freezing_rain(m)
+              || *m.FlightCategory() == Metar::flight_category::LIFR;
+    BOOST_CHECK(((sel[i / 64] >> (i % 64)) & 1) == match);
+    expected += match;
+  }
+  BOOST_CHECK(Filter::Count(sel) == expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,245 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Latest observation cache tests
+//
+
+#include "LatestCache.h"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  Record make(const char *icao, int64_t t, bool cor = false)
+  {
+    Record r;
+    memset(&r, 0, sizeof(r));
+    r.icao = Record::PackICAO(icao);
+    r.obs_time = t;
+    r.present = Record::ICAO | Record::OBSERVATION_TIME;
+    r.flags = cor ? Record::CORRECTION : 0;
+    // derived fields let readers detect torn copies
+    r.visibility = static_cast<int32_t>(t * 3);
+    r.ceiling = static_cast<int32_t>(t * 7);
+    return r;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(LatestCacheTests)
+
+BOOST_AUTO_TEST_CASE(supersede)
+{
+  LatestCache cache(16, 4);
+  const uint32_t kstl = Record::PackICAO("KSTL");
+
+  BOOST_CHECK(!cache.Get(kstl).has_value());
+
+  BOOST_CHECK(cache.Update(make("KSTL", 100)));
+  BOOST_CHECK(cache.Get(kstl)->obs_time == 100);
+
+  // older and duplicate reports are ignored
+  BOOST_CHECK(!cache.Update(make("KSTL", 50)));
+  BOOST_CHECK(!cache.Update(make("KSTL", 100)));
+  BOOST_CHECK(cache.Get(kstl)->obs_time == 100);
+
+  // a correction replaces the report it corrects, but only once
+  Record cor = make("KSTL", 100, true);
+  cor.temperature = 12;
+  BOOST_CHECK(cache.Update(cor));
+  BOOST_CHECK(cache.Get(kstl)->temperature == 12);
+  BOOST_CHECK(!cache.Update(cor));
+
+  // a correction of an older report is ignored
+  BOOST_CHECK(!cache.Update(make("KSTL", 40, true)));
+
+  BOOST_CHECK(cache.Update(make("KSTL", 200)));
+  BOOST_CHECK(cache.Get(kstl)->obs_time == 200);
+  BOOST_CHECK(!(cache.Get(kstl)->flags & Record::CORRECTION));
+
+  BOOST_CHECK(cache.Update(make("KJFK", 10)));
+  BOOST_CHECK(cache.Size() == 2);
+  BOOST_CHECK(cache.Get(Record::PackICAO("KJFK"))->obs_time == 10);
+  BOOST_CHECK(!cache.Get(Record::PackICAO("EGLL")).has_value());
+}
+
+BOOST_AUTO_TEST_CASE(day_hour_minute)
+{
+  Record a = make("KSTL", 0);
+  Record b = make("KSTL", 0);
+  a.present = b.present = Record::ICAO | Record::TIME;
+
+  a.day = 5; a.hour = 23; a.minute = 55;
+  b.day = 6; b.hour = 0; b.minute = 5;
+
+  BOOST_CHECK(LatestCache::Supersedes(b, a));
+  BOOST_CHECK(!LatestCache::Supersedes(a, b));
+}
+
+BOOST_AUTO_TEST_CASE(month_rollover)
+{
+  Record a = make("KSTL", 0);
+  Record b = make("KSTL", 0);
+  a.present = b.present = Record::ICAO | Record::TIME;
+
+  a.day = 31; a.hour = 23; a.minute = 51;
+  b.day = 1; b.hour = 0; b.minute = 51;
+
+  BOOST_CHECK(LatestCache::Supersedes(b, a));
+  BOOST_CHECK(!LatestCache::Supersedes(a, b));
+
+  // within half a month the day number decides
+  a.day = 15;
+  BOOST_CHECK(!LatestCache::Supersedes(b, a));
+  BOOST_CHECK(LatestCache::Supersedes(a, b));
+}
+
+BOOST_AUTO_TEST_CASE(full)
+{
+  LatestCache cache(2, 1);
+
+  BOOST_CHECK(cache.Update(make("KSTL", 1)));
+  BOOST_CHECK(cache.Update(make("KJFK", 1)));
+  BOOST_CHECK(cache.Update(make("KORD", 1)));
+  BOOST_CHECK(cache.Update(make("KLAX", 1)));
+  BOOST_CHECK(!cache.Update(make("KSFO", 1)));
+  BOOST_CHECK(cache.Size() == 4);
+
+  // stations already cached can still be updated
+  BOOST_CHECK(cache.Update(make("KSTL", 2)));
+}
+
+BOOST_AUTO_TEST_CASE(changes)
+{
+  LatestCache cache(16, 4, 4);
+  std::vector<Record> out;
+
+  BOOST_CHECK(cache.Version() == 0);
+  BOOST_CHECK(cache.Changes(0, out) == 0);
+  BOOST_CHECK(out.empty());
+
+  cache.Update(make("KSTL", 1));
+  cache.Update(make("KJFK", 1));
+  cache.Update(make("KSTL", 2));
+  cache.Update(make("KSTL", 2)); // not stored, no new version
+
+  uint64_t v = cache.Changes(0, out);
+  BOOST_CHECK(v == 3);
+  BOOST_CHECK(out.size() == 2);
+
+  cache.Update(make("KORD", 1));
+  v = cache.Changes(v, out);
+  BOOST_CHECK(v == 4);
+  BOOST_REQUIRE(out.size() == 1);
+  BOOST_CHECK(out[0].icao == Record::PackICAO("KORD"));
+
+  BOOST_CHECK(cache.Changes(v, out) == 4);
+  BOOST_CHECK(out.empty());
+
+  cache.Update(make("KSTL", 3));
+  v = cache.Changes(v, out);
+  BOOST_REQUIRE(out.size() == 1);
+  BOOST_CHECK(out[0].obs_time == 3);
+
+  // the log keeps 4 updates; older versions fall back to every station
+  BOOST_CHECK(cache.Changes(0, out) == 5);
+  BOOST_CHECK(out.size() == 3);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent)
+{
+  constexpr int STATIONS = 64;
+  constexpr int64_t UPDATES = 5000;
+
+  LatestCache cache(STATIONS, 8);
+
+  std::vector<std::string> names;
+  for (int i = 0 ; i < STATIONS ; i++)
+  {
+    names.push_back("K" + std::string(1, 'A' + i % 26)
+                        + std::string(1, 'A' + i / 26) + "X");
+  }
+
+  std::atomic<bool> done{false};
+  std::atomic<bool> torn{false};
+  std::atomic<bool> regressed{false};
+
+  std::vector<std::thread> readers;
+  for (int r = 0 ; r < 2 ; r++)
+  {
+    readers.emplace_back([&] {
+      std::vector<int64_t> last(STATIONS, 0);
+      while (!done.load())
+      {
+        for (int i = 0 ; i < STATIONS ; i++)
+        {
+          auto rec = cache.Get(Record::PackICAO(names[i].c_str()));
+          if (!rec.has_value()) continue;
+          if (rec->visibility != rec->obs_time * 3
+              || rec->ceiling != rec->obs_time * 7) torn = true;
+          if (rec->obs_time < last[i]) regressed = true;
+          last[i] = rec->obs_time;
+        }
+      }
+    });
+  }
+
+  // a poller follows the change feed; whatever it misses while writers are
+  // running must show up by its last call
+  std::vector<int64_t> polled(STATIONS, 0);
+  uint64_t polled_version = 0;
+  auto poll = [&] {
+    std::vector<Record> changes;
+    polled_version = cache.Changes(polled_version, changes);
+    for (const Record& rec : changes)
+    {
+      for (int i = 0 ; i < STATIONS ; i++)
+      {
+        if (rec.icao == Record::PackICAO(names[i].c_str()))
+          polled[i] = rec.obs_time;
+      }
+    }
+  };
+  std::thread poller([&] { while (!done.load()) poll(); });
+
+  // writers deliver interleaved, partly out of order, reports
+  std::vector<std::thread> writers;
+  for (int w = 0 ; w < 4 ; w++)
+  {
+    writers.emplace_back([&, w] {
+      for (int64_t t = 1 ; t <= UPDATES ; t++)
+      {
+        for (int i = w ; i < STATIONS ; i += 4)
+        {
+          cache.Update(make(names[i].c_str(), t % 7 ? t : t - 5));
+        }
+      }
+    });
+  }
+
+  for (auto& t : writers) t.join();
+  done = true;
+  for (auto& t : readers) t.join();
+  poller.join();
+  poll();
+
+  BOOST_CHECK(!torn);
+  BOOST_CHECK(!regressed);
+  BOOST_CHECK(cache.Size() == STATIONS);
+  for (int i = 0 ; i < STATIONS ; i++)
+  {
+    BOOST_CHECK(cache.Get(Record::PackICAO(names[i].c_str()))->obs_time
+                == UPDATES);
+    BOOST_CHECK(polled[i] == UPDATES);
+  }
+  BOOST_CHECK(polled_version == cache.Version());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Memory-mapped record file tests
+//
+
+#include "MappedRecords.h"
+#include "Metar.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  std::string temp_path(const char *name)
+  {
+    return (std::filesystem::temp_directory_path()
+            / (std::string(name) + "." + std::to_string(getpid()))).string();
+  }
+
+  std::vector<Record> make_records()
+  {
+    const char *reports[] =
+    {
+      "METAR KSTL 091651Z 10010G18KT 060V120 2 1/2SM -TSRA BR FEW012 OVC050CB 07/M06 A2998 RMK SLP160 T00671056",
+      "METAR EGLL 091650Z 24015KT 9999 FEW030 SCT045 BKN250 12/08 Q1012",
+      "SPECI KJFK 091702Z COR VRB03KT 1/4SM +SN FG VV002 M02/M03 A3001"
+    };
+
+    std::vector<Record> records;
+    for (int i = 0 ; i < 3000 ; i++)
+    {
+      records.push_back(Record::Create(*Metar::Create(reports[i % 3],
+                                                      1704153600)));
+      records.back().obs_time += i * 60;
+    }
+    return records;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(MappedRecordsTests)
+
+BOOST_AUTO_TEST_CASE(columns)
+{
+  auto records = make_records();
+  std::string path = temp_path("mapped_records_test");
+  {
+    std::ofstream os(path, std::ios::binary);
+    BOOST_REQUIRE(RecordCodec::Write(os, records));
+  }
+
+  auto mapped = MappedRecords::Create(path.c_str());
+  std::filesystem::remove(path);  // the mapping outlives the name
+  BOOST_REQUIRE(mapped);
+  BOOST_REQUIRE(mapped->Size() == records.size());
+
+  auto icao = mapped->ICAO();
+  auto obs_time = mapped->ObservationTime();
+  auto vis = mapped->Visibility();
+  auto gust = mapped->WindGust();
+  auto temp = mapped->Temperature();
+  auto temp_na = mapped->TemperatureNA();
+  auto slp = mapped->SeaLevelPressure();
+  auto category = mapped->FlightCategory();
+  auto flags = mapped->Flags();
+
+  BOOST_CHECK(icao.size() == records.size());
+  for (size_t i = 0 ; i < records.size() ; i++)
+  {
+    const Record& r = records[i];
+    BOOST_CHECK(icao[i] == r.icao);
+    BOOST_CHECK(obs_time[i] == r.obs_time);
+    BOOST_CHECK(vis[i] == r.visibility);
+    BOOST_CHECK(gust[i] == r.wind_gust);
+    BOOST_CHECK(temp[i] == r.temperature);
+    BOOST_CHECK(temp_na[i] == r.temperature_na);
+    BOOST_CHECK(slp[i] == r.sea_level_press);
+    BOOST_CHECK(category[i] == r.flight_category);
+    BOOST_CHECK(flags[i] == r.flags);
+
+    Record d;
+    BOOST_CHECK(mapped->Get(i, d));
+    BOOST_CHECK(d == r);
+  }
+
+  auto dew = mapped->Field<int8_t>(RecordCodec::DEW_POINT_OFFSET);
+  BOOST_CHECK(dew[0] == -6 && dew[1] == 8 && dew[2] == -3);
+}
+
+BOOST_AUTO_TEST_CASE(invalid)
+{
+  BOOST_CHECK(!MappedRecords::Create("/nonexistent/records"));
+
+  auto records = make_records();
+  std::string path = temp_path("mapped_records_test_invalid");
+
+  {
+    std::ofstream os(path, std::ios::binary);
+    RecordCodec::Write(os, records);
+  }
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+  BOOST_CHECK(!MappedRecords::Create(path.c_str()));
+
+  {
+    std::ofstream os(path, std::ios::binary);
+    os << "METAR KSTL 091651Z 10010KT 10SM CLR 07/M06 A2998";
+  }
+  BOOST_CHECK(!MappedRecords::Create(path.c_str()));
+
+  std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
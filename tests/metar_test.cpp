@@ -7,6 +7,8 @@
 #include "Metar.h"
 #include "Clouds.h"
 #include "Phenom.h"
+#include "Utils.h"
+#include "Convert.h"
 
 #include <string>
 
@@ -34,6 +36,51 @@ BOOST_AUTO_TEST_CASE(observation_time)
   BOOST_CHECK(metar->Minute() == 56);
 }
 
+BOOST_AUTO_TEST_CASE(observation_time_unresolved)
+{
+  auto metar = Metar::Create("KSTL 151151Z");
+
+  BOOST_CHECK(!metar->ObservationTime().has_value());
+}
+
+BOOST_AUTO_TEST_CASE(observation_time_same_month)
+{
+  // 2024-03-15 12:00Z
+  auto metar = Metar::Create("KSTL 151151Z", 1710504000);
+
+  BOOST_CHECK(metar->ObservationTime() == 1710503460);
+}
+
+BOOST_AUTO_TEST_CASE(observation_time_year_rollover)
+{
+  // 2024-01-02 00:00Z
+  auto metar = Metar::Create("KSTL 312350Z", 1704153600);
+  BOOST_CHECK(metar->ObservationTime() == 1704066600);
+
+  // 2024-12-31 22:00Z
+  metar = Metar::Create("KSTL 010005Z", 1735682400);
+  BOOST_CHECK(metar->ObservationTime() == 1735689900);
+}
+
+BOOST_AUTO_TEST_CASE(observation_time_leap_day)
+{
+  // 2024-03-01 01:00Z
+  auto metar = Metar::Create("KSTL 292300Z", 1709254800);
+
+  BOOST_CHECK(metar->ObservationTime() == 1709247600);
+}
+
+BOOST_AUTO_TEST_CASE(correction)
+{
+  BOOST_CHECK(!Metar::Create("METAR KSTL 151151Z 10010KT")->isCorrection());
+  BOOST_CHECK(Metar::Create("METAR COR KSTL 151151Z 10010KT")->isCorrection());
+
+  auto metar = Metar::Create("METAR KSTL 151151Z COR 10010KT");
+  BOOST_CHECK(metar->isCorrection());
+  BOOST_CHECK(metar->ICAO() == "KSTL");
+  BOOST_CHECK(metar->WindSpeed() == 10);
+}
+
 BOOST_AUTO_TEST_CASE(uninitialized_temperature)
 {
   auto metar = Metar::Create("");
@@ -515,6 +562,122 @@ BOOST_AUTO_TEST_CASE(visibility_CAVOK)
   BOOST_CHECK(metar->isCAVOK());
 }
 
+BOOST_AUTO_TEST_CASE(scaled_values)
+{
+  auto metar = Metar::Create("2 3/16SM A2992 RMK SLP132 T10171022");
+
+  BOOST_CHECK(metar->VisibilityScaled() == 35);
+  BOOST_CHECK(metar->Visibility() == (35.0 / 16.0));
+
+  BOOST_CHECK(metar->AltimeterAHundredths() == 2992);
+  BOOST_CHECK(metar->AltimeterA() == 29.92);
+
+  BOOST_CHECK(metar->SeaLevelPressureTenths() == 10132);
+  BOOST_CHECK(metar->SeaLevelPressure() == 1013.2);
+
+  BOOST_CHECK(metar->TemperatureNATenths() == -17);
+  BOOST_CHECK(metar->DewPointNATenths() == -22);
+  BOOST_CHECK(metar->TemperatureNA() == -1.7);
+  BOOST_CHECK(metar->DewPointNA() == -2.2);
+}
+
+BOOST_AUTO_TEST_CASE(scaled_visibility_meters)
+{
+  auto metar = Metar::Create("0800");
+
+  BOOST_CHECK(metar->VisibilityScaled() == 800);
+  BOOST_CHECK(metar->Visibility() == 800);
+}
+
+BOOST_AUTO_TEST_CASE(uninitialized_scaled_values)
+{
+  auto metar = Metar::Create("");
+
+  BOOST_CHECK(!metar->VisibilityScaled().has_value());
+  BOOST_CHECK(!metar->AltimeterAHundredths().has_value());
+  BOOST_CHECK(!metar->SeaLevelPressureTenths().has_value());
+  BOOST_CHECK(!metar->TemperatureNATenths().has_value());
+  BOOST_CHECK(!metar->DewPointNATenths().has_value());
+}
+
+BOOST_AUTO_TEST_CASE(ceiling)
+{
+  auto metar = Metar::Create("KSTL 162025Z 24004KT 10SM FEW039 SCT060 BKN090 OVC025 TEMPO BKN010");
+
+  BOOST_CHECK(metar->Ceiling() == 2500);
+  BOOST_CHECK(metar->FlightCategory() == Metar::flight_category::MVFR);
+}
+
+BOOST_AUTO_TEST_CASE(ceiling_vert_vis)
+{
+  auto metar = Metar::Create("KSTL 162025Z 24004KT 1/4SM FG VV001");
+
+  BOOST_CHECK(metar->Ceiling() == 100);
+  BOOST_CHECK(metar->FlightCategory() == Metar::flight_category::LIFR);
+}
+
+BOOST_AUTO_TEST_CASE(flight_category)
+{
+  auto metar = Metar::Create("KSTL 162025Z 24004KT 10SM FEW039 SCT060");
+  BOOST_CHECK(!metar->Ceiling().has_value());
+  BOOST_CHECK(metar->FlightCategory() == Metar::flight_category::VFR);
+
+  metar = Metar::Create("KSTL 162025Z 24004KT 2SM BR SCT060");
+  BOOST_CHECK(metar->FlightCategory() == Metar::flight_category::IFR);
+
+  metar = Metar::Create("LBBG 041600Z 12012MPS 0800 FG");
+  BOOST_CHECK(metar->FlightCategory() == Metar::flight_category::LIFR);
+
+  metar = Metar::Create("LBBG 041600Z 12012MPS CAVOK");
+  BOOST_CHECK(metar->FlightCategory() == Metar::flight_category::VFR);
+
+  metar = Metar::Create("");
+  BOOST_CHECK(!metar->FlightCategory().has_value());
+}
+
+BOOST_AUTO_TEST_CASE(derived_values, * boost::unit_test::tolerance(1e-9))
+{
+  auto metar = Metar::Create("KSTL 091651Z 10010G20KT 10SM 07/M06 A2998 RMK T00671056");
+
+  BOOST_TEST(*metar->RelativeHumidity() == Utils::Humidity(6.7, -5.6));
+  BOOST_TEST(*metar->WindChill() ==
+                  Utils::WindChill(6.7, Convert::Kts2Kph(10.0)));
+  BOOST_TEST(*metar->HeatIndex() ==
+                  Utils::HeatIndex(6.7, Utils::Humidity(6.7, -5.6)));
+  BOOST_TEST(*metar->WindSpeedKnots() == 10.0);
+  BOOST_TEST(*metar->WindGustKnots() == 20.0);
+
+  BOOST_TEST(*metar->PressureAltitude(605.0) == 545.0);
+  BOOST_TEST(*metar->DensityAltitude(605.0) ==
+                  545.0 + 120.0 * (6.7 - (15.0 - 2.0 * 0.545)));
+
+  // cached values are stable across calls
+  BOOST_TEST(*metar->RelativeHumidity() == Utils::Humidity(6.7, -5.6));
+}
+
+BOOST_AUTO_TEST_CASE(derived_values_units, * boost::unit_test::tolerance(1e-9))
+{
+  auto metar = Metar::Create("LBBG 041600Z 12012MPS CAVOK M04/M07 Q1020");
+
+  BOOST_TEST(*metar->WindSpeedKnots() == 12.0 / Convert::Kts2Mps(1.0));
+  BOOST_CHECK(!metar->WindGustKnots().has_value());
+  BOOST_TEST(*metar->RelativeHumidity() == Utils::Humidity(-4.0, -7.0));
+  BOOST_TEST(*metar->PressureAltitude(0.0) ==
+                  (29.92 - Convert::mb2InMg(1020.0)) * 1000.0);
+}
+
+BOOST_AUTO_TEST_CASE(uninitialized_derived_values)
+{
+  auto metar = Metar::Create("");
+
+  BOOST_CHECK(!metar->RelativeHumidity().has_value());
+  BOOST_CHECK(!metar->WindChill().has_value());
+  BOOST_CHECK(!metar->HeatIndex().has_value());
+  BOOST_CHECK(!metar->WindSpeedKnots().has_value());
+  BOOST_CHECK(!metar->PressureAltitude(100.0).has_value());
+  BOOST_CHECK(!metar->DensityAltitude(100.0).has_value());
+}
+
 BOOST_AUTO_TEST_CASE(uninitialized_vert_visibility)
 {
   auto metar = Metar::Create("");
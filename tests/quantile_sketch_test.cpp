@@ -0,0 +1,234 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Quantile sketch tests
+//
+
+#include "QuantileSketch.h"
+#include "TestRecords.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+using TestRecords::decode;
+
+namespace
+{
+  // rank of v among sorted values
+  double rank(const std::vector<double>& sorted, double v)
+  {
+    return static_cast<double>(std::upper_bound(sorted.begin(), sorted.end(),
+                                                v) - sorted.begin())
+           / static_cast<double>(sorted.size());
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(QuantileSketchTests)
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+  QuantileSketch s;
+  BOOST_CHECK(s.Count() == 0);
+  BOOST_CHECK(std::isnan(s.Quantile(0.5)));
+  BOOST_CHECK(std::isnan(s.Rank(1.0)));
+  BOOST_CHECK(std::isnan(s.Min()));
+
+  s.Add(NAN);
+  BOOST_CHECK(s.Count() == 0);
+
+  s.Add(3.0);
+  BOOST_CHECK(s.Quantile(0.0) == 3.0);
+  BOOST_CHECK(s.Quantile(0.5) == 3.0);
+  BOOST_CHECK(s.Quantile(1.0) == 3.0);
+}
+
+BOOST_AUTO_TEST_CASE(accuracy)
+{
+  std::mt19937 rng(7);
+  std::lognormal_distribution<double> dist(2.0, 0.6);
+
+  QuantileSketch s;
+  std::vector<double> all;
+  for (int i = 0 ; i < 200000 ; i++)
+  {
+    double v = dist(rng);
+    s.Add(v);
+    all.push_back(v);
+  }
+  std::sort(all.begin(), all.end());
+
+  BOOST_CHECK(s.Count() == all.size());
+  BOOST_CHECK(s.Retained() < 1000);
+  BOOST_CHECK(s.Min() == all.front());
+  BOOST_CHECK(s.Max() == all.back());
+
+  const double q[] = { 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99 };
+  double v[std::size(q)];
+  s.Quantiles(q, v);
+  for (size_t i = 0 ; i < std::size(q) ; i++)
+  {
+    BOOST_CHECK(v[i] == s.Quantile(q[i]));
+    BOOST_CHECK_SMALL(rank(all, v[i]) - q[i], 0.02);
+    BOOST_CHECK_SMALL(s.Rank(all[static_cast<size_t>(q[i] * all.size())])
+                      - q[i], 0.02);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(merge)
+{
+  std::mt19937 rng(11);
+  std::normal_distribution<double> dist(0.0, 1.0);
+
+  // unequal parts with different distributions, as months of a year
+  QuantileSketch whole;
+  std::vector<QuantileSketch> parts(12);
+  std::vector<double> all;
+  for (size_t m = 0 ; m < parts.size() ; m++)
+  {
+    for (size_t i = 0 ; i < 1000 * (m + 1) ; i++)
+    {
+      double v = dist(rng) + static_cast<double>(m);
+      parts[m].Add(v);
+      all.push_back(v);
+    }
+  }
+  std::sort(all.begin(), all.end());
+
+  for (const auto& p : parts) BOOST_REQUIRE(whole.Merge(p));
+
+  BOOST_CHECK(whole.Count() == all.size());
+  BOOST_CHECK(whole.Min() == all.front());
+  BOOST_CHECK(whole.Max() == all.back());
+  for (double q : { 0.05, 0.5, 0.95 })
+  {
+    BOOST_CHECK_SMALL(rank(all, whole.Quantile(q)) - q, 0.02);
+  }
+
+  QuantileSketch other(100);
+  BOOST_CHECK(!whole.Merge(other));
+}
+
+BOOST_AUTO_TEST_CASE(merge_small)
+{
+  // merging two fresh sketches must not spoil the random offsets of
+  // later compactions
+  QuantileSketch a;
+  QuantileSketch b;
+  a.Add(1.0);
+  b.Add(2.0);
+  BOOST_REQUIRE(a.Merge(b));
+
+  std::mt19937 rng(13);
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  std::vector<double> all { 1.0, 2.0 };
+  for (size_t i = 0 ; i < 1000000 ; i++)
+  {
+    double v = dist(rng);
+    a.Add(v);
+    all.push_back(v);
+  }
+  std::sort(all.begin(), all.end());
+
+  for (double q : { 0.01, 0.5, 0.99 })
+  {
+    BOOST_CHECK_SMALL(rank(all, a.Quantile(q)) - q, 0.02);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(serialize)
+{
+  QuantileSketch s(64);
+  for (int i = 0 ; i < 10000 ; i++) s.Add(i % 977);
+
+  std::vector<uint8_t> buf;
+  s.Serialize(buf);
+
+  size_t consumed;
+  auto copy = QuantileSketch::Create(buf, consumed);
+  BOOST_REQUIRE(copy);
+  BOOST_CHECK(consumed == buf.size());
+  BOOST_CHECK(copy->K() == 64);
+  BOOST_CHECK(copy->Count() == s.Count());
+  BOOST_CHECK(copy->Retained() == s.Retained());
+  for (double q : { 0.0, 0.3, 0.9, 1.0 })
+  {
+    BOOST_CHECK(copy->Quantile(q) == s.Quantile(q));
+  }
+
+  // truncated and corrupted input
+  for (size_t n = 0 ; n < buf.size() ; n += 7)
+  {
+    BOOST_CHECK(!QuantileSketch::Create(
+                   std::span<const uint8_t>(buf.data(), n), consumed));
+  }
+  buf[0] = 9;
+  BOOST_CHECK(!QuantileSketch::Create(buf, consumed));
+}
+
+BOOST_AUTO_TEST_CASE(stations)
+{
+  const uint32_t kbos = Record::PackICAO("KBOS");
+  const uint32_t efhk = Record::PackICAO("EFHK");
+
+  // one instance per thread, or file
+  StationSketches a, b;
+  for (int i = 0 ; i < 50 ; i++)
+  {
+    BOOST_CHECK(a.Add(decode("METAR KBOS 121754Z 27015G25KT 1/2SM FG "
+                             "OVC002 10/09 A2992")));
+    BOOST_CHECK(b.Add(decode("METAR KBOS 121854Z 27010KT 10SM "
+                             "FEW050 12/05 A2992")));
+  }
+  BOOST_CHECK(b.Add(decode("METAR EFHK 121650Z 27010G15MPS CAVOK "
+                           "M05/M09 Q1001")));
+
+  Record none = decode("METAR KBOS 121754Z 27015KT 10SM 10/09 A2992");
+  none.icao = 0;
+  BOOST_CHECK(!a.Add(none));
+
+  BOOST_REQUIRE(a.Merge(b));
+  BOOST_CHECK(a.Size() == 2);
+
+  const QuantileSketch *gust = a.Get(kbos, Filter::field::WIND_GUST);
+  BOOST_REQUIRE(gust != nullptr);
+  BOOST_CHECK(gust->Count() == 50);
+  BOOST_CHECK(gust->Quantile(0.99) == 25);
+
+  const QuantileSketch *vis = a.Get(kbos, Filter::field::VISIBILITY);
+  BOOST_CHECK(vis->Count() == 100);
+  BOOST_CHECK(vis->Quantile(0.1) == 0.5);
+  BOOST_CHECK(vis->Quantile(0.9) == 10);
+
+  BOOST_CHECK_CLOSE(a.Get(efhk, Filter::field::WIND_GUST)->Max(),
+                    29.16, 0.5);
+  BOOST_CHECK_CLOSE(a.Get(efhk, Filter::field::VISIBILITY)->Max(),
+                    6.21, 0.5);
+
+  BOOST_CHECK(a.Get(kbos, Filter::field::TEMPERATURE) == nullptr);
+  BOOST_CHECK(a.Get(Record::PackICAO("KJFK"),
+                    Filter::field::WIND_SPEED) == nullptr);
+
+  StationSketches temperature({ Filter::field::TEMPERATURE });
+  BOOST_CHECK(!a.Merge(temperature));
+
+  // save and restore
+  std::vector<uint8_t> buf;
+  a.Serialize(buf);
+  auto copy = StationSketches::Create(buf);
+  BOOST_REQUIRE(copy);
+  BOOST_CHECK(copy->Size() == 2);
+  BOOST_CHECK(copy->Get(kbos, Filter::field::WIND_SPEED)->Quantile(0.5)
+              == a.Get(kbos, Filter::field::WIND_SPEED)->Quantile(0.5));
+  BOOST_CHECK(copy->Merge(a));
+  BOOST_CHECK(copy->Get(kbos, Filter::field::WIND_GUST)->Count() == 100);
+
+  buf.pop_back();
+  BOOST_CHECK(!StationSketches::Create(buf));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Record binary encoding tests
+//
+
+#include "RecordCodec.h"
+#include "Metar.h"
+
+#include <sstream>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  const char *reports[] =
+  {
+    "METAR KSTL 091651Z 10010G18KT 060V120 2 1/2SM -TSRA BR FEW012 OVC050CB 07/M06 A2998 RMK SLP160 T00671056",
+    "METAR EGLL 091650Z 24015KT 9999 FEW030 SCT045 BKN250 12/08 Q1012",
+    "SPECI KJFK 091702Z COR VRB03KT 1/4SM +SN FG VV002 M02/M03 A3001",
+    "METAR LFPG 091700Z 18005KT CAVOK 15/09 Q1020 NOSIG"
+  };
+}
+
+BOOST_AUTO_TEST_SUITE(RecordCodecTests)
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+  for (auto report : reports)
+  {
+    auto r = Record::Create(*Metar::Create(report, 1704153600));
+
+    uint8_t buf[RecordCodec::ENCODED_SIZE];
+    RecordCodec::Encode(r, buf);
+
+    Record d;
+    BOOST_CHECK(RecordCodec::Decode(buf, d));
+    BOOST_CHECK(d == r);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(little_endian)
+{
+  auto r = Record::Create(*Metar::Create(reports[0], 1704153600));
+
+  uint8_t buf[RecordCodec::ENCODED_SIZE];
+  RecordCodec::Encode(r, buf);
+
+  // packed ICAO first, least significant byte first
+  BOOST_CHECK(buf[0] == 'L' && buf[1] == 'T' && buf[2] == 'S' && buf[3] == 'K');
+  // visibility at offset 16: 2 1/2 SM in sixteenths
+  BOOST_CHECK(buf[16] == 40 && buf[17] == 0);
+  // num_layers at offset 58
+  BOOST_CHECK(buf[58] == 2);
+}
+
+BOOST_AUTO_TEST_CASE(invalid)
+{
+  Record r{};
+  uint8_t buf[RecordCodec::ENCODED_SIZE];
+  RecordCodec::Encode(r, buf);
+  buf[58] = Record::MAX_LAYERS + 1;
+
+  BOOST_CHECK(!RecordCodec::Decode(buf, r));
+}
+
+BOOST_AUTO_TEST_CASE(file)
+{
+  std::vector<Record> records;
+  for (int i = 0 ; i < 10000 ; i++)
+  {
+    auto r = Record::Create(*Metar::Create(reports[i % 4], 1704153600));
+    r.obs_time += i;
+    records.push_back(r);
+  }
+
+  std::stringstream ss;
+  BOOST_CHECK(RecordCodec::Write(ss, records));
+  BOOST_CHECK(ss.str().size() == RecordCodec::FILE_HEADER_SIZE
+                                 + records.size() * RecordCodec::ENCODED_SIZE);
+
+  std::vector<Record> loaded;
+  BOOST_CHECK(RecordCodec::Read(ss, loaded));
+  BOOST_CHECK(loaded == records);
+
+  // truncated
+  std::string bytes = ss.str();
+  std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+  loaded.clear();
+  BOOST_CHECK(!RecordCodec::Read(truncated, loaded));
+  BOOST_CHECK(loaded.size() == 8192);
+
+  // not a record file
+  std::stringstream text("METAR KSTL 091651Z 10010KT");
+  BOOST_CHECK(!RecordCodec::Read(text, loaded));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Record difference tests
+//
+
+#include "RecordDiff.h"
+#include "TestRecords.h"
+
+#include <cstring>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+using TestRecords::decode;
+
+BOOST_AUTO_TEST_SUITE(RecordDiffTests)
+
+BOOST_AUTO_TEST_CASE(diff)
+{
+  Record a = decode("METAR KSTL 121651Z 31008KT 10SM FEW050 23/14 A3002");
+  Record b = decode("METAR KSTL 121751Z 31008G18KT 10SM -RA FEW050 BKN080 "
+                    "22/14 A3002");
+
+  BOOST_CHECK(RecordDiff::Diff(a, a) == 0);
+
+  uint32_t changed = RecordDiff::Diff(a, b);
+  BOOST_CHECK(changed == (Record::TIME | Record::OBSERVATION_TIME
+                        | Record::WIND_GUST | Record::TEMPERATURE
+                        | Record::CEILING | RecordDiff::LAYERS | RecordDiff::PHENOMENA));
+
+  // a disappearing field has changed as well
+  BOOST_CHECK(RecordDiff::Diff(b, a) == changed);
+
+  Record c = a;
+  RecordDiff::Apply(c, b, changed);
+  BOOST_CHECK(c == b);
+
+  // only the requested fields are copied
+  Record d = a;
+  RecordDiff::Apply(d, b, Record::WIND_GUST);
+  BOOST_CHECK(d.Has(Record::WIND_GUST));
+  BOOST_CHECK(d.wind_gust == 18);
+  BOOST_CHECK(d.temperature == 23);
+  BOOST_CHECK(d.num_layers == 1);
+
+  Record empty;
+  memset(&empty, 0, sizeof(empty));
+  uint32_t all = RecordDiff::Diff(empty, a);
+  BOOST_CHECK(all == (a.present | RecordDiff::LAYERS));
+  RecordDiff::Apply(empty, a, all);
+  BOOST_CHECK(empty == a);
+}
+
+BOOST_AUTO_TEST_CASE(flags)
+{
+  Record a = decode("METAR EGLL 121650Z 24012KT 9999 BKN014 12/09 Q1008");
+  Record b = decode("METAR EGLL 121650Z 24012KT CAVOK 12/09 Q1008");
+
+  uint32_t changed = RecordDiff::Diff(a, b);
+  BOOST_CHECK(changed & RecordDiff::FLAGS);
+  BOOST_CHECK(changed & RecordDiff::LAYERS);
+  BOOST_CHECK(!(changed & Record::TEMPERATURE));
+
+  RecordDiff::Apply(a, b, changed);
+  BOOST_CHECK(a == b);
+}
+
+BOOST_AUTO_TEST_CASE(tracker)
+{
+  ChangeTracker tracker(16);
+  RecordDiff::Delta delta;
+
+  Record a = decode("METAR KSTL 121651Z 31008KT 10SM FEW050 23/14 A3002");
+  Record b = decode("METAR KSTL 121751Z 31008KT 10SM FEW050 24/14 A3002");
+
+  BOOST_CHECK(tracker.Update(a, delta));
+  BOOST_CHECK(delta.icao == a.icao);
+  BOOST_CHECK(delta.changed == (a.present | RecordDiff::LAYERS));
+
+  // repeats and late reports produce nothing
+  BOOST_CHECK(!tracker.Update(a, delta));
+
+  BOOST_CHECK(tracker.Update(b, delta));
+  BOOST_CHECK(delta.changed == (Record::TIME | Record::OBSERVATION_TIME
+                              | Record::TEMPERATURE));
+  BOOST_CHECK(delta.values.temperature == 24);
+
+  BOOST_CHECK(!tracker.Update(a, delta));
+  BOOST_CHECK(*tracker.Get(a.icao) == b);
+
+  // a client applying the deltas stays in step
+  Record client;
+  memset(&client, 0, sizeof(client));
+  ChangeTracker replay;
+  for (const Record& r : { a, b })
+  {
+    if (replay.Update(r, delta))
+      RecordDiff::Apply(client, delta.values, delta.changed);
+  }
+  BOOST_CHECK(client == b);
+
+  BOOST_CHECK(tracker.Update(decode("METAR KORD 121651Z 27012KT 10SM 20/10 "
+                                    "A3001"), delta));
+  BOOST_CHECK(tracker.Size() == 2);
+  BOOST_CHECK(tracker.Get(Record::PackICAO("KJFK")) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Station and time index tests
+//
+
+#include "RecordIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  const char *stations[] = { "KSTL", "KJFK", "EGLL", "LFPG", "RJTT", "KORD" };
+
+  Record make(const char *icao, int64_t t)
+  {
+    Record r;
+    memset(&r, 0, sizeof(r));
+    r.icao = Record::PackICAO(icao);
+    r.obs_time = t;
+    r.present = Record::ICAO | Record::OBSERVATION_TIME;
+    return r;
+  }
+
+  // hourly reports of every station over 30 days, shuffled
+  std::vector<Record> make_records()
+  {
+    std::vector<Record> records;
+    for (int64_t h = 0 ; h < 24 * 30 ; h++)
+    {
+      for (auto s : stations) records.push_back(make(s, 1704067200 + h * 3600));
+    }
+    std::shuffle(records.begin(), records.end(), std::mt19937(42));
+    return records;
+  }
+
+  // the expected result, by scanning
+  std::vector<uint64_t> scan(const std::vector<Record>& records, uint32_t icao,
+                             int64_t from, int64_t to)
+  {
+    std::vector<std::pair<std::pair<uint32_t, int64_t>, uint64_t>> found;
+    for (size_t i = 0 ; i < records.size() ; i++)
+    {
+      const Record& r = records[i];
+      if ((icao == 0 || r.icao == icao) && r.obs_time >= from
+          && r.obs_time <= to && r.Has(Record::OBSERVATION_TIME))
+      {
+        found.push_back({ { r.icao, r.obs_time }, i });
+      }
+    }
+    std::stable_sort(found.begin(), found.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<uint64_t> positions;
+    for (const auto& f : found) positions.push_back(f.second);
+    return positions;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(RecordIndexTests)
+
+BOOST_AUTO_TEST_CASE(find)
+{
+  auto records = make_records();
+  records.push_back(make("KJFK", 1704067200 + 3600));  // duplicate key
+  records.push_back(make("KJFK", 0));
+  records.back().present = Record::ICAO;               // not indexed
+
+  RecordIndex index(records);
+  BOOST_CHECK(index.Size() == records.size() - 1);
+
+  const uint32_t kjfk = Record::PackICAO("KJFK");
+  const int64_t end = 1704067200 + 24 * 30 * 3600;
+
+  // KJFK, last 72 hours
+  std::vector<uint64_t> positions;
+  index.Find(kjfk, end - 72 * 3600, end, positions);
+  BOOST_CHECK(positions.size() == 72);
+  BOOST_CHECK(positions == scan(records, kjfk, end - 72 * 3600, end));
+
+  // duplicate keys are both found, in file order
+  positions.clear();
+  index.Find(kjfk, 1704067200 + 3600, 1704067200 + 3600, positions);
+  BOOST_CHECK(positions.size() == 2);
+  BOOST_CHECK(positions.back() == records.size() - 2);
+
+  // all stations at one time
+  int64_t t = 1704067200 + 4 * 24 * 3600 + 12 * 3600;
+  positions.clear();
+  index.Find(t, t, positions);
+  BOOST_CHECK(positions.size() == 6);
+  BOOST_CHECK(positions == scan(records, 0, t, t));
+
+  // all stations over a range
+  positions.clear();
+  index.Find(t - 7200, t + 7200, positions);
+  BOOST_CHECK(positions == scan(records, 0, t - 7200, t + 7200));
+
+  positions.clear();
+  index.Find(Record::PackICAO("KSFO"), 0, end, positions);
+  index.Find(kjfk, end + 1, end + 100000, positions);
+  index.Find(end + 1, end + 100000, positions);
+  BOOST_CHECK(positions.empty());
+}
+
+BOOST_AUTO_TEST_CASE(serialize)
+{
+  auto records = make_records();
+  RecordIndex index(records);
+
+  std::stringstream ss;
+  BOOST_CHECK(index.Write(ss));
+
+  auto loaded = RecordIndex::Create(ss);
+  BOOST_REQUIRE(loaded);
+  BOOST_CHECK(loaded->Size() == index.Size());
+
+  std::vector<uint64_t> a, b;
+  index.Find(1704067200 + 86400, 1704067200 + 2 * 86400, a);
+  loaded->Find(1704067200 + 86400, 1704067200 + 2 * 86400, b);
+  BOOST_CHECK(a.size() == 6 * 25);
+  BOOST_CHECK(a == b);
+
+  std::string bytes = ss.str();
+  std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+  BOOST_CHECK(!RecordIndex::Create(truncated));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Flat record tests
+//
+
+#include "Record.h"
+#include "Metar.h"
+#include "Clouds.h"
+#include "Phenom.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+BOOST_AUTO_TEST_SUITE(RecordTests)
+
+BOOST_AUTO_TEST_CASE(pack_icao)
+{
+  BOOST_CHECK(Record::UnpackICAO(Record::PackICAO("KSTL")) == "KSTL");
+  BOOST_CHECK(Record::PackICAO("KSTL") != Record::PackICAO("KSTE"));
+  BOOST_CHECK(Record::PackICAO("") == 0);
+  BOOST_CHECK(Record::PackICAO("KJFK") < Record::PackICAO("KSTL"));
+}
+
+BOOST_AUTO_TEST_CASE(create)
+{
+  auto metar = Metar::Create("METAR KSTL 091651Z 10010G18KT 060V120 2 1/2SM -TSRA BR FEW012 OVC050CB 07/M06 A2998 RMK SLP160 T00671056", 1704153600);
+  auto r = Record::Create(*metar);
+
+  BOOST_CHECK(Record::UnpackICAO(r.icao) == "KSTL");
+  BOOST_CHECK(r.Has(Record::MESSAGE_TYPE));
+  BOOST_CHECK(r.message_type == static_cast<uint8_t>(Metar::message_type::METAR));
+  BOOST_CHECK(r.Has(Record::OBSERVATION_TIME));
+  BOOST_CHECK(r.obs_time == *metar->ObservationTime());
+  BOOST_CHECK(r.day == 9 && r.hour == 16 && r.minute == 51);
+
+  BOOST_CHECK(r.wind_dir == 100);
+  BOOST_CHECK(r.wind_speed == 10);
+  BOOST_CHECK(r.wind_gust == 18);
+  BOOST_CHECK(r.Has(Record::WIND_RANGE));
+  BOOST_CHECK(r.min_wind_dir == 60 && r.max_wind_dir == 120);
+
+  BOOST_CHECK(r.visibility == 40);
+  BOOST_CHECK(r.vis_units == static_cast<uint8_t>(Metar::distance_units::SM));
+  BOOST_CHECK(r.ceiling == 5000);
+  BOOST_CHECK(r.flight_category ==
+              static_cast<uint8_t>(Metar::flight_category::IFR));
+
+  BOOST_CHECK(r.temperature == 7 && r.dew_point == -6);
+  BOOST_CHECK(r.temperature_na == 67 && r.dew_point_na == -56);
+  BOOST_CHECK(r.altimeter_a == 2998);
+  BOOST_CHECK(!r.Has(Record::ALTIMETER_Q));
+  BOOST_CHECK(r.sea_level_press == 10160);
+
+  BOOST_CHECK(r.num_layers == 2);
+  BOOST_CHECK(r.layers[1].cover == static_cast<uint8_t>(Clouds::cover::OVC));
+  BOOST_CHECK(r.layers[1].altitude == 50);
+  BOOST_CHECK(r.layers[1].type == static_cast<uint8_t>(Clouds::type::CB));
+  BOOST_CHECK(r.layers[0].type == Record::NONE8);
+
+  BOOST_CHECK(r.num_phenomena == 2);
+  BOOST_CHECK(r.phenomena[0].intensity ==
+              static_cast<int8_t>(Phenom::intensity::LIGHT));
+  BOOST_CHECK(r.phenomena[0].attributes & Record::Phenomenon::THUNDERSTORM);
+  BOOST_CHECK(r.phenomena[0].phenom[0] ==
+              static_cast<uint8_t>(Phenom::phenom::RAIN));
+  BOOST_CHECK(r.phenomena[1].phenom[0] ==
+              static_cast<uint8_t>(Phenom::phenom::MIST));
+
+  BOOST_CHECK(r == Record::Create(*metar));
+}
+
+BOOST_AUTO_TEST_CASE(create_empty)
+{
+  auto r = Record::Create(*Metar::Create(""));
+
+  BOOST_CHECK(r.present == 0);
+  BOOST_CHECK(r.icao == 0);
+  BOOST_CHECK(r.num_layers == 0);
+  BOOST_CHECK(r.num_phenomena == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
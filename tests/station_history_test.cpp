@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Station history tests
+//
+
+#include "StationHistory.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+
+namespace
+{
+  Record make(const char *icao, int64_t t)
+  {
+    Record r;
+    memset(&r, 0, sizeof(r));
+    r.icao = Record::PackICAO(icao);
+    r.obs_time = t;
+    r.present = Record::ICAO | Record::OBSERVATION_TIME;
+    // derived fields let readers detect torn copies
+    r.visibility = static_cast<int32_t>(t * 3);
+    r.ceiling = static_cast<int32_t>(t * 7);
+    return r;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(StationHistoryTests)
+
+BOOST_AUTO_TEST_CASE(append_and_snapshot)
+{
+  StationHistory history(4, 3);
+  std::vector<Record> out;
+
+  BOOST_CHECK(!history.Latest(Record::PackICAO("KSTL")).has_value());
+  BOOST_CHECK(history.Snapshot(Record::PackICAO("KSTL"), out) == 0);
+
+  for (int t = 1 ; t <= 5 ; t++)
+  {
+    BOOST_CHECK(history.Append(make("KSTL", t)));
+  }
+  BOOST_CHECK(history.Append(make("KJFK", 100)));
+
+  BOOST_CHECK(history.NumStations() == 2);
+
+  BOOST_CHECK(history.Snapshot(Record::PackICAO("KSTL"), out) == 3);
+  BOOST_CHECK(out[0].obs_time == 3);
+  BOOST_CHECK(out[1].obs_time == 4);
+  BOOST_CHECK(out[2].obs_time == 5);
+
+  BOOST_CHECK(history.Latest(Record::PackICAO("KSTL"))->obs_time == 5);
+  BOOST_CHECK(history.Latest(Record::PackICAO("KJFK"))->obs_time == 100);
+}
+
+BOOST_AUTO_TEST_CASE(station_limit)
+{
+  StationHistory history(2, 2);
+
+  BOOST_CHECK(history.Append(make("KSTL", 1)));
+  BOOST_CHECK(history.Append(make("KJFK", 1)));
+  BOOST_CHECK(!history.Append(make("KBOS", 1)));
+  BOOST_CHECK(history.Append(make("KSTL", 2)));
+
+  Record none;
+  memset(&none, 0, sizeof(none));
+  BOOST_CHECK(!history.Append(none));
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_readers)
+{
+  const char *stations[] = { "KSTL", "KJFK", "KBOS", "KORD" };
+  const int64_t N = 20000;
+
+  StationHistory history(8, 16);
+  std::atomic<bool> done(false);
+  std::atomic<int> errors(0);
+
+  std::vector<std::thread> readers;
+  for (int k = 0 ; k < 4 ; k++)
+  {
+    readers.emplace_back([&, k]
+    {
+      std::vector<Record> out;
+      uint32_t icao = Record::PackICAO(stations[k % 4]);
+      while (!done.load())
+      {
+        history.Snapshot(icao, out);
+        for (size_t i = 0 ; i < out.size() ; i++)
+        {
+          const Record& r = out[i];
+          if (r.icao != icao || r.visibility != r.obs_time * 3
+              || r.ceiling != r.obs_time * 7
+              || (i > 0 && r.obs_time != out[i - 1].obs_time + 1))
+          {
+            errors++;
+          }
+        }
+      }
+    });
+  }
+
+  for (int64_t t = 1 ; t <= N ; t++)
+  {
+    for (auto s : stations) history.Append(make(s, t));
+  }
+  done = true;
+
+  for (auto& t : readers) t.join();
+
+  BOOST_CHECK(errors == 0);
+  BOOST_CHECK(history.Latest(Record::PackICAO("KORD"))->obs_time == N);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,10 @@
 
 #include "Utils.h"
 
+#include <vector>
+
+#include <cmath>
+
 #include <boost/test/unit_test.hpp>
 
 using namespace Storage_B::Weather;
@@ -22,6 +26,22 @@ BOOST_AUTO_TEST_CASE(humidity_50, * boost::unit_test::tolerance(0.0001))
   BOOST_TEST(Utils::Humidity(20.0, 9.261352) == 50.0);
 }
 
+BOOST_AUTO_TEST_CASE(humidity_tenths)
+{
+  for (int t = -80 ; t <= 70 ; t++)
+  {
+    for (int td = t - 30 ; td <= t + 2 ; td++)
+    {
+      BOOST_TEST(Utils::HumidityTenths(t * 10, td * 10)
+                  == Utils::Humidity(t, td));
+    }
+  }
+
+  BOOST_TEST(Utils::HumidityTenths(222, 178) == Utils::Humidity(22.2, 17.8));
+  BOOST_TEST(Utils::HumidityTenths(-17, -56) == Utils::Humidity(-1.7, -5.6));
+  BOOST_TEST(Utils::HumidityTenths(200, 200) == 100.0);
+}
+
 BOOST_AUTO_TEST_CASE(wind_chill_none)
 {
   BOOST_TEST(Utils::WindChill(5.0, 4.8) == 5.0);
@@ -53,4 +73,85 @@ BOOST_AUTO_TEST_CASE(heat_index, * boost::unit_test::tolerance(0.05))
   BOOST_TEST(Utils::HeatIndex(30.0, 75.0) == 36.0);
 }
 
+BOOST_AUTO_TEST_CASE(humidity_batch)
+{
+  std::vector<double> t;
+  std::vector<double> td;
+  for (double a = -80.0 ; a <= 60.0 ; a += 0.7)
+  {
+    for (double b = a - 40.0 ; b <= a ; b += 1.3)
+    {
+      t.push_back(a);
+      td.push_back(b);
+    }
+  }
+
+  std::vector<double> out(t.size());
+  Utils::Humidity(t, td, out);
+
+  double max_err = 0.0;
+  for (size_t i = 0 ; i < t.size() ; i++)
+  {
+    max_err = std::fmax(max_err, fabs(out[i] - Utils::Humidity(t[i], td[i])));
+  }
+  BOOST_TEST(max_err < 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(wind_chill_batch)
+{
+  std::vector<double> temp;
+  std::vector<double> wind;
+  for (double a = -60.0 ; a <= 20.0 ; a += 0.9)
+  {
+    for (double w = 0.0 ; w <= 500.0 ; w += 3.7)
+    {
+      temp.push_back(a);
+      wind.push_back(w);
+    }
+  }
+
+  std::vector<double> out(temp.size());
+  Utils::WindChill(temp, wind, out);
+
+  double max_err = 0.0;
+  for (size_t i = 0 ; i < temp.size() ; i++)
+  {
+    max_err = std::fmax(max_err,
+                        fabs(out[i] - Utils::WindChill(temp[i], wind[i])));
+  }
+  BOOST_TEST(max_err < 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(heat_index_batch)
+{
+  std::vector<double> temp;
+  std::vector<double> hum;
+  for (double a = 60.0 ; a <= 130.0 ; a += 0.5)
+  {
+    for (double h = 0.0 ; h <= 100.0 ; h += 2.5)
+    {
+      temp.push_back(a);
+      hum.push_back(h);
+    }
+  }
+
+  std::vector<double> out(temp.size());
+  Utils::HeatIndex(temp, hum, out, false);
+
+  double max_err = 0.0;
+  for (size_t i = 0 ; i < temp.size() ; i++)
+  {
+    max_err = std::fmax(max_err,
+                fabs(out[i] - Utils::HeatIndex(temp[i], hum[i], false)));
+  }
+  BOOST_TEST(max_err < 1e-9);
+
+  std::vector<double> celsius = { 30.0, 20.0 };
+  std::vector<double> rh = { 75.0, 50.0 };
+  std::vector<double> hi(2);
+  Utils::HeatIndex(celsius, rh, hi);
+  BOOST_TEST(fabs(hi[0] - Utils::HeatIndex(30.0, 75.0)) < 1e-9);
+  BOOST_TEST(hi[1] == 20.0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
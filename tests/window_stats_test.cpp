@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2020 James A. Chappell
+//
+// Sliding window statistics tests
+//
+
+#include "WindowStats.h"
+#include "Metar.h"
+#include "TestRecords.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Storage_B::Weather;
+using TestRecords::decode;
+
+BOOST_AUTO_TEST_SUITE(WindowStatsTests)
+
+BOOST_AUTO_TEST_CASE(sliding_window)
+{
+  const int64_t LENGTH = 1000;
+  SlidingWindow w(LENGTH);
+
+  std::mt19937 rng(42);
+  std::vector<std::pair<int64_t, int64_t>> all;
+  int64_t t = 0;
+
+  for (int i = 0 ; i < 5000 ; i++)
+  {
+    t += rng() % 120;
+    int64_t v = static_cast<int64_t>(rng() % 2001) - 1000;
+    w.Add(t, v);
+    all.push_back({ t, v });
+
+    // brute force over the samples still in the window
+    int64_t lo = INT64_MAX, hi = INT64_MIN, sum = 0;
+    size_t n = 0, first = all.size();
+    for (size_t j = all.size() ; j-- > 0 && all[j].first >= t - LENGTH ; )
+    {
+      lo = std::min(lo, all[j].second);
+      hi = std::max(hi, all[j].second);
+      sum += all[j].second;
+      n++;
+      first = j;
+    }
+
+    BOOST_REQUIRE(w.Count() == n);
+    BOOST_REQUIRE(w.Min() == lo);
+    BOOST_REQUIRE(w.Max() == hi);
+    BOOST_REQUIRE(w.Sum() == sum);
+    BOOST_REQUIRE(w.First() == all[first].second);
+    BOOST_REQUIRE(w.FirstTime() == all[first].first);
+    BOOST_REQUIRE(w.Last() == v);
+  }
+
+  w.Advance(t + LENGTH + 1);
+  BOOST_CHECK(w.Count() == 0);
+  BOOST_CHECK(w.Sum() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(station_windows)
+{
+  StationWindows windows;
+  const uint32_t kstl = Record::PackICAO("KSTL");
+
+  BOOST_CHECK(!windows.Get(kstl).has_value());
+
+  // hourly reports from 12/00 to 12/17, falling pressure and a gust at 16Z
+  for (int h = 0 ; h < 18 ; h++)
+  {
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+             "METAR KSTL 12%02d51Z 31008%sKT 10SM FEW050 %02d/10 A30%02d",
+             h, h == 16 ? "G25" : "", 10 + h / 2, 30 - h);
+    BOOST_REQUIRE(windows.Update(decode(buf)));
+  }
+
+  auto s = windows.Get(kstl);
+  BOOST_REQUIRE(s.has_value());
+
+  // 30.15 - 30.12 inHg over 14Z..17Z
+  BOOST_REQUIRE(s->pressure_tendency.has_value());
+  BOOST_CHECK_CLOSE(*s->pressure_tendency, -1.0, 5.0);
+
+  BOOST_REQUIRE(s->max_gust.has_value());
+  BOOST_CHECK(*s->max_gust == 25);
+
+  BOOST_CHECK(*s->min_temperature == 10);
+  BOOST_CHECK(*s->max_temperature == 18);
+  BOOST_CHECK_CLOSE(*s->mean_temperature, 14.0, 1e-9);
+
+  // the gust leaves the window, and a late report is ignored
+  BOOST_CHECK(windows.Update(decode("METAR KSTL 121751Z 31008KT 10SM "
+                                    "18/10 A3011 RMK T01830100")) == false);
+  BOOST_CHECK(windows.Update(decode("METAR KSTL 121851Z 31008KT 10SM "
+                                    "18/10 A3011 RMK T01830100")));
+  s = windows.Get(kstl);
+  BOOST_CHECK(!s->max_gust.has_value());
+  BOOST_CHECK(*s->max_temperature == 18.3);
+
+  // gusts are normalized to knots
+  BOOST_CHECK(windows.Update(decode("METAR EFHK 121650Z 27010G15MPS 9999 "
+                                    "M05/M09 Q1001")));
+  s = windows.Get(Record::PackICAO("EFHK"));
+  BOOST_CHECK_CLOSE(*s->max_gust, 29.2, 0.5);
+  BOOST_CHECK(!s->pressure_tendency.has_value());
+
+  // reports without an observation time cannot be placed in the window
+  BOOST_CHECK(!windows.Update(Record::Create(*Metar::Create(
+    "METAR KORD 121651Z 27012KT 10SM 20/10 A3001"))));
+  BOOST_CHECK(windows.Size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(pressure_source)
+{
+  StationWindows windows;
+  const uint32_t kden = Record::PackICAO("KDEN");
+
+  // a high station, where the sea-level pressure is far from the altimeter
+  // setting
+  for (int h = 8 ; h < 12 ; h++)
+  {
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+             "METAR KDEN 12%02d53Z 31008KT 10SM FEW050 10/M02 A3010 "
+             "RMK SLP1%02d", h, 60 + h);
+    BOOST_REQUIRE(windows.Update(decode(buf)));
+  }
+  BOOST_CHECK_SMALL(*windows.Get(kden)->pressure_tendency, 0.05);
+
+  // the altimeter setting is missing; the tendency must not compare the
+  // sea-level pressure with the earlier altimeter settings
+  BOOST_REQUIRE(windows.Update(decode("METAR KDEN 121253Z 31008KT 10SM "
+                                      "FEW050 10/M02 RMK SLP172")));
+  BOOST_CHECK(!windows.Get(kden)->pressure_tendency.has_value());
+
+  // the station stays with the sea-level pressure while it is reported
+  for (int h = 13 ; h < 16 ; h++)
+  {
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+             "METAR KDEN 12%02d53Z 31008KT 10SM FEW050 10/M02 A3010 "
+             "RMK SLP1%02d", h, 60 + h);
+    BOOST_REQUIRE(windows.Update(decode(buf)));
+  }
+  auto s = windows.Get(kden);
+  BOOST_REQUIRE(s->pressure_tendency.has_value());
+  BOOST_CHECK_CLOSE(*s->pressure_tendency, 0.3, 1.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()